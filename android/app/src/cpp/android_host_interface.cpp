@@ -207,10 +207,15 @@ void AndroidHostInterface::EmulationThreadEntryPoint(ANativeWindow* initial_surf
     m_callback_mutex.unlock();
 
     // simulate the system if not paused
+    bool frame_skipped = false;
     if (m_system && !m_paused)
-      m_system->RunFrame();
+    {
+      RunFrame();
+      frame_skipped = IsFrameSkipped();
+    }
 
-    // rendering
+    // rendering, dropped frames go straight to the throttle
+    if (!frame_skipped)
     {
       DrawImGui();
 
@@ -223,15 +228,13 @@ void AndroidHostInterface::EmulationThreadEntryPoint(ANativeWindow* initial_surf
       ImGui::NewFrame();
 
       if (m_system)
-      {
         m_system->GetGPU()->RestoreGraphicsAPIState();
+    }
 
-        if (m_speed_limiter_enabled)
-          Throttle();
-      }
+    if (m_system && m_speed_limiter_enabled)
+      Throttle();
 
-      UpdatePerformanceCounters();
-    }
+    UpdatePerformanceCounters();
   }
 
   m_display.reset();
@@ -1,7 +1,10 @@
 #include "audio_stream.h"
 #include "assert.h"
+#include "log.h"
+#include "trace.h"
 #include <algorithm>
 #include <cstring>
+Log_SetChannel(AudioStream);
 
 AudioStream::AudioStream() = default;
 
@@ -137,6 +140,16 @@ u32 AudioStream::GetSamplesAvailable() const
 
 u32 AudioStream::ReadSamples(SampleType* samples, u32 num_samples)
 {
+  // Only called from the backend's callback thread. The name is kept across recordings, so it only needs setting once.
+  static thread_local bool thread_named = false;
+  if (!thread_named && Trace::IsRecording())
+  {
+    Trace::SetThreadName("Audio Callback");
+    thread_named = true;
+  }
+
+  TRACE_SCOPE("ReadSamples");
+
   u32 remaining_samples = num_samples;
   std::unique_lock<std::mutex> lock(m_buffer_mutex);
 
@@ -191,6 +204,7 @@ void AudioStream::EnsureBuffer()
 
   if (m_sync)
   {
+    TRACE_SCOPE("WaitForBuffer");
     std::unique_lock<std::mutex> lock(m_buffer_mutex, std::adopt_lock);
     m_buffer_available_cv.wait(lock, [this]() { return m_num_free_buffers > 0; });
     lock.release();
@@ -695,6 +695,23 @@ GrowableMemoryByteStream::~GrowableMemoryByteStream()
     std::free(m_pPrivateMemory);
 }
 
+void GrowableMemoryByteStream::Resize(u32 NewSize)
+{
+  if (NewSize > m_iMemorySize)
+    ResizeMemory(NewSize);
+
+  m_iSize = NewSize;
+  m_iPosition = std::min(m_iPosition, m_iSize);
+}
+
+void GrowableMemoryByteStream::ResizeMemory(u32 NewMemorySize)
+{
+  if (NewMemorySize <= m_iMemorySize)
+    return;
+
+  Grow(NewMemorySize - m_iMemorySize);
+}
+
 bool GrowableMemoryByteStream::ReadByte(u8* pDestByte)
 {
   if (m_iPosition < m_iSize)
@@ -169,6 +169,13 @@ public:
 
   u8* GetMemoryPointer() const { return m_pMemory; }
   u32 GetMemorySize() const { return m_iSize; }
+  u32 GetMemoryCapacity() const { return m_iMemorySize; }
+
+  // changes the logical size of the stream, keeping the allocated memory. the position is clamped to the new size.
+  void Resize(u32 NewSize);
+
+  // ensures at least this many bytes are allocated, without changing the logical size.
+  void ResizeMemory(u32 NewMemorySize);
 
   virtual bool ReadByte(u8* pDestByte) override;
   virtual u32 Read(void* pDestination, u32 ByteCount) override;
@@ -1435,6 +1435,7 @@ std::string GetWorkingDirectory()
     buffer.resize(buffer.size() * 2);
   }
 
+  buffer.resize(std::strlen(buffer.c_str()));
   return buffer;
 }
 
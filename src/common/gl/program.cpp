@@ -18,7 +18,7 @@ Program::~Program()
   Destroy();
 }
 
-GLuint Program::CompileShader(GLenum type, const std::string_view source)
+static GLuint StartCompileShader(GLenum type, const std::string_view source)
 {
   GLuint id = glCreateShader(type);
 
@@ -26,6 +26,12 @@ GLuint Program::CompileShader(GLenum type, const std::string_view source)
   std::array<GLint, 1> source_lengths = {{static_cast<GLint>(source.size())}};
   glShaderSource(id, static_cast<GLsizei>(sources.size()), sources.data(), source_lengths.data());
   glCompileShader(id);
+  return id;
+}
+
+GLuint Program::CompileShader(GLenum type, const std::string_view source)
+{
+  GLuint id = StartCompileShader(type, source);
 
   GLint status = GL_FALSE;
   glGetShaderiv(id, GL_COMPILE_STATUS, &status);
@@ -51,7 +57,7 @@ GLuint Program::CompileShader(GLenum type, const std::string_view source)
                         std::ofstream::out | std::ofstream::binary);
       if (ofs.is_open())
       {
-        ofs.write(sources[0], source_lengths[0]);
+        ofs.write(source.data(), source.size());
         ofs << "\n\nCompile failed, info log:\n";
         ofs << info_log;
         ofs.close();
@@ -111,10 +117,39 @@ void Program::BindFragDataIndexed(GLuint color_number /*= 0*/, const char* name
   glBindFragDataLocationIndexed(m_program_id, color_number, 0, name);
 }
 
-bool Program::Link()
+void Program::StartCompile(const std::string_view vertex_shader, const std::string_view fragment_shader)
+{
+  m_vertex_shader_id = StartCompileShader(GL_VERTEX_SHADER, vertex_shader);
+  m_fragment_shader_id = StartCompileShader(GL_FRAGMENT_SHADER, fragment_shader);
+
+  m_program_id = glCreateProgram();
+  glAttachShader(m_program_id, m_vertex_shader_id);
+  glAttachShader(m_program_id, m_fragment_shader_id);
+}
+
+void Program::StartLink()
 {
   glLinkProgram(m_program_id);
+}
 
+bool Program::IsLinkComplete() const
+{
+  if (!GLAD_GL_KHR_parallel_shader_compile && !GLAD_GL_ARB_parallel_shader_compile)
+    return true;
+
+  GLint status = GL_FALSE;
+  glGetProgramiv(m_program_id, GL_COMPLETION_STATUS_KHR, &status);
+  return (status == GL_TRUE);
+}
+
+bool Program::Link()
+{
+  StartLink();
+  return FinishLink();
+}
+
+bool Program::FinishLink()
+{
   glDeleteShader(m_vertex_shader_id);
   m_vertex_shader_id = 0;
   glDeleteShader(m_fragment_shader_id);
@@ -148,6 +183,51 @@ bool Program::Link()
   return true;
 }
 
+void Program::SetBinaryRetrievableHint()
+{
+  glProgramParameteri(m_program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool Program::GetBinary(std::vector<u8>* out_data, u32* out_data_format)
+{
+  GLint binary_length = 0;
+  glGetProgramiv(m_program_id, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+  if (binary_length <= 0)
+    return false;
+
+  GLenum binary_format = 0;
+  out_data->resize(static_cast<size_t>(binary_length));
+  glGetProgramBinary(m_program_id, binary_length, &binary_length, &binary_format, out_data->data());
+  if (binary_length <= 0)
+  {
+    out_data->clear();
+    return false;
+  }
+
+  out_data->resize(static_cast<size_t>(binary_length));
+  *out_data_format = binary_format;
+  return true;
+}
+
+bool Program::CreateFromBinary(const void* data, u32 data_length, u32 data_format)
+{
+  m_program_id = glCreateProgram();
+  glProgramBinary(m_program_id, static_cast<GLenum>(data_format), data, static_cast<GLsizei>(data_length));
+
+  GLint status = GL_FALSE;
+  glGetProgramiv(m_program_id, GL_LINK_STATUS, &status);
+  if (status == GL_FALSE)
+  {
+    // Not an error, the binary is invalidated by driver updates.
+    Log_WarningPrintf("Program binary was rejected by the driver");
+    glDeleteProgram(m_program_id);
+    m_program_id = 0;
+    return false;
+  }
+
+  return true;
+}
+
 void Program::Bind() const
 {
   if (s_last_program_id == m_program_id)
@@ -174,6 +254,8 @@ void Program::Destroy()
     glDeleteProgram(m_program_id);
     m_program_id = 0;
   }
+
+  m_uniform_locations.clear();
 }
 
 int Program::RegisterUniform(const char* name)
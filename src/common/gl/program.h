@@ -27,6 +27,25 @@ public:
 
   bool Link();
 
+  /// Compiles and links without waiting for the driver, for drivers which compile on other threads. Compile errors
+  /// are only reported by FinishLink(), and attributes must be bound between StartCompile() and StartLink().
+  void StartCompile(const std::string_view vertex_shader, const std::string_view fragment_shader);
+  void StartLink();
+
+  /// Returns true when FinishLink() won't block. Always true if the driver can't tell.
+  bool IsLinkComplete() const;
+
+  bool FinishLink();
+
+  /// Asks the driver to keep the linked binary around for GetBinary(). Must be called before Link().
+  void SetBinaryRetrievableHint();
+
+  /// Retrieves the linked program binary and its driver-specific format.
+  bool GetBinary(std::vector<u8>* out_data, u32* out_data_format);
+
+  /// Creates the program from a binary returned by GetBinary(). Fails if the driver no longer accepts it.
+  bool CreateFromBinary(const void* data, u32 data_length, u32 data_format);
+
   void Bind() const;
 
   void Destroy();
@@ -0,0 +1,345 @@
+#include "shader_cache.h"
+#include "../file_system.h"
+#include "../log.h"
+#include "../md5_digest.h"
+#include <cstring>
+Log_SetChannel(GL::ShaderCache);
+
+namespace GL {
+
+#pragma pack(push, 1)
+struct CacheIndexHeader
+{
+  u32 file_version;
+  u64 driver_hash_low;
+  u64 driver_hash_high;
+};
+
+struct CacheIndexEntry
+{
+  u64 vertex_source_hash_low;
+  u64 vertex_source_hash_high;
+  u32 vertex_source_length;
+  u64 fragment_source_hash_low;
+  u64 fragment_source_hash_high;
+  u32 fragment_source_length;
+  u32 file_offset;
+  u32 blob_size;
+  u32 blob_format;
+};
+#pragma pack(pop)
+
+ShaderCache::ShaderCache() = default;
+
+ShaderCache::~ShaderCache()
+{
+  Close();
+}
+
+bool ShaderCache::CacheIndexKey::operator==(const CacheIndexKey& key) const
+{
+  return (vertex_source_hash_low == key.vertex_source_hash_low &&
+          vertex_source_hash_high == key.vertex_source_hash_high &&
+          vertex_source_length == key.vertex_source_length &&
+          fragment_source_hash_low == key.fragment_source_hash_low &&
+          fragment_source_hash_high == key.fragment_source_hash_high &&
+          fragment_source_length == key.fragment_source_length);
+}
+
+bool ShaderCache::CacheIndexKey::operator!=(const CacheIndexKey& key) const
+{
+  return !(*this == key);
+}
+
+void ShaderCache::Open(bool is_gles, std::string_view base_path)
+{
+  Close();
+
+  if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary && !GLAD_GL_ES_VERSION_3_0)
+  {
+    Log_InfoPrintf("Program binaries are not supported, not caching programs");
+    return;
+  }
+
+  GLint num_formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+  if (num_formats == 0)
+  {
+    Log_InfoPrintf("Driver has no program binary formats, not caching programs");
+    return;
+  }
+
+  GetDriverHash(&m_driver_hash_low, &m_driver_hash_high);
+
+  std::string base_filename(base_path);
+  base_filename += FS_OSPATH_SEPERATOR_CHARACTER;
+  base_filename += is_gles ? "gles_programs" : "gl_programs";
+
+  const std::string index_filename = base_filename + ".idx";
+  const std::string blob_filename = base_filename + ".bin";
+
+  if (!ReadExisting(index_filename, blob_filename))
+    CreateNew(index_filename, blob_filename);
+}
+
+void ShaderCache::Close()
+{
+  m_index.clear();
+  if (m_index_file)
+  {
+    std::fclose(m_index_file);
+    m_index_file = nullptr;
+  }
+  if (m_blob_file)
+  {
+    std::fclose(m_blob_file);
+    m_blob_file = nullptr;
+  }
+}
+
+bool ShaderCache::CreateNew(const std::string& index_filename, const std::string& blob_filename)
+{
+  if (FileSystem::FileExists(index_filename.c_str()))
+  {
+    Log_WarningPrintf("Removing existing index file '%s'", index_filename.c_str());
+    FileSystem::DeleteFile(index_filename.c_str());
+  }
+  if (FileSystem::FileExists(blob_filename.c_str()))
+  {
+    Log_WarningPrintf("Removing existing blob file '%s'", blob_filename.c_str());
+    FileSystem::DeleteFile(blob_filename.c_str());
+  }
+
+  m_index_file = FileSystem::OpenCFile(index_filename.c_str(), "wb");
+  if (!m_index_file)
+  {
+    Log_ErrorPrintf("Failed to open index file '%s' for writing", index_filename.c_str());
+    return false;
+  }
+
+  const CacheIndexHeader header = {FILE_VERSION, m_driver_hash_low, m_driver_hash_high};
+  if (std::fwrite(&header, sizeof(header), 1, m_index_file) != 1 || std::fflush(m_index_file) != 0)
+  {
+    Log_ErrorPrintf("Failed to write header to index file '%s'", index_filename.c_str());
+    std::fclose(m_index_file);
+    m_index_file = nullptr;
+    FileSystem::DeleteFile(index_filename.c_str());
+    return false;
+  }
+
+  m_blob_file = FileSystem::OpenCFile(blob_filename.c_str(), "w+b");
+  if (!m_blob_file)
+  {
+    Log_ErrorPrintf("Failed to open blob file '%s' for writing", blob_filename.c_str());
+    std::fclose(m_index_file);
+    m_index_file = nullptr;
+    FileSystem::DeleteFile(index_filename.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool ShaderCache::ReadExisting(const std::string& index_filename, const std::string& blob_filename)
+{
+  m_index_file = FileSystem::OpenCFile(index_filename.c_str(), "r+b");
+  if (!m_index_file)
+    return false;
+
+  CacheIndexHeader header;
+  if (std::fread(&header, sizeof(header), 1, m_index_file) != 1 || header.file_version != FILE_VERSION)
+  {
+    Log_ErrorPrintf("Bad file version in '%s'", index_filename.c_str());
+    std::fclose(m_index_file);
+    m_index_file = nullptr;
+    return false;
+  }
+
+  if (header.driver_hash_low != m_driver_hash_low || header.driver_hash_high != m_driver_hash_high)
+  {
+    Log_InfoPrintf("Driver has changed, discarding '%s'", index_filename.c_str());
+    std::fclose(m_index_file);
+    m_index_file = nullptr;
+    return false;
+  }
+
+  m_blob_file = FileSystem::OpenCFile(blob_filename.c_str(), "a+b");
+  if (!m_blob_file)
+  {
+    Log_ErrorPrintf("Blob file '%s' is missing", blob_filename.c_str());
+    std::fclose(m_index_file);
+    m_index_file = nullptr;
+    return false;
+  }
+
+  std::fseek(m_blob_file, 0, SEEK_END);
+  const u32 blob_file_size = static_cast<u32>(std::ftell(m_blob_file));
+
+  for (;;)
+  {
+    CacheIndexEntry entry;
+    if (std::fread(&entry, sizeof(entry), 1, m_index_file) != 1 ||
+        (entry.file_offset + entry.blob_size) > blob_file_size)
+    {
+      if (std::feof(m_index_file))
+        break;
+
+      Log_ErrorPrintf("Failed to read entry from '%s', corrupt file?", index_filename.c_str());
+      Close();
+      return false;
+    }
+
+    const CacheIndexKey key{entry.vertex_source_hash_low,   entry.vertex_source_hash_high,
+                            entry.vertex_source_length,     entry.fragment_source_hash_low,
+                            entry.fragment_source_hash_high, entry.fragment_source_length};
+    const CacheIndexData data{entry.file_offset, entry.blob_size, entry.blob_format};
+    // Programs which are re-added after the driver rejected them replace the earlier entry.
+    m_index[key] = data;
+  }
+
+  Log_InfoPrintf("Read %zu entries from '%s'", m_index.size(), index_filename.c_str());
+  return true;
+}
+
+ShaderCache::CacheIndexKey ShaderCache::GetCacheKey(std::string_view vertex_shader, std::string_view fragment_shader)
+{
+  union ShaderHash
+  {
+    struct
+    {
+      u64 low;
+      u64 high;
+    };
+    u8 bytes[16];
+  };
+
+  ShaderHash vertex_hash = {};
+  MD5Digest vertex_digest;
+  vertex_digest.Update(vertex_shader.data(), static_cast<u32>(vertex_shader.length()));
+  vertex_digest.Final(vertex_hash.bytes);
+
+  ShaderHash fragment_hash = {};
+  MD5Digest fragment_digest;
+  fragment_digest.Update(fragment_shader.data(), static_cast<u32>(fragment_shader.length()));
+  fragment_digest.Final(fragment_hash.bytes);
+
+  return CacheIndexKey{vertex_hash.low,   vertex_hash.high,   static_cast<u32>(vertex_shader.length()),
+                       fragment_hash.low, fragment_hash.high, static_cast<u32>(fragment_shader.length())};
+}
+
+void ShaderCache::GetDriverHash(u64* hash_low, u64* hash_high)
+{
+  union
+  {
+    struct
+    {
+      u64 low;
+      u64 high;
+    };
+    u8 bytes[16];
+  } hash;
+
+  MD5Digest digest;
+  for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+  {
+    const char* str = reinterpret_cast<const char*>(glGetString(name));
+    if (str)
+      digest.Update(str, static_cast<u32>(std::strlen(str)));
+  }
+  digest.Final(hash.bytes);
+
+  *hash_low = hash.low;
+  *hash_high = hash.high;
+}
+
+bool ShaderCache::GetProgram(Program* out_program, std::string_view vertex_shader, std::string_view fragment_shader,
+                             const PreLinkCallback& callback)
+{
+  if (GetCachedProgram(out_program, vertex_shader, fragment_shader))
+    return true;
+
+  if (!out_program->Compile(vertex_shader, fragment_shader))
+    return false;
+
+  if (callback)
+    callback(*out_program);
+
+  if (IsOpen())
+    out_program->SetBinaryRetrievableHint();
+
+  if (!out_program->Link())
+    return false;
+
+  AddProgram(out_program, vertex_shader, fragment_shader);
+  return true;
+}
+
+bool ShaderCache::GetCachedProgram(Program* out_program, std::string_view vertex_shader,
+                                   std::string_view fragment_shader)
+{
+  if (m_index.empty())
+    return false;
+
+  auto iter = m_index.find(GetCacheKey(vertex_shader, fragment_shader));
+  if (iter == m_index.end())
+    return false;
+
+  std::vector<u8> data(iter->second.blob_size);
+  if (std::fseek(m_blob_file, iter->second.file_offset, SEEK_SET) != 0 ||
+      std::fread(data.data(), 1, iter->second.blob_size, m_blob_file) != iter->second.blob_size)
+  {
+    Log_ErrorPrintf("Read program binary from file failed");
+    return false;
+  }
+
+  if (!out_program->CreateFromBinary(data.data(), static_cast<u32>(data.size()), iter->second.blob_format))
+  {
+    m_index.erase(iter);
+    return false;
+  }
+
+  return true;
+}
+
+void ShaderCache::AddProgram(Program* program, std::string_view vertex_shader, std::string_view fragment_shader)
+{
+  if (!IsOpen() || std::fseek(m_blob_file, 0, SEEK_END) != 0 || std::fseek(m_index_file, 0, SEEK_END) != 0)
+    return;
+
+  std::vector<u8> data;
+  u32 data_format = 0;
+  if (!program->GetBinary(&data, &data_format))
+  {
+    Log_WarningPrintf("Failed to retrieve program binary");
+    return;
+  }
+
+  const CacheIndexKey key = GetCacheKey(vertex_shader, fragment_shader);
+
+  CacheIndexData index_data;
+  index_data.file_offset = static_cast<u32>(std::ftell(m_blob_file));
+  index_data.blob_size = static_cast<u32>(data.size());
+  index_data.blob_format = data_format;
+
+  CacheIndexEntry entry = {};
+  entry.vertex_source_hash_low = key.vertex_source_hash_low;
+  entry.vertex_source_hash_high = key.vertex_source_hash_high;
+  entry.vertex_source_length = key.vertex_source_length;
+  entry.fragment_source_hash_low = key.fragment_source_hash_low;
+  entry.fragment_source_hash_high = key.fragment_source_hash_high;
+  entry.fragment_source_length = key.fragment_source_length;
+  entry.file_offset = index_data.file_offset;
+  entry.blob_size = index_data.blob_size;
+  entry.blob_format = index_data.blob_format;
+
+  if (std::fwrite(data.data(), 1, entry.blob_size, m_blob_file) != entry.blob_size || std::fflush(m_blob_file) != 0 ||
+      std::fwrite(&entry, sizeof(entry), 1, m_index_file) != 1 || std::fflush(m_index_file) != 0)
+  {
+    Log_ErrorPrintf("Failed to write program binary to file");
+    return;
+  }
+
+  m_index[key] = index_data;
+}
+
+} // namespace GL
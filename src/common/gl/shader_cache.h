@@ -0,0 +1,92 @@
+#pragma once
+#include "../hash_combine.h"
+#include "../types.h"
+#include "program.h"
+#include <cstdio>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace GL {
+
+class ShaderCache
+{
+public:
+  using PreLinkCallback = std::function<void(Program&)>;
+
+  ShaderCache();
+  ~ShaderCache();
+
+  /// Opens the cache for the current context. Does nothing if the driver doesn't support program binaries.
+  void Open(bool is_gles, std::string_view base_path);
+
+  /// Loads the program from the cache, or compiles and links it and adds it to the cache. The callback sets up
+  /// attribute and fragment output bindings, and is only called when the program is compiled from source.
+  bool GetProgram(Program* out_program, std::string_view vertex_shader, std::string_view fragment_shader,
+                  const PreLinkCallback& callback = {});
+
+  /// Loads the program from the cache only. Returns false if it isn't cached or the driver rejects the binary.
+  bool GetCachedProgram(Program* out_program, std::string_view vertex_shader, std::string_view fragment_shader);
+
+  /// Adds a program which was linked after SetBinaryRetrievableHint() to the cache.
+  void AddProgram(Program* program, std::string_view vertex_shader, std::string_view fragment_shader);
+
+  /// Returns false if program binaries are unsupported or the cache files couldn't be opened.
+  bool IsOpen() const { return (m_index_file != nullptr); }
+
+private:
+  static constexpr u32 FILE_VERSION = 1;
+
+  struct CacheIndexKey
+  {
+    u64 vertex_source_hash_low;
+    u64 vertex_source_hash_high;
+    u32 vertex_source_length;
+    u64 fragment_source_hash_low;
+    u64 fragment_source_hash_high;
+    u32 fragment_source_length;
+
+    bool operator==(const CacheIndexKey& key) const;
+    bool operator!=(const CacheIndexKey& key) const;
+  };
+
+  struct CacheIndexEntryHasher
+  {
+    std::size_t operator()(const CacheIndexKey& e) const noexcept
+    {
+      std::size_t h = 0;
+      hash_combine(h, e.vertex_source_hash_low, e.vertex_source_hash_high, e.vertex_source_length,
+                   e.fragment_source_hash_low, e.fragment_source_hash_high, e.fragment_source_length);
+      return h;
+    }
+  };
+
+  struct CacheIndexData
+  {
+    u32 file_offset;
+    u32 blob_size;
+    u32 blob_format;
+  };
+
+  using CacheIndex = std::unordered_map<CacheIndexKey, CacheIndexData, CacheIndexEntryHasher>;
+
+  static CacheIndexKey GetCacheKey(std::string_view vertex_shader, std::string_view fragment_shader);
+
+  /// Hashes the vendor, renderer and version strings, so a driver change discards the cache.
+  static void GetDriverHash(u64* hash_low, u64* hash_high);
+
+  bool CreateNew(const std::string& index_filename, const std::string& blob_filename);
+  bool ReadExisting(const std::string& index_filename, const std::string& blob_filename);
+  void Close();
+
+  std::FILE* m_index_file = nullptr;
+  std::FILE* m_blob_file = nullptr;
+
+  CacheIndex m_index;
+
+  u64 m_driver_hash_low = 0;
+  u64 m_driver_hash_high = 0;
+};
+
+} // namespace GL
@@ -135,10 +135,11 @@ public:
 
   virtual ~SyncingStreamBuffer() override
   {
-    for (u32 i = m_available_block_index; i <= m_used_block_index; i++)
+    // blocks which haven't been waited for yet can be anywhere in the ring
+    for (GLsync& sync : m_sync_objects)
     {
-      DebugAssert(m_sync_objects[i]);
-      glDeleteSync(m_sync_objects[i]);
+      if (sync)
+        glDeleteSync(sync);
     }
   }
 
@@ -177,6 +178,24 @@ protected:
     }
   }
 
+  // Releases any further blocks which the GPU has already finished with, without blocking. Syncs are signaled in
+  // order, so this stops at the first one which is still pending.
+  void ReleaseSignaledSyncs()
+  {
+    for (; m_available_block_index < NUM_SYNC_POINTS; m_available_block_index++)
+    {
+      GLsync& sync = m_sync_objects[m_available_block_index];
+      DebugAssert(sync);
+
+      const GLenum result = glClientWaitSync(sync, 0, 0);
+      if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        break;
+
+      glDeleteSync(sync);
+      sync = nullptr;
+    }
+  }
+
   void AllocateSpace(u32 size)
   {
     // add sync objects for writes since the last allocation
@@ -202,6 +221,9 @@ protected:
       EnsureSyncsWaitedForOffset(size);
       m_used_block_index = 0;
     }
+
+    // hand out as much space as we can get without stalling, so callers can batch more into the mapping
+    ReleaseSignaledSyncs();
   }
 
   u32 m_position = 0;
@@ -134,6 +134,12 @@ struct Rectangle
   /// Tests whether the specified point is contained in the rectangle.
   constexpr bool Contains(T x, T y) const { return (x >= left && x < right && y >= top && y < bottom); }
 
+  /// Tests whether the specified rectangle is entirely contained in the rectangle.
+  constexpr bool Contains(const Rectangle& rhs) const
+  {
+    return (rhs.left >= left && rhs.right <= right && rhs.top >= top && rhs.bottom <= bottom);
+  }
+
   /// Expands the bounds of the rectangle to contain the specified point.
   constexpr void Include(T x, T y)
   {
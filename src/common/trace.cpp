@@ -0,0 +1,210 @@
+#include "trace.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+Log_SetChannel(Trace);
+
+namespace Trace {
+
+namespace {
+
+struct Span
+{
+  const char* category;
+  const char* name;
+  Common::Timer::Value start_time;
+  Common::Timer::Value end_time;
+};
+
+struct ThreadBuffer
+{
+  std::mutex mutex;
+  std::vector<Span> spans;
+  std::string name;
+  u32 id = 0;
+  u32 position = 0;
+  u32 count = 0;
+  bool thread_exited = false;
+};
+
+// Flags the buffer when the thread exits, so it can be freed once its spans are no longer needed.
+struct ThreadBufferReference
+{
+  ~ThreadBufferReference()
+  {
+    if (!buffer)
+      return;
+
+    std::unique_lock<std::mutex> lock(buffer->mutex);
+    buffer->thread_exited = true;
+  }
+
+  ThreadBuffer* buffer = nullptr;
+};
+
+} // namespace
+
+// 8MB per thread, which is several seconds of emulation with per-event spans.
+static constexpr u32 MAX_SPANS_PER_THREAD = 256 * 1024;
+
+std::atomic_bool g_recording{false};
+
+static std::mutex s_state_mutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> s_thread_buffers;
+static std::unordered_set<std::string> s_interned_strings;
+// Published to other threads by setting g_recording.
+static std::atomic<Common::Timer::Value> s_start_time{0};
+static u32 s_next_thread_id = 1;
+static thread_local ThreadBufferReference s_thread_buffer;
+
+static ThreadBuffer* GetThreadBuffer()
+{
+  if (s_thread_buffer.buffer)
+    return s_thread_buffer.buffer;
+
+  // Buffers outlive their threads, so the spans from threads which have exited can still be written.
+  std::unique_lock<std::mutex> lock(s_state_mutex);
+  std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+  buffer->id = s_next_thread_id++;
+  s_thread_buffer.buffer = buffer.get();
+  s_thread_buffers.push_back(std::move(buffer));
+  return s_thread_buffer.buffer;
+}
+
+void StartRecording()
+{
+  std::unique_lock<std::mutex> lock(s_state_mutex);
+  for (auto iter = s_thread_buffers.begin(); iter != s_thread_buffers.end();)
+  {
+    ThreadBuffer* buffer = iter->get();
+    std::unique_lock<std::mutex> buffer_lock(buffer->mutex);
+    if (buffer->thread_exited)
+    {
+      buffer_lock.unlock();
+      iter = s_thread_buffers.erase(iter);
+      continue;
+    }
+
+    buffer->position = 0;
+    buffer->count = 0;
+    ++iter;
+  }
+
+  s_start_time.store(Common::Timer::GetValue(), std::memory_order_relaxed);
+  g_recording.store(true, std::memory_order_release);
+}
+
+void StopRecording()
+{
+  g_recording.store(false);
+}
+
+void SetThreadName(const char* name)
+{
+  ThreadBuffer* buffer = GetThreadBuffer();
+  std::unique_lock<std::mutex> lock(buffer->mutex);
+  if (buffer->name != name)
+    buffer->name = name;
+}
+
+const char* InternString(const std::string& str)
+{
+  std::unique_lock<std::mutex> lock(s_state_mutex);
+  return s_interned_strings.insert(str).first->c_str();
+}
+
+void AddSpan(const char* category, const char* name, Common::Timer::Value start_time, Common::Timer::Value end_time)
+{
+  // Spans which started before recording are dropped. Seeing the recording flag set means the start time is current.
+  if (!g_recording.load(std::memory_order_acquire) || start_time < s_start_time.load(std::memory_order_relaxed))
+    return;
+
+  ThreadBuffer* buffer = GetThreadBuffer();
+  std::unique_lock<std::mutex> lock(buffer->mutex);
+  if (buffer->spans.empty())
+    buffer->spans.resize(MAX_SPANS_PER_THREAD);
+
+  buffer->spans[buffer->position] = Span{category, name, start_time, end_time};
+  buffer->position = (buffer->position + 1) % MAX_SPANS_PER_THREAD;
+  buffer->count = std::min(buffer->count + 1, MAX_SPANS_PER_THREAD);
+}
+
+static void WriteJSONString(std::FILE* fp, const char* str)
+{
+  std::fputc('"', fp);
+  for (; *str != '\0'; str++)
+  {
+    const char ch = *str;
+    if (ch == '"' || ch == '\\')
+      std::fprintf(fp, "\\%c", ch);
+    else if (static_cast<unsigned char>(ch) < 0x20)
+      std::fprintf(fp, "\\u%04x", static_cast<unsigned>(ch));
+    else
+      std::fputc(ch, fp);
+  }
+  std::fputc('"', fp);
+}
+
+static double ConvertToTraceTime(Common::Timer::Value value)
+{
+  // Trace timestamps are in microseconds.
+  return Common::Timer::ConvertValueToNanoseconds(value - s_start_time.load(std::memory_order_relaxed)) / 1000.0;
+}
+
+bool WriteJSON(const char* filename)
+{
+  std::FILE* fp = std::fopen(filename, "w");
+  if (!fp)
+  {
+    Log_ErrorPrintf("Failed to open '%s' for writing", filename);
+    return false;
+  }
+
+  std::fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  bool first = true;
+  std::unique_lock<std::mutex> lock(s_state_mutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : s_thread_buffers)
+  {
+    std::unique_lock<std::mutex> buffer_lock(buffer->mutex);
+    if (buffer->count == 0)
+      continue;
+
+    std::fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                 first ? "" : ",\n", buffer->id);
+    if (buffer->name.empty())
+      std::fprintf(fp, "\"Thread %u\"", buffer->id);
+    else
+      WriteJSONString(fp, buffer->name.c_str());
+    std::fprintf(fp, "}}");
+    first = false;
+
+    const u32 first_index = (buffer->position + MAX_SPANS_PER_THREAD - buffer->count) % MAX_SPANS_PER_THREAD;
+    for (u32 i = 0; i < buffer->count; i++)
+    {
+      const Span& span = buffer->spans[(first_index + i) % MAX_SPANS_PER_THREAD];
+      std::fprintf(fp, ",\n{\"name\":");
+      WriteJSONString(fp, span.name);
+      std::fprintf(fp, ",\"cat\":");
+      WriteJSONString(fp, span.category);
+      std::fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->id,
+                   ConvertToTraceTime(span.start_time),
+                   Common::Timer::ConvertValueToNanoseconds(span.end_time - span.start_time) / 1000.0);
+    }
+  }
+
+  std::fprintf(fp, "\n]}\n");
+
+  const bool result = (std::ferror(fp) == 0);
+  std::fclose(fp);
+  if (!result)
+    Log_ErrorPrintf("Failed to write trace to '%s'", filename);
+
+  return result;
+}
+
+} // namespace Trace
@@ -0,0 +1,63 @@
+#pragma once
+#include "timer.h"
+#include "types.h"
+#include <atomic>
+#include <string>
+
+// Records timed spans from any thread, which can be written as Chrome trace-event JSON, and viewed in
+// chrome://tracing or Perfetto. Each thread keeps the most recent spans in its own ring buffer.
+namespace Trace {
+
+extern std::atomic_bool g_recording;
+
+/// Returns true if spans are currently being recorded.
+ALWAYS_INLINE bool IsRecording()
+{
+  return g_recording.load(std::memory_order_relaxed);
+}
+
+/// Starts recording, discarding any previously-recorded spans.
+void StartRecording();
+
+/// Stops recording. The recorded spans are kept until recording is started again.
+void StopRecording();
+
+/// Writes the recorded spans in trace-event JSON format.
+bool WriteJSON(const char* filename);
+
+/// Names the calling thread in the trace.
+void SetThreadName(const char* name);
+
+/// Returns a copy of the string which is never freed, for span names which aren't literals.
+const char* InternString(const std::string& str);
+
+/// Records a completed span on the calling thread. The strings must outlive the trace.
+void AddSpan(const char* category, const char* name, Common::Timer::Value start_time, Common::Timer::Value end_time);
+
+class ScopedSpan
+{
+public:
+  ALWAYS_INLINE ScopedSpan(const char* category, const char* name)
+    : m_category(category), m_name(name), m_start_time(IsRecording() ? Common::Timer::GetValue() : 0)
+  {
+  }
+
+  ALWAYS_INLINE ~ScopedSpan()
+  {
+    if (m_start_time != 0)
+      AddSpan(m_category, m_name, m_start_time, Common::Timer::GetValue());
+  }
+
+private:
+  const char* m_category;
+  const char* m_name;
+  Common::Timer::Value m_start_time;
+};
+
+} // namespace Trace
+
+#define TRACE_SCOPE_CONCAT_(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT_(a, b)
+
+/// Records a span for the rest of the scope, using the file's log channel as the category.
+#define TRACE_SCOPE(name) Trace::ScopedSpan TRACE_SCOPE_CONCAT(trace_scope_, __LINE__)(___LogChannel___, name)
@@ -25,6 +25,8 @@ void CDROM::Initialize(System* system, DMA* dma, InterruptController* interrupt_
     m_system->CreateTimingEvent("CDROM Command Event", 1, 1, std::bind(&CDROM::ExecuteCommand, this), false);
   m_drive_event = m_system->CreateTimingEvent("CDROM Drive Event", 1, 1,
                                               std::bind(&CDROM::ExecuteDrive, this, std::placeholders::_2), false);
+  m_command_event->SetFrameTimingCategory(FrameTimingCategory::CDROM);
+  m_drive_event->SetFrameTimingCategory(FrameTimingCategory::CDROM);
 
   if (m_system->GetSettings().cdrom_read_thread)
     m_reader.StartThread();
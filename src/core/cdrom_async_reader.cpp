@@ -2,6 +2,7 @@
 #include "common/assert.h"
 #include "common/log.h"
 #include "common/timer.h"
+#include "common/trace.h"
 Log_SetChannel(CDROMAsyncReader);
 
 CDROMAsyncReader::CDROMAsyncReader() = default;
@@ -103,6 +104,7 @@ bool CDROMAsyncReader::WaitForReadToComplete()
   std::unique_lock<std::mutex> lock(m_mutex);
   if (m_sector_read_pending.load())
   {
+    TRACE_SCOPE("WaitForReadToComplete");
     Log_DebugPrintf("Sector read pending, waiting");
     m_notify_read_complete_cv.wait(lock, [this]() { return !m_sector_read_pending.load(); });
   }
@@ -112,6 +114,8 @@ bool CDROMAsyncReader::WaitForReadToComplete()
 
 void CDROMAsyncReader::DoSectorRead()
 {
+  TRACE_SCOPE("ReadSector");
+
 #ifdef _DEBUG
   Common::Timer timer;
 #endif
@@ -145,6 +149,8 @@ void CDROMAsyncReader::DoSectorRead()
 
 void CDROMAsyncReader::WorkerThreadEntryPoint()
 {
+  Trace::SetThreadName("CDROM Reader");
+
   std::unique_lock lock(m_mutex);
 
   while (!m_shutdown_flag.load())
@@ -1,5 +1,6 @@
 #include "cpu_code_cache.h"
 #include "common/log.h"
+#include "common/trace.h"
 #include "cpu_core.h"
 #include "cpu_disasm.h"
 #include "system.h"
@@ -238,6 +239,8 @@ recompile:
 
 bool CodeCache::CompileBlock(CodeBlock* block)
 {
+  TRACE_SCOPE("CompileBlock");
+
   u32 pc = block->GetPC();
   bool is_branch_delay_slot = false;
   bool is_load_delay_slot = false;
@@ -0,0 +1,90 @@
+#include "frame_timings.h"
+#include "common/assert.h"
+#include <algorithm>
+
+FrameTimings::FrameTimings() = default;
+
+FrameTimings::~FrameTimings() = default;
+
+void FrameTimings::SetEnabled(bool enabled)
+{
+  if (m_enabled == enabled)
+    return;
+
+  m_enabled = enabled;
+  Reset();
+}
+
+void FrameTimings::Reset()
+{
+  m_history_position = 0;
+  m_history_count = 0;
+  m_frame_ticks.fill(0);
+  m_total_times.fill(0.0);
+  m_total_frames = 0;
+  m_last_switch_time = Common::Timer::GetValue();
+}
+
+void FrameTimings::ChargeTime(FrameTimingCategory category)
+{
+  const Common::Timer::Value current_time = Common::Timer::GetValue();
+  m_frame_ticks[static_cast<u32>(category)] += current_time - m_last_switch_time;
+  m_last_switch_time = current_time;
+}
+
+void FrameTimings::CommitFrame()
+{
+  if (!m_enabled)
+    return;
+
+  ChargeTime(m_current_category);
+
+  // Ignore the time between frames, e.g. when the system was paused.
+  m_frame_ticks[static_cast<u32>(FrameTimingCategory::None)] = 0;
+
+  bool has_time = false;
+  FrameTimes& frame = m_history[m_history_position];
+  for (u32 i = 0; i < NUM_CATEGORIES; i++)
+  {
+    frame[i] = static_cast<float>(Common::Timer::ConvertValueToMilliseconds(m_frame_ticks[i]));
+    has_time |= (m_frame_ticks[i] != 0);
+    m_frame_ticks[i] = 0;
+  }
+
+  // The first commit after a reset won't have any time charged.
+  if (!has_time)
+    return;
+
+  for (u32 i = 0; i < NUM_CATEGORIES; i++)
+    m_total_times[i] += static_cast<double>(frame[i]);
+  m_total_frames++;
+
+  m_history_position = (m_history_position + 1) % HISTORY_SIZE;
+  m_history_count = std::min(m_history_count + 1, HISTORY_SIZE);
+}
+
+const FrameTimings::FrameTimes& FrameTimings::GetHistoryFrame(u32 index) const
+{
+  DebugAssert(index < m_history_count);
+  return m_history[(m_history_position + HISTORY_SIZE - m_history_count + index) % HISTORY_SIZE];
+}
+
+FrameTimings::FrameTimes FrameTimings::GetAverageTimes() const
+{
+  FrameTimes times = {};
+  if (m_total_frames == 0)
+    return times;
+
+  for (u32 i = 0; i < NUM_CATEGORIES; i++)
+    times[i] = static_cast<float>(m_total_times[i] / static_cast<double>(m_total_frames));
+
+  return times;
+}
+
+const char* FrameTimings::GetCategoryName(FrameTimingCategory category)
+{
+  static constexpr std::array<const char*, NUM_CATEGORIES> names = {
+    {"None", "System", "CPU", "Events", "GPU", "SPU", "CDROM", "Presentation"}};
+
+  return names[static_cast<u32>(category)];
+}
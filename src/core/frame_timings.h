@@ -0,0 +1,97 @@
+#pragma once
+#include "common/timer.h"
+#include "types.h"
+#include <array>
+
+enum class FrameTimingCategory : u8
+{
+  None,         // Not attributed to any frame, e.g. throttling.
+  System,       // Frame overhead not covered by another category, e.g. runahead snapshots.
+  CPU,          // CPU execution, including memory accesses and DMA.
+  Events,       // Timing event callbacks not owned by another category.
+  GPU,          // Command processing, rendering and display updates.
+  SPU,          // Sample generation.
+  CDROM,        // Command and sector processing.
+  Presentation, // Host UI and display presentation.
+  Count
+};
+
+/// Per-frame breakdown of where time is spent. Time is charged to the active category, which is changed by
+/// ScopedFrameTiming, so nested scopes are exclusive of each other.
+class FrameTimings
+{
+public:
+  static constexpr u32 NUM_CATEGORIES = static_cast<u32>(FrameTimingCategory::Count);
+  static constexpr u32 HISTORY_SIZE = 120;
+
+  /// Times in milliseconds, indexed by category.
+  using FrameTimes = std::array<float, NUM_CATEGORIES>;
+
+  FrameTimings();
+  ~FrameTimings();
+
+  ALWAYS_INLINE bool IsEnabled() const { return m_enabled; }
+  void SetEnabled(bool enabled);
+
+  /// Clears the history and totals.
+  void Reset();
+
+  /// Changes the category time is charged to, returning the previous category.
+  ALWAYS_INLINE FrameTimingCategory SwitchCategory(FrameTimingCategory category)
+  {
+    const FrameTimingCategory previous_category = m_current_category;
+    m_current_category = category;
+    if (m_enabled && category != previous_category)
+      ChargeTime(previous_category);
+
+    return previous_category;
+  }
+
+  /// Adds the time accumulated since the last commit to the history as a frame.
+  void CommitFrame();
+
+  /// Returns the number of frames in the history.
+  ALWAYS_INLINE u32 GetHistoryCount() const { return m_history_count; }
+
+  /// Returns a frame from the history, index zero is the oldest.
+  const FrameTimes& GetHistoryFrame(u32 index) const;
+
+  /// Returns the average time per frame for each category, since the last reset.
+  FrameTimes GetAverageTimes() const;
+
+  static const char* GetCategoryName(FrameTimingCategory category);
+
+private:
+  void ChargeTime(FrameTimingCategory category);
+
+  std::array<FrameTimes, HISTORY_SIZE> m_history = {};
+  std::array<Common::Timer::Value, NUM_CATEGORIES> m_frame_ticks = {};
+  std::array<double, NUM_CATEGORIES> m_total_times = {};
+  Common::Timer::Value m_last_switch_time = 0;
+  u32 m_history_position = 0;
+  u32 m_history_count = 0;
+  u32 m_total_frames = 0;
+  FrameTimingCategory m_current_category = FrameTimingCategory::None;
+  bool m_enabled = false;
+};
+
+/// Charges time to a category for the duration of the scope. Does nothing if frame_timings is null.
+class ScopedFrameTiming
+{
+public:
+  ALWAYS_INLINE ScopedFrameTiming(FrameTimings* frame_timings, FrameTimingCategory category)
+    : m_frame_timings(frame_timings),
+      m_previous_category(frame_timings ? frame_timings->SwitchCategory(category) : FrameTimingCategory::None)
+  {
+  }
+
+  ALWAYS_INLINE ~ScopedFrameTiming()
+  {
+    if (m_frame_timings)
+      m_frame_timings->SwitchCategory(m_previous_category);
+  }
+
+private:
+  FrameTimings* m_frame_timings;
+  FrameTimingCategory m_previous_category;
+};
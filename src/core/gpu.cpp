@@ -1,8 +1,9 @@
 #include "gpu.h"
-#include "common/heap_array.h"
+#include "common/byte_stream.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
 #include "dma.h"
+#include "gpu_dump.h"
 #include "host_display.h"
 #include "host_interface.h"
 #include "interrupt_controller.h"
@@ -30,6 +31,7 @@ bool GPU::Initialize(HostDisplay* host_display, System* system, DMA* dma, Interr
   m_force_progressive_scan = m_system->GetSettings().display_force_progressive_scan;
   m_tick_event =
     m_system->CreateTimingEvent("GPU Tick", 1, 1, std::bind(&GPU::Execute, this, std::placeholders::_1), true);
+  m_tick_event->SetFrameTimingCategory(FrameTimingCategory::GPU);
   return true;
 }
 
@@ -44,6 +46,9 @@ void GPU::Reset()
   SoftReset();
   m_set_texture_disable_mask = false;
   m_GPUREAD_latch = 0;
+
+  // The backend hasn't reset yet, so snapshot the state when the next packet is written instead.
+  m_dump_state_pending = IsDumping();
 }
 
 void GPU::SoftReset()
@@ -53,7 +58,6 @@ void GPU::SoftReset()
   m_drawing_area.Set(0, 0, 0, 0);
   m_drawing_area_changed = true;
   m_drawing_offset = {};
-  m_drawing_offset_changed = true;
   std::memset(&m_crtc_state, 0, sizeof(m_crtc_state));
   m_crtc_state.regs.display_address_start = 0;
   m_crtc_state.regs.horizontal_display_range = 0xC60260;
@@ -72,7 +76,7 @@ void GPU::SoftReset()
   UpdateSliceTicks();
 }
 
-bool GPU::DoState(StateWrapper& sw)
+bool GPU::DoState(StateWrapper& sw, bool use_vram_snapshot)
 {
   if (sw.IsReading())
   {
@@ -146,9 +150,7 @@ bool GPU::DoState(StateWrapper& sw)
   if (sw.IsReading())
   {
     m_draw_mode.texture_page_changed = true;
-    m_draw_mode.texture_window_changed = true;
     m_drawing_area_changed = true;
-    m_drawing_offset_changed = true;
     UpdateDMARequest();
   }
 
@@ -157,23 +159,41 @@ bool GPU::DoState(StateWrapper& sw)
 
   if (sw.IsReading())
   {
-    // Need to clear the mask bits since we want to pull it in from the copy.
-    const u32 old_GPUSTAT = m_GPUSTAT.bits;
-    m_GPUSTAT.check_mask_before_draw = false;
-    m_GPUSTAT.set_mask_while_drawing = false;
+    if (use_vram_snapshot)
+    {
+      if (!LoadVRAMSnapshot())
+        return false;
+
+      // A VRAM to CPU transfer in progress reads from the shadow copy, which isn't part of the snapshot.
+      if (m_state == State::ReadingVRAM)
+        ReadVRAM(m_vram_transfer.x, m_vram_transfer.y, m_vram_transfer.width, m_vram_transfer.height);
+    }
+    else
+    {
+      // Need to clear the mask bits since we want to pull it in from the copy.
+      const u32 old_GPUSTAT = m_GPUSTAT.bits;
+      m_GPUSTAT.check_mask_before_draw = false;
+      m_GPUSTAT.set_mask_while_drawing = false;
 
-    // Still need a temporary here.
-    HeapArray<u16, VRAM_WIDTH * VRAM_HEIGHT> temp;
-    sw.DoBytes(temp.data(), VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16));
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, temp.data());
+      // Read straight into our copy of VRAM, then let the backend pick it up. Saves a 1MB temporary on every load.
+      sw.DoBytes(m_vram_ptr, VRAM_WIDTH * VRAM_HEIGHT * sizeof(u16));
+      UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_ptr);
 
-    // Restore mask setting.
-    m_GPUSTAT.bits = old_GPUSTAT;
+      // Restore mask setting.
+      m_GPUSTAT.bits = old_GPUSTAT;
+    }
 
     UpdateCRTCConfig();
-    UpdateDisplay();
+    if (!m_display_updates_suppressed)
+      UpdateDisplay();
     UpdateSliceTicks();
   }
+  else if (use_vram_snapshot)
+  {
+    FlushRender();
+    if (!SaveVRAMSnapshot())
+      return false;
+  }
   else
   {
     ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
@@ -183,6 +203,16 @@ bool GPU::DoState(StateWrapper& sw)
   return !sw.HasError();
 }
 
+bool GPU::SupportsVRAMSnapshots() const
+{
+  return false;
+}
+
+bool GPU::HasVRAMSnapshot() const
+{
+  return false;
+}
+
 void GPU::ResetGraphicsAPIState() {}
 
 void GPU::RestoreGraphicsAPIState() {}
@@ -287,6 +317,9 @@ void GPU::DMAWrite(const u32* words, u32 word_count)
   {
     case DMADirection::CPUtoGP0:
     {
+      if (m_dump_writer)
+        SyncDumpWriter()->WriteGP0(words, word_count);
+
       std::copy(words, words + word_count, std::back_inserter(m_GP0_buffer));
       ExecuteCommands();
 
@@ -549,7 +582,10 @@ void GPU::Execute(TickCount ticks)
 
         // flush any pending draws and "scan out" the image
         FlushRender();
-        UpdateDisplay();
+        if (m_dump_writer)
+          SyncDumpWriter()->WriteVBlank(m_GPUSTAT.bits);
+        if (!m_display_updates_suppressed)
+          UpdateDisplay();
         m_system->IncrementFrameNumber();
       }
 
@@ -596,6 +632,13 @@ u32 GPU::ReadGPUREAD()
   if (m_state != State::ReadingVRAM)
     return m_GPUREAD_latch;
 
+  if (m_dump_writer)
+    SyncDumpWriter()->WriteGPUREADRead(1);
+
+  // The readback was started when the transfer was set up, but doesn't need to be waited for until now.
+  if (m_vram_transfer.col == 0 && m_vram_transfer.row == 0)
+    EndReadVRAM();
+
   // Read two pixels out of VRAM and combine them. Zero fill odd pixel counts.
   u32 value = 0;
   for (u32 i = 0; i < 2; i++)
@@ -629,12 +672,18 @@ u32 GPU::ReadGPUREAD()
 
 void GPU::WriteGP0(u32 value)
 {
+  if (m_dump_writer)
+    SyncDumpWriter()->WriteGP0(&value, 1);
+
   m_GP0_buffer.push_back(value);
   ExecuteCommands();
 }
 
 void GPU::WriteGP1(u32 value)
 {
+  // Display changes catch up on the CRTC first, which can end the frame. The write has to come after it in the dump.
+  GPUDump::Writer* dump_writer = m_dump_writer ? SyncDumpWriter() : nullptr;
+
   const u8 command = Truncate8(value >> 24);
   const u32 param = value & UINT32_C(0x00FFFFFF);
   switch (command)
@@ -784,6 +833,9 @@ void GPU::WriteGP1(u32 value)
       Log_ErrorPrintf("Unimplemented GP1 command 0x%02X", command);
       break;
   }
+
+  if (dump_writer)
+    dump_writer->WriteGP1(value);
 }
 
 void GPU::HandleGetGPUInfoCommand(u32 value)
@@ -835,10 +887,141 @@ void GPU::HandleGetGPUInfoCommand(u32 value)
   }
 }
 
+bool GPU::StartDumping(const char* filename)
+{
+  if (m_dump_writer)
+    m_dump_writer.reset();
+
+  m_dump_writer = std::make_unique<GPUDump::Writer>();
+  if (!m_dump_writer->Open(filename))
+  {
+    Log_ErrorPrintf("Failed to open '%s'", filename);
+    m_dump_writer.reset();
+    return false;
+  }
+
+  m_dump_state_pending = true;
+  SyncDumpWriter();
+  return true;
+}
+
+bool GPU::StopDumping()
+{
+  if (!m_dump_writer)
+    return false;
+
+  m_dump_writer.reset();
+  m_dump_state_pending = false;
+  return true;
+}
+
+GPUDump::Writer* GPU::SyncDumpWriter()
+{
+  if (m_dump_state_pending)
+  {
+    m_dump_state_pending = false;
+
+    std::unique_ptr<GrowableMemoryByteStream> stream = ByteStream_CreateGrowableMemoryStream();
+    StateWrapper sw(stream.get(), StateWrapper::Mode::Write);
+    if (DoState(sw))
+      m_dump_writer->WriteState(stream->GetMemoryPointer(), stream->GetMemorySize());
+    else
+      Log_ErrorPrintf("Failed to save state to GPU dump");
+  }
+
+  return m_dump_writer.get();
+}
+
+bool GPU::ReplayDumpFrame(GPUDump::Reader* reader, u32* num_primitives)
+{
+  const u32 start_num_primitives = m_stats.num_polygons;
+  *num_primitives = 0;
+
+  GPUDump::PacketType type;
+  while (reader->ReadPacket(&type, &m_dump_packet_data))
+  {
+    const u32* data = m_dump_packet_data.data();
+    const u32 word_count = static_cast<u32>(m_dump_packet_data.size());
+    switch (type)
+    {
+      case GPUDump::PacketType::State:
+      {
+        std::unique_ptr<ReadOnlyMemoryByteStream> stream =
+          ByteStream_CreateReadOnlyMemoryStream(data, word_count * sizeof(u32));
+        StateWrapper sw(stream.get(), StateWrapper::Mode::Read);
+        if (!DoState(sw))
+        {
+          Log_ErrorPrintf("Failed to load state from GPU dump");
+          return false;
+        }
+      }
+      break;
+
+      case GPUDump::PacketType::GP0Data:
+      {
+        // Same as a DMA transfer, the words are all queued before executing commands.
+        m_GP0_buffer.insert(m_GP0_buffer.end(), data, data + word_count);
+        ExecuteCommands();
+      }
+      break;
+
+      case GPUDump::PacketType::GP1Data:
+      {
+        for (u32 i = 0; i < word_count; i++)
+          WriteGP1(data[i]);
+      }
+      break;
+
+      case GPUDump::PacketType::GPUREADRead:
+      {
+        const u32 read_count = (word_count > 0) ? data[0] : 0;
+        for (u32 i = 0; i < read_count; i++)
+          ReadGPUREAD();
+      }
+      break;
+
+      case GPUDump::PacketType::VBlank:
+      {
+        // The CRTC isn't running when replaying, so take the field from the dump.
+        if (word_count > 0)
+          m_GPUSTAT.interlaced_field = GPUSTAT{data[0]}.interlaced_field.GetValue();
+
+        FlushRender();
+        UpdateDisplay();
+        *num_primitives = m_stats.num_polygons - start_num_primitives;
+        return true;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  *num_primitives = m_stats.num_polygons - start_num_primitives;
+  return false;
+}
+
 void GPU::UpdateDisplay() {}
 
 void GPU::ReadVRAM(u32 x, u32 y, u32 width, u32 height) {}
 
+void GPU::BeginReadVRAM(u32 x, u32 y, u32 width, u32 height)
+{
+  ReadVRAM(x, y, width, height);
+}
+
+void GPU::EndReadVRAM() {}
+
+bool GPU::SaveVRAMSnapshot()
+{
+  return false;
+}
+
+bool GPU::LoadVRAMSnapshot()
+{
+  return false;
+}
+
 void GPU::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
   const u16 color16 = RGBA8888ToRGBA5551(color);
@@ -872,6 +1055,9 @@ void GPU::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
   {
     const u16* src_ptr = static_cast<const u16*>(data);
     u16* dst_ptr = &m_vram_ptr[y * VRAM_WIDTH + x];
+    if (src_ptr == dst_ptr && width == VRAM_WIDTH)
+      return;
+
     for (u32 yoffs = 0; yoffs < height; yoffs++)
     {
       std::copy_n(src_ptr, width, dst_ptr);
@@ -973,7 +1159,6 @@ void GPU::DrawMode::SetTextureWindow(u32 value)
   texture_window_offset_x = (value >> 10) & UINT32_C(0x1F);
   texture_window_offset_y = (value >> 15) & UINT32_C(0x1F);
   texture_window_value = value;
-  texture_window_changed = true;
 }
 
 bool GPU::DumpVRAMToFile(const char* filename, u32 width, u32 height, u32 stride, const void* buffer, bool remove_alpha)
@@ -14,6 +14,11 @@ class StateWrapper;
 
 class HostDisplay;
 
+namespace GPUDump {
+class Writer;
+class Reader;
+} // namespace GPUDump
+
 class System;
 class TimingEvent;
 class DMA;
@@ -116,7 +121,15 @@ public:
   virtual bool Initialize(HostDisplay* host_display, System* system, DMA* dma,
                           InterruptController* interrupt_controller, Timers* timers);
   virtual void Reset();
-  virtual bool DoState(StateWrapper& sw);
+
+  /// When use_vram_snapshot is set, VRAM is kept in the renderer with SaveVRAMSnapshot() instead of the state.
+  virtual bool DoState(StateWrapper& sw, bool use_vram_snapshot = false);
+
+  /// Returns true if the renderer can keep a copy of VRAM for in-memory save states without reading it back.
+  virtual bool SupportsVRAMSnapshots() const;
+
+  /// Returns true if the renderer still holds the VRAM snapshot from the last snapshot save.
+  virtual bool HasVRAMSnapshot() const;
 
   // Graphics API state reset/restore - call when drawing the UI etc.
   virtual void ResetGraphicsAPIState();
@@ -139,6 +152,22 @@ public:
   // Recompile shaders/recreate framebuffers when needed.
   virtual void UpdateSettings();
 
+  /// Skips scanout on vblank/state load, for frames which will never be presented (e.g. runahead).
+  ALWAYS_INLINE bool AreDisplayUpdatesSuppressed() const { return m_display_updates_suppressed; }
+  ALWAYS_INLINE void SetDisplayUpdatesSuppressed(bool suppressed) { m_display_updates_suppressed = suppressed; }
+
+  /// Returns true if the command stream is currently being dumped.
+  ALWAYS_INLINE bool IsDumping() const { return static_cast<bool>(m_dump_writer); }
+
+  /// Starts dumping the command stream to a file, beginning with a snapshot of the current state.
+  bool StartDumping(const char* filename);
+
+  /// Stops dumping the command stream, if started.
+  bool StopDumping();
+
+  /// Replays a dump up to the end of the next frame, and scans it out. Returns false at the end of the dump.
+  bool ReplayDumpFrame(GPUDump::Reader* reader, u32* num_primitives);
+
   // gpu_hw_d3d11.cpp
   static std::unique_ptr<GPU> CreateHardwareD3D11Renderer();
 
@@ -333,8 +362,21 @@ protected:
   void EndCommand();
   void HandleGetGPUInfoCommand(u32 value);
 
+  /// Writes the state snapshot to the dump if one is pending, and returns the dump writer. Only call when dumping.
+  GPUDump::Writer* SyncDumpWriter();
+
   // Rendering in the backend
   virtual void ReadVRAM(u32 x, u32 y, u32 width, u32 height);
+
+  /// Starts reading back the area of a VRAM to CPU transfer. The shadow copy only has to be up to date once
+  /// EndReadVRAM() returns, which happens when the CPU reads the first word. Defaults to a synchronous ReadVRAM().
+  virtual void BeginReadVRAM(u32 x, u32 y, u32 width, u32 height);
+  virtual void EndReadVRAM();
+
+  /// Copies VRAM to/from a snapshot held by the renderer. Only the most recent snapshot is kept. Loading returns false
+  /// if the snapshot has been discarded, e.g. by a resolution change.
+  virtual bool SaveVRAMSnapshot();
+  virtual bool LoadVRAMSnapshot();
   virtual void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color);
   virtual void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data);
   virtual void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height);
@@ -457,7 +499,6 @@ protected:
     bool texture_x_flip;
     bool texture_y_flip;
     bool texture_page_changed;
-    bool texture_window_changed;
 
     /// Returns the texture/palette rendering mode.
     TextureMode GetTextureMode() const { return mode_reg.texture_mode; }
@@ -490,10 +531,6 @@ protected:
     void SetTexturePageChanged() { texture_page_changed = true; }
     void ClearTexturePageChangedFlag() { texture_page_changed = false; }
 
-    bool IsTextureWindowChanged() const { return texture_window_changed; }
-    void SetTextureWindowChanged() { texture_window_changed = true; }
-    void ClearTextureWindowChangedFlag() { texture_window_changed = false; }
-
     void SetTextureWindow(u32 value);
 
   } m_draw_mode = {};
@@ -508,8 +545,8 @@ protected:
 
   bool m_set_texture_disable_mask = false;
   bool m_drawing_area_changed = false;
-  bool m_drawing_offset_changed = false;
   bool m_force_progressive_scan = false;
+  bool m_display_updates_suppressed = false;
 
   struct CRTCState
   {
@@ -605,6 +642,10 @@ protected:
   Stats m_stats = {};
   Stats m_last_stats = {};
 
+  std::unique_ptr<GPUDump::Writer> m_dump_writer;
+  std::vector<u32> m_dump_packet_data;
+  bool m_dump_state_pending = false;
+
 private:
   using GP0CommandHandler = bool (GPU::*)(const u32*&, u32);
   using GP0CommandHandlerTable = std::array<GP0CommandHandler, 256>;
@@ -25,6 +25,7 @@ static constexpr u32 ReplaceZero(u32 value, u32 value_for_zero)
 void GPU::ExecuteCommands()
 {
   Assert(m_GP0_buffer.size() < 1048576);
+  ScopedFrameTiming frame_timing(&m_system->GetFrameTimings(), FrameTimingCategory::GPU);
 
   const u32* command_ptr = m_GP0_buffer.data();
   u32 command_size = static_cast<u32>(m_GP0_buffer.size());
@@ -189,14 +190,8 @@ bool GPU::HandleSetDrawingOffsetCommand(const u32*& command_ptr, u32 command_siz
   const s32 x = SignExtendN<11, s32>(param & 0x7FF);
   const s32 y = SignExtendN<11, s32>((param >> 11) & 0x7FF);
   Log_DebugPrintf("Set drawing offset (%d, %d)", m_drawing_offset.x, m_drawing_offset.y);
-  if (m_drawing_offset.x != x || m_drawing_offset.y != y)
-  {
-    FlushRender();
-
-    m_drawing_offset.x = x;
-    m_drawing_offset.y = y;
-    m_drawing_offset_changed = true;
-  }
+  m_drawing_offset.x = x;
+  m_drawing_offset.y = y;
 
   EndCommand();
   return true;
@@ -386,11 +381,12 @@ bool GPU::HandleCopyRectangleVRAMToCPUCommand(const u32*& command_ptr, u32 comma
   // all rendering should be done first...
   FlushRender();
 
-  // ensure VRAM shadow is up to date
-  ReadVRAM(m_vram_transfer.x, m_vram_transfer.y, m_vram_transfer.width, m_vram_transfer.height);
+  // start bringing the VRAM shadow up to date, it's finished when the CPU reads the data
+  BeginReadVRAM(m_vram_transfer.x, m_vram_transfer.y, m_vram_transfer.width, m_vram_transfer.height);
 
   if (m_system->GetSettings().debugging.dump_vram_to_cpu_copies)
   {
+    EndReadVRAM();
     DumpVRAMToFile(StringUtil::StdStringFromFormat("vram_to_cpu_copy_%u.png", s_vram_to_cpu_dump_id++).c_str(),
                    m_vram_transfer.width, m_vram_transfer.height, sizeof(u16) * VRAM_WIDTH,
                    &m_vram_ptr[m_vram_transfer.y * VRAM_WIDTH + m_vram_transfer.x], true);
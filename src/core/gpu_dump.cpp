@@ -0,0 +1,212 @@
+#include "gpu_dump.h"
+#include "common/log.h"
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+Log_SetChannel(GPUDump);
+
+namespace GPUDump {
+
+struct FileHeader
+{
+  u32 signature;
+  u32 version;
+};
+
+struct PacketHeader
+{
+  PacketType type;
+  u32 word_count;
+};
+
+Writer::Writer() = default;
+
+Writer::~Writer()
+{
+  if (IsOpen())
+    Close();
+}
+
+bool Writer::Open(const char* filename)
+{
+  if (IsOpen())
+    Close();
+
+  // The command stream compresses well, and a fast level keeps up with the emulator.
+  m_file = gzopen(filename, "wb1");
+  if (!m_file)
+    return false;
+
+  const FileHeader header = {FILE_SIGNATURE, FILE_VERSION};
+  if (gzwrite(m_file, &header, sizeof(header)) != sizeof(header))
+  {
+    Log_ErrorPrintf("Failed to write header to file");
+    gzclose(m_file);
+    m_file = nullptr;
+    return false;
+  }
+
+  m_packet_data.reserve(MAX_PACKET_WORDS);
+  return true;
+}
+
+void Writer::Close()
+{
+  if (!IsOpen())
+    return;
+
+  FlushPacket();
+  if (gzclose(m_file) != Z_OK)
+    Log_ErrorPrintf("Failed to close file, dump may be truncated");
+
+  m_file = nullptr;
+  m_packet_type = PacketType::Count;
+  m_packet_data.clear();
+}
+
+void Writer::WriteState(const void* data, u32 size)
+{
+  FlushPacket();
+
+  // Pad to a whole number of words. Loading the state stops before the padding.
+  m_packet_data.assign((size + (sizeof(u32) - 1)) / sizeof(u32), 0);
+  std::memcpy(m_packet_data.data(), data, size);
+  WritePacket(PacketType::State, m_packet_data.data(), static_cast<u32>(m_packet_data.size()));
+  m_packet_data.clear();
+}
+
+void Writer::WriteGP0(const u32* words, u32 word_count)
+{
+  while (word_count > 0)
+  {
+    const u32 words_this_packet = std::min<u32>(word_count, MAX_PACKET_WORDS);
+    BeginPacket(PacketType::GP0Data, words_this_packet);
+    m_packet_data.insert(m_packet_data.end(), words, words + words_this_packet);
+    words += words_this_packet;
+    word_count -= words_this_packet;
+  }
+}
+
+void Writer::WriteGP1(u32 value)
+{
+  BeginPacket(PacketType::GP1Data, 1);
+  m_packet_data.push_back(value);
+}
+
+void Writer::WriteGPUREADRead(u32 word_count)
+{
+  // Consecutive reads are merged into a single count.
+  if (m_packet_type == PacketType::GPUREADRead)
+  {
+    m_packet_data[0] += word_count;
+    return;
+  }
+
+  BeginPacket(PacketType::GPUREADRead, 1);
+  m_packet_data.push_back(word_count);
+}
+
+void Writer::WriteVBlank(u32 gpustat)
+{
+  FlushPacket();
+  WritePacket(PacketType::VBlank, &gpustat, 1);
+}
+
+void Writer::BeginPacket(PacketType type, u32 word_count)
+{
+  if (m_packet_type == type && (m_packet_data.size() + word_count) <= MAX_PACKET_WORDS)
+    return;
+
+  FlushPacket();
+  m_packet_type = type;
+}
+
+void Writer::FlushPacket()
+{
+  if (m_packet_type == PacketType::Count)
+    return;
+
+  WritePacket(m_packet_type, m_packet_data.data(), static_cast<u32>(m_packet_data.size()));
+  m_packet_type = PacketType::Count;
+  m_packet_data.clear();
+}
+
+void Writer::WritePacket(PacketType type, const void* data, u32 word_count)
+{
+  const PacketHeader header = {type, word_count};
+  const int data_size = static_cast<int>(word_count * sizeof(u32));
+  if (gzwrite(m_file, &header, sizeof(header)) != sizeof(header) || gzwrite(m_file, data, data_size) != data_size)
+    Log_ErrorPrintf("Failed to write %u words to file", word_count);
+}
+
+Reader::Reader() = default;
+
+Reader::~Reader()
+{
+  if (IsOpen())
+    Close();
+}
+
+bool Reader::Open(const char* filename)
+{
+  if (IsOpen())
+    Close();
+
+  m_file = gzopen(filename, "rb");
+  if (!m_file)
+    return false;
+
+  FileHeader header;
+  if (gzread(m_file, &header, sizeof(header)) != sizeof(header) || header.signature != FILE_SIGNATURE)
+  {
+    Log_ErrorPrintf("'%s' is not a GPU dump", filename);
+    Close();
+    return false;
+  }
+
+  if (header.version != FILE_VERSION)
+  {
+    Log_ErrorPrintf("'%s' is version %u, expected version %u", filename, header.version, FILE_VERSION);
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+void Reader::Close()
+{
+  if (!IsOpen())
+    return;
+
+  gzclose(m_file);
+  m_file = nullptr;
+}
+
+bool Reader::ReadPacket(PacketType* type, std::vector<u32>* data)
+{
+  PacketHeader header;
+  const int header_size = gzread(m_file, &header, sizeof(header));
+  if (header_size == 0 && gzeof(m_file))
+    return false;
+
+  if (header_size != sizeof(header) || header.type >= PacketType::Count ||
+      (header.type != PacketType::State && header.word_count > MAX_PACKET_WORDS))
+  {
+    Log_ErrorPrintf("Corrupted packet header");
+    return false;
+  }
+
+  data->resize(header.word_count);
+  const int data_size = static_cast<int>(header.word_count * sizeof(u32));
+  if (gzread(m_file, data->data(), data_size) != data_size)
+  {
+    Log_ErrorPrintf("Truncated packet of %u words", header.word_count);
+    return false;
+  }
+
+  *type = header.type;
+  return true;
+}
+
+} // namespace GPUDump
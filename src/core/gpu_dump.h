@@ -0,0 +1,73 @@
+#pragma once
+#include "types.h"
+#include <vector>
+
+struct gzFile_s;
+
+// Captures of the GPU command stream, which can be replayed into any renderer without emulating the rest of the system.
+namespace GPUDump {
+
+enum : u32
+{
+  FILE_SIGNATURE = 0x44555047, // GPUD
+  FILE_VERSION = 1,
+  MAX_PACKET_WORDS = 65536
+};
+
+enum class PacketType : u32
+{
+  State,       // Serialized GPU state including VRAM, padded to a whole number of words. Always the first packet.
+  GP0Data,     // Words written to GP0, either through the register or DMA.
+  GP1Data,     // Words written to GP1.
+  GPUREADRead, // Number of words read from GPUREAD during a VRAM to CPU transfer.
+  VBlank,      // Start of vertical blank, i.e. the end of a frame. Holds the value of GPUSTAT.
+  Count
+};
+
+class Writer
+{
+public:
+  Writer();
+  ~Writer();
+
+  ALWAYS_INLINE bool IsOpen() const { return (m_file != nullptr); }
+
+  bool Open(const char* filename);
+  void Close();
+
+  void WriteState(const void* data, u32 size);
+  void WriteGP0(const u32* words, u32 word_count);
+  void WriteGP1(u32 value);
+  void WriteGPUREADRead(u32 word_count);
+  void WriteVBlank(u32 gpustat);
+
+private:
+  /// Starts a new packet unless the pending packet is of the same type and has space for the words.
+  void BeginPacket(PacketType type, u32 word_count);
+  void FlushPacket();
+  void WritePacket(PacketType type, const void* data, u32 word_count);
+
+  gzFile_s* m_file = nullptr;
+  PacketType m_packet_type = PacketType::Count;
+  std::vector<u32> m_packet_data;
+};
+
+class Reader
+{
+public:
+  Reader();
+  ~Reader();
+
+  ALWAYS_INLINE bool IsOpen() const { return (m_file != nullptr); }
+
+  bool Open(const char* filename);
+  void Close();
+
+  /// Reads the next packet. Returns false at the end of the file, or if the file is corrupted.
+  bool ReadPacket(PacketType* type, std::vector<u32>* data);
+
+private:
+  gzFile_s* m_file = nullptr;
+};
+
+} // namespace GPUDump
@@ -55,9 +55,9 @@ void GPU_HW::Reset()
   SetFullVRAMDirtyRectangle();
 }
 
-bool GPU_HW::DoState(StateWrapper& sw)
+bool GPU_HW::DoState(StateWrapper& sw, bool use_vram_snapshot)
 {
-  if (!GPU::DoState(sw))
+  if (!GPU::DoState(sw, use_vram_snapshot))
     return false;
 
   // invalidate the whole VRAM read texture when loading state
@@ -67,6 +67,11 @@ bool GPU_HW::DoState(StateWrapper& sw)
   return true;
 }
 
+bool GPU_HW::SupportsVRAMSnapshots() const
+{
+  return true;
+}
+
 void GPU_HW::UpdateSettings()
 {
   GPU::UpdateSettings();
@@ -92,6 +97,7 @@ void GPU_HW::PrintSettingsToLog()
 void GPU_HW::LoadVertices(RenderCommand rc, u32 num_vertices, const u32* command_ptr)
 {
   const u32 texpage = ZeroExtend32(m_draw_mode.mode_reg.bits) | (ZeroExtend32(m_draw_mode.palette_reg) << 16);
+  const u32 texwindow = m_draw_mode.texture_window_value;
 
   s32 min_x = std::numeric_limits<s32>::max();
   s32 max_x = std::numeric_limits<s32>::min();
@@ -118,7 +124,8 @@ void GPU_HW::LoadVertices(RenderCommand rc, u32 num_vertices, const u32* command
         const VertexPosition vp{command_ptr[buffer_pos++]};
         const u16 packed_texcoord = textured ? Truncate16(command_ptr[buffer_pos++]) : 0;
 
-        vertices[i].Set(vp.x, vp.y, color, texpage, packed_texcoord);
+        vertices[i].Set(m_drawing_offset.x + vp.x, m_drawing_offset.y + vp.y, color, texpage, texwindow,
+                        packed_texcoord);
       }
 
       // Cull polygons which are too large.
@@ -150,7 +157,8 @@ void GPU_HW::LoadVertices(RenderCommand rc, u32 num_vertices, const u32* command
         const VertexPosition vp{command_ptr[buffer_pos++]};
         const u16 packed_texcoord = textured ? Truncate16(command_ptr[buffer_pos++]) : 0;
 
-        vertices[3].Set(vp.x, vp.y, color, texpage, packed_texcoord);
+        vertices[3].Set(m_drawing_offset.x + vp.x, m_drawing_offset.y + vp.y, color, texpage, texwindow,
+                        packed_texcoord);
 
         // Cull polygons which are too large.
         if (std::abs(vertices[3].x - vertices[2].x) >= MAX_PRIMITIVE_WIDTH ||
@@ -183,8 +191,8 @@ void GPU_HW::LoadVertices(RenderCommand rc, u32 num_vertices, const u32* command
       u32 buffer_pos = 1;
       const u32 color = rc.color_for_first_vertex;
       const VertexPosition vp{command_ptr[buffer_pos++]};
-      const s32 pos_x = vp.x;
-      const s32 pos_y = vp.y;
+      const s32 pos_x = m_drawing_offset.x + vp.x;
+      const s32 pos_y = m_drawing_offset.y + vp.y;
 
       const auto [texcoord_x, texcoord_y] =
         UnpackTexcoord(rc.texture_enable ? Truncate16(command_ptr[buffer_pos++]) : 0);
@@ -245,13 +253,13 @@ void GPU_HW::LoadVertices(RenderCommand rc, u32 num_vertices, const u32* command
           const s32 quad_end_x = quad_start_x + quad_width;
           const u16 tex_right = tex_left + static_cast<u16>(quad_width);
 
-          AddNewVertex(quad_start_x, quad_start_y, color, texpage, tex_left, tex_top);
-          AddNewVertex(quad_end_x, quad_start_y, color, texpage, tex_right, tex_top);
-          AddNewVertex(quad_start_x, quad_end_y, color, texpage, tex_left, tex_bottom);
+          AddNewVertex(quad_start_x, quad_start_y, color, texpage, texwindow, tex_left, tex_top);
+          AddNewVertex(quad_end_x, quad_start_y, color, texpage, texwindow, tex_right, tex_top);
+          AddNewVertex(quad_start_x, quad_end_y, color, texpage, texwindow, tex_left, tex_bottom);
 
-          AddNewVertex(quad_start_x, quad_end_y, color, texpage, tex_left, tex_bottom);
-          AddNewVertex(quad_end_x, quad_start_y, color, texpage, tex_right, tex_top);
-          AddNewVertex(quad_end_x, quad_end_y, color, texpage, tex_right, tex_bottom);
+          AddNewVertex(quad_start_x, quad_end_y, color, texpage, texwindow, tex_left, tex_bottom);
+          AddNewVertex(quad_end_x, quad_start_y, color, texpage, texwindow, tex_right, tex_top);
+          AddNewVertex(quad_end_x, quad_end_y, color, texpage, texwindow, tex_right, tex_bottom);
 
           x_offset += quad_width;
           tex_left = 0;
@@ -278,7 +286,7 @@ void GPU_HW::LoadVertices(RenderCommand rc, u32 num_vertices, const u32* command
         const VertexPosition vp{command_ptr[buffer_pos++]};
 
         BatchVertex vertex;
-        vertex.Set(vp.x, vp.y, color, 0, 0);
+        vertex.Set(m_drawing_offset.x + vp.x, m_drawing_offset.y + vp.y, color, 0, 0, 0);
 
         if (i > 0)
         {
@@ -312,17 +320,12 @@ void GPU_HW::LoadVertices(RenderCommand rc, u32 num_vertices, const u32* command
   if (min_x <= max_x)
   {
     const Common::Rectangle<u32> area_covered(
-      std::clamp(m_drawing_offset.x + min_x, static_cast<s32>(m_drawing_area.left),
-                 static_cast<s32>(m_drawing_area.right)),
-      std::clamp(m_drawing_offset.y + min_y, static_cast<s32>(m_drawing_area.top),
-                 static_cast<s32>(m_drawing_area.bottom)),
-      std::clamp(m_drawing_offset.x + max_x, static_cast<s32>(m_drawing_area.left),
-                 static_cast<s32>(m_drawing_area.right)) +
-        1,
-      std::clamp(m_drawing_offset.y + max_y, static_cast<s32>(m_drawing_area.top),
-                 static_cast<s32>(m_drawing_area.bottom)) +
-        1);
-    m_vram_dirty_rect.Include(area_covered);
+      std::clamp(min_x, static_cast<s32>(m_drawing_area.left), static_cast<s32>(m_drawing_area.right)),
+      std::clamp(min_y, static_cast<s32>(m_drawing_area.top), static_cast<s32>(m_drawing_area.bottom)),
+      std::clamp(max_x, static_cast<s32>(m_drawing_area.left), static_cast<s32>(m_drawing_area.right)) + 1,
+      std::clamp(max_y, static_cast<s32>(m_drawing_area.top), static_cast<s32>(m_drawing_area.bottom)) + 1);
+    IncludeVRAMBlocks(m_vram_dirty_blocks, area_covered);
+    m_vram_readback_dirty_rect.Include(area_covered);
   }
 }
 
@@ -350,6 +353,106 @@ Common::Rectangle<u32> GPU_HW::GetVRAMTransferBounds(u32 x, u32 y, u32 width, u3
   return out_rc;
 }
 
+/// Finds the offsets along a span where either position crosses the edge of VRAM, bracketed by the start and end.
+/// Spans are never longer than VRAM, so each position wraps at most once.
+static u32 GetWrapOffsets(u32 pos0, u32 pos1, u32 length, u32 limit, std::array<u32, 4>& offsets)
+{
+  u32 count = 0;
+  offsets[count++] = 0;
+
+  const u32 wrap0 = limit - pos0;
+  const u32 wrap1 = limit - pos1;
+  if (wrap0 < length)
+    offsets[count++] = wrap0;
+  if (wrap1 < length && wrap1 != wrap0)
+    offsets[count++] = wrap1;
+  if (count == 3 && offsets[1] > offsets[2])
+    std::swap(offsets[1], offsets[2]);
+
+  offsets[count++] = length;
+  return count;
+}
+
+/// Returns true if two spans of the same length, either of which can wrap at the edge of VRAM, share any positions.
+static bool WrappedSpansOverlap(u32 pos0, u32 pos1, u32 length, u32 limit)
+{
+  pos0 %= limit;
+  pos1 %= limit;
+  return ((pos1 + limit - pos0) % limit) < length || ((pos0 + limit - pos1) % limit) < length;
+}
+
+void GPU_HW::FillWrappedVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
+{
+  std::array<u32, 4> col_offsets, row_offsets;
+  const u32 num_cols = GetWrapOffsets(x, x, width, VRAM_WIDTH, col_offsets);
+  const u32 num_rows = GetWrapOffsets(y, y, height, VRAM_HEIGHT, row_offsets);
+  for (u32 row = 0; row < (num_rows - 1); row++)
+  {
+    for (u32 col = 0; col < (num_cols - 1); col++)
+    {
+      FillVRAM((x + col_offsets[col]) % VRAM_WIDTH, (y + row_offsets[row]) % VRAM_HEIGHT,
+               col_offsets[col + 1] - col_offsets[col], row_offsets[row + 1] - row_offsets[row], color);
+    }
+  }
+}
+
+void GPU_HW::UpdateWrappedVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
+{
+  std::array<u32, 4> col_offsets, row_offsets;
+  const u32 num_cols = GetWrapOffsets(x, x, width, VRAM_WIDTH, col_offsets);
+  const u32 num_rows = GetWrapOffsets(y, y, height, VRAM_HEIGHT, row_offsets);
+
+  // Each part is a sub-block of the source data, so it has to be made contiguous before it can be uploaded.
+  const u16* src_ptr = static_cast<const u16*>(data);
+  std::vector<u16> part_data;
+  for (u32 row = 0; row < (num_rows - 1); row++)
+  {
+    const u32 part_height = row_offsets[row + 1] - row_offsets[row];
+    for (u32 col = 0; col < (num_cols - 1); col++)
+    {
+      const u32 part_width = col_offsets[col + 1] - col_offsets[col];
+      part_data.resize(part_width * part_height);
+      for (u32 part_row = 0; part_row < part_height; part_row++)
+      {
+        std::copy_n(&src_ptr[(row_offsets[row] + part_row) * width + col_offsets[col]], part_width,
+                    &part_data[part_row * part_width]);
+      }
+
+      UpdateVRAM((x + col_offsets[col]) % VRAM_WIDTH, (y + row_offsets[row]) % VRAM_HEIGHT, part_width,
+                 part_height, part_data.data());
+    }
+  }
+}
+
+void GPU_HW::CopyWrappedVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
+{
+  // The parts are copied one after another, so when the source and destination overlap, a later part could read
+  // pixels which an earlier part has already written. Those are rare, so they're done on the CPU copy instead.
+  if (WrappedSpansOverlap(src_x, dst_x, width, VRAM_WIDTH) && WrappedSpansOverlap(src_y, dst_y, height, VRAM_HEIGHT))
+  {
+    Log_DevPrintf("Overlapping wrapped VRAM copy (%u,%u, %u,%u, %u,%u), CPU round trip", src_x, src_y, dst_x, dst_y,
+                  width, height);
+    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+    GPU::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height);
+    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    return;
+  }
+
+  // The source and destination can wrap at different offsets, giving up to nine parts.
+  std::array<u32, 4> col_offsets, row_offsets;
+  const u32 num_cols = GetWrapOffsets(src_x, dst_x, width, VRAM_WIDTH, col_offsets);
+  const u32 num_rows = GetWrapOffsets(src_y, dst_y, height, VRAM_HEIGHT, row_offsets);
+  for (u32 row = 0; row < (num_rows - 1); row++)
+  {
+    for (u32 col = 0; col < (num_cols - 1); col++)
+    {
+      CopyVRAM((src_x + col_offsets[col]) % VRAM_WIDTH, (src_y + row_offsets[row]) % VRAM_HEIGHT,
+               (dst_x + col_offsets[col]) % VRAM_WIDTH, (dst_y + row_offsets[row]) % VRAM_HEIGHT,
+               col_offsets[col + 1] - col_offsets[col], row_offsets[row + 1] - row_offsets[row]);
+    }
+  }
+}
+
 GPU_HW::BatchPrimitive GPU_HW::GetPrimitiveForCommand(RenderCommand rc)
 {
   if (rc.primitive == Primitive::Line)
@@ -360,7 +463,8 @@ GPU_HW::BatchPrimitive GPU_HW::GetPrimitiveForCommand(RenderCommand rc)
 
 void GPU_HW::IncludeVRAMDityRectangle(const Common::Rectangle<u32>& rect)
 {
-  m_vram_dirty_rect.Include(rect);
+  IncludeVRAMBlocks(m_vram_dirty_blocks, rect);
+  m_vram_readback_dirty_rect.Include(rect);
 
   // the vram area can include the texture page, but the game can leave it as-is. in this case, set it as dirty so the
   // shadow texture is updated
@@ -372,6 +476,77 @@ void GPU_HW::IncludeVRAMDityRectangle(const Common::Rectangle<u32>& rect)
   }
 }
 
+void GPU_HW::IncludeVRAMBlocks(VRAMBlockMask& mask, const Common::Rectangle<u32>& rect)
+{
+  // texture pages can extend past the right edge of VRAM
+  const u32 left = std::min<u32>(rect.left, VRAM_WIDTH);
+  const u32 top = std::min<u32>(rect.top, VRAM_HEIGHT);
+  const u32 right = std::min<u32>(rect.right, VRAM_WIDTH);
+  const u32 bottom = std::min<u32>(rect.bottom, VRAM_HEIGHT);
+  if (left >= right || top >= bottom)
+    return;
+
+  const u32 first_column = left >> VRAM_DIRTY_BLOCK_SHIFT;
+  const u32 last_column = (right - 1) >> VRAM_DIRTY_BLOCK_SHIFT;
+  const u16 row_mask = static_cast<u16>(((2u << last_column) - 1u) & ~((1u << first_column) - 1u));
+
+  const u32 last_row = (bottom - 1) >> VRAM_DIRTY_BLOCK_SHIFT;
+  for (u32 row = top >> VRAM_DIRTY_BLOCK_SHIFT; row <= last_row; row++)
+    mask[row] |= row_mask;
+}
+
+bool GPU_HW::UpdateVRAMReadTextureBlocks(const VRAMBlockMask& blocks)
+{
+  bool any_dirty = false;
+  for (u32 row = 0; row < VRAM_DIRTY_BLOCKS_Y; row++)
+    any_dirty |= ((m_vram_dirty_blocks[row] & blocks[row]) != 0);
+  if (!any_dirty)
+    return false;
+
+  if (!IsFlushed())
+    FlushRender();
+
+  VRAMBlockMask copy_blocks;
+  for (u32 row = 0; row < VRAM_DIRTY_BLOCKS_Y; row++)
+  {
+    copy_blocks[row] = m_vram_dirty_blocks[row] & blocks[row];
+    m_vram_dirty_blocks[row] &= ~blocks[row];
+  }
+
+  // Consecutive rows with the same blocks set are copied together, as are neighbouring blocks within those rows.
+  u32 row = 0;
+  while (row < VRAM_DIRTY_BLOCKS_Y)
+  {
+    const u16 row_mask = copy_blocks[row];
+    u32 end_row = row + 1;
+    while (end_row < VRAM_DIRTY_BLOCKS_Y && copy_blocks[end_row] == row_mask)
+      end_row++;
+
+    u32 column = 0;
+    while (column < VRAM_DIRTY_BLOCKS_X)
+    {
+      if (!(row_mask & (1u << column)))
+      {
+        column++;
+        continue;
+      }
+
+      u32 end_column = column + 1;
+      while (end_column < VRAM_DIRTY_BLOCKS_X && (row_mask & (1u << end_column)))
+        end_column++;
+
+      UpdateVRAMReadTexture(Common::Rectangle<u32>(
+        column * VRAM_DIRTY_BLOCK_SIZE, row * VRAM_DIRTY_BLOCK_SIZE, end_column * VRAM_DIRTY_BLOCK_SIZE,
+        end_row * VRAM_DIRTY_BLOCK_SIZE));
+      column = end_column;
+    }
+
+    row = end_row;
+  }
+
+  return true;
+}
+
 void GPU_HW::EnsureVertexBufferSpace(u32 required_vertices)
 {
   if (m_batch_current_vertex_ptr)
@@ -399,6 +574,16 @@ void GPU_HW::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
 
 void GPU_HW::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
 {
+  // Overlapping copies read from the read texture, which only matches VRAM outside the dirty blocks.
+  const Common::Rectangle<u32> src_rect = Common::Rectangle<u32>::FromExtents(src_x, src_y, width, height);
+  if (src_rect.Intersects(Common::Rectangle<u32>::FromExtents(dst_x, dst_y, width, height)))
+  {
+    VRAMBlockMask src_blocks = {};
+    IncludeVRAMBlocks(src_blocks, src_rect);
+    if (UpdateVRAMReadTextureBlocks(src_blocks))
+      m_renderer_stats.num_vram_read_texture_updates++;
+  }
+
   IncludeVRAMDityRectangle(
     Common::Rectangle<u32>::FromExtents(dst_x, dst_y, width, height).Clamped(0, 0, VRAM_WIDTH, VRAM_HEIGHT));
 }
@@ -412,17 +597,16 @@ void GPU_HW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
     if (m_draw_mode.IsTexturePageChanged())
     {
       m_draw_mode.ClearTexturePageChangedFlag();
-      if (m_vram_dirty_rect.Valid() &&
-          (m_draw_mode.GetTexturePageRectangle().Intersects(m_vram_dirty_rect) ||
-           (m_draw_mode.IsUsingPalette() && m_draw_mode.GetTexturePaletteRectangle().Intersects(m_vram_dirty_rect))))
+
+      VRAMBlockMask sampled_blocks = {};
+      IncludeVRAMBlocks(sampled_blocks, m_draw_mode.GetTexturePageRectangle());
+      if (m_draw_mode.IsUsingPalette())
+        IncludeVRAMBlocks(sampled_blocks, m_draw_mode.GetTexturePaletteRectangle());
+
+      if (UpdateVRAMReadTextureBlocks(sampled_blocks))
       {
         Log_DevPrintf("Invalidating VRAM read cache due to drawing area overlap");
-        if (!IsFlushed())
-          FlushRender();
-
-        UpdateVRAMReadTexture();
         m_renderer_stats.num_vram_read_texture_updates++;
-        ClearVRAMDirtyRectangle();
       }
     }
 
@@ -439,6 +623,7 @@ void GPU_HW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
   }
 
   // has any state changed which requires a new batch?
+  // the texture page, texture window and drawing offset are part of the vertices, so changing them doesn't need one
   const TransparencyMode transparency_mode =
     rc.transparency_enable ? m_draw_mode.GetTransparencyMode() : TransparencyMode::Disabled;
   const BatchPrimitive rc_primitive = GetPrimitiveForCommand(rc);
@@ -446,8 +631,7 @@ void GPU_HW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
   if (!IsFlushed())
   {
     if (m_batch.texture_mode != texture_mode || m_batch.transparency_mode != transparency_mode ||
-        m_batch.primitive != rc_primitive || dithering_enable != m_batch.dithering || m_drawing_area_changed ||
-        m_drawing_offset_changed || m_draw_mode.IsTextureWindowChanged())
+        m_batch.primitive != rc_primitive || dithering_enable != m_batch.dithering || m_drawing_area_changed)
     {
       FlushRender();
     }
@@ -471,31 +655,12 @@ void GPU_HW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
     m_batch_ubo_dirty = true;
   }
 
-  if (m_drawing_offset_changed)
-  {
-    m_drawing_offset_changed = false;
-    m_batch_ubo_data.u_pos_offset[0] = m_drawing_offset.x;
-    m_batch_ubo_data.u_pos_offset[1] = m_drawing_offset.y;
-    m_batch_ubo_dirty = true;
-  }
-
   // update state
   m_batch.primitive = rc_primitive;
   m_batch.texture_mode = texture_mode;
   m_batch.transparency_mode = transparency_mode;
   m_batch.dithering = dithering_enable;
 
-  if (m_draw_mode.IsTextureWindowChanged())
-  {
-    m_draw_mode.ClearTextureWindowChangedFlag();
-
-    m_batch_ubo_data.u_texture_window_mask[0] = ZeroExtend32(m_draw_mode.texture_window_mask_x);
-    m_batch_ubo_data.u_texture_window_mask[1] = ZeroExtend32(m_draw_mode.texture_window_mask_y);
-    m_batch_ubo_data.u_texture_window_offset[0] = ZeroExtend32(m_draw_mode.texture_window_offset_x);
-    m_batch_ubo_data.u_texture_window_offset[1] = ZeroExtend32(m_draw_mode.texture_window_offset_y);
-    m_batch_ubo_dirty = true;
-  }
-
   LoadVertices(rc, num_vertices, command_ptr);
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "common/heap_array.h"
 #include "gpu.h"
+#include <array>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -34,7 +35,8 @@ public:
   virtual bool Initialize(HostDisplay* host_display, System* system, DMA* dma,
                           InterruptController* interrupt_controller, Timers* timers) override;
   virtual void Reset() override;
-  virtual bool DoState(StateWrapper& sw) override;
+  virtual bool DoState(StateWrapper& sw, bool use_vram_snapshot = false) override;
+  bool SupportsVRAMSnapshots() const override;
   virtual void UpdateSettings() override;
 
 protected:
@@ -51,20 +53,23 @@ protected:
     s32 y;
     u32 color;
     u32 texpage;
-    u32 texcoord; // 16-bit texcoords are needed for 256 extent rectangles
+    u32 texcoord;  // 16-bit texcoords are needed for 256 extent rectangles
+    u32 texwindow; // GP0(E2h) value, so texture window changes don't break the batch
 
-    ALWAYS_INLINE void Set(s32 x_, s32 y_, u32 color_, u32 texpage_, u16 packed_texcoord)
+    ALWAYS_INLINE void Set(s32 x_, s32 y_, u32 color_, u32 texpage_, u32 texwindow_, u16 packed_texcoord)
     {
-      Set(x_, y_, color_, texpage_, packed_texcoord & 0xFF, (packed_texcoord >> 8));
+      Set(x_, y_, color_, texpage_, texwindow_, packed_texcoord & 0xFF, (packed_texcoord >> 8));
     }
 
-    ALWAYS_INLINE void Set(s32 x_, s32 y_, u32 color_, u32 texpage_, u16 texcoord_x, u16 texcoord_y)
+    ALWAYS_INLINE void Set(s32 x_, s32 y_, u32 color_, u32 texpage_, u32 texwindow_, u16 texcoord_x,
+                           u16 texcoord_y)
     {
       x = x_;
       y = y_;
       color = color_;
       texpage = texpage_;
       texcoord = ZeroExtend32(texcoord_x) | (ZeroExtend32(texcoord_y) << 16);
+      texwindow = texwindow_;
     }
   };
 
@@ -95,15 +100,25 @@ protected:
 
   struct BatchUBOData
   {
-    s32 u_pos_offset[2];
-    u32 u_texture_window_mask[2];
-    u32 u_texture_window_offset[2];
     float u_src_alpha_factor;
     float u_dst_alpha_factor;
     u32 u_set_mask_while_drawing;
-    u32 padding[3];
+    u32 padding;
   };
 
+  enum : u32
+  {
+    VRAM_DIRTY_BLOCK_SHIFT = 6,
+    VRAM_DIRTY_BLOCK_SIZE = 1u << VRAM_DIRTY_BLOCK_SHIFT,
+    VRAM_DIRTY_BLOCKS_X = VRAM_WIDTH / VRAM_DIRTY_BLOCK_SIZE,
+    VRAM_DIRTY_BLOCKS_Y = VRAM_HEIGHT / VRAM_DIRTY_BLOCK_SIZE,
+    VRAM_DIRTY_BLOCK_ROW_MASK = (1u << VRAM_DIRTY_BLOCKS_X) - 1u
+  };
+
+  /// One bit per VRAM block, a row of blocks per element.
+  using VRAMBlockMask = std::array<u16, VRAM_DIRTY_BLOCKS_Y>;
+  static_assert(VRAM_DIRTY_BLOCKS_X <= 16, "VRAM block row fits in mask element");
+
   struct RendererStats
   {
     u32 num_batches;
@@ -120,16 +135,20 @@ protected:
   }
 
   virtual void MapBatchVertexPointer(u32 required_vertices) = 0;
-  virtual void UpdateVRAMReadTexture() = 0;
+  /// Copies an area of VRAM, in unscaled coordinates, to the read texture.
+  virtual void UpdateVRAMReadTexture(const Common::Rectangle<u32>& rect) = 0;
 
   void SetFullVRAMDirtyRectangle()
   {
-    m_vram_dirty_rect.Set(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
+    m_vram_dirty_blocks.fill(VRAM_DIRTY_BLOCK_ROW_MASK);
+    m_vram_readback_dirty_rect.Set(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
     m_draw_mode.SetTexturePageChanged();
   }
-  void ClearVRAMDirtyRectangle() { m_vram_dirty_rect.SetInvalid(); }
   void IncludeVRAMDityRectangle(const Common::Rectangle<u32>& rect);
 
+  /// Sets the bits for the blocks which overlap the specified VRAM area.
+  static void IncludeVRAMBlocks(VRAMBlockMask& mask, const Common::Rectangle<u32>& rect);
+
   u32 GetBatchVertexSpace() const { return static_cast<u32>(m_batch_end_vertex_ptr - m_batch_current_vertex_ptr); }
   u32 GetBatchVertexCount() const { return static_cast<u32>(m_batch_current_vertex_ptr - m_batch_start_vertex_ptr); }
   void EnsureVertexBufferSpace(u32 required_vertices);
@@ -152,6 +171,11 @@ protected:
   /// Computes the area affected by a VRAM transfer, including wrap-around of X.
   Common::Rectangle<u32> GetVRAMTransferBounds(u32 x, u32 y, u32 width, u32 height);
 
+  /// Splits fills, uploads and copies which wrap around the edges of VRAM into parts which don't.
+  void FillWrappedVRAM(u32 x, u32 y, u32 width, u32 height, u32 color);
+  void UpdateWrappedVRAM(u32 x, u32 y, u32 width, u32 height, const void* data);
+  void CopyWrappedVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height);
+
   HeapArray<u16, VRAM_WIDTH * VRAM_HEIGHT> m_vram_shadow;
 
   BatchVertex* m_batch_start_vertex_ptr = nullptr;
@@ -169,8 +193,11 @@ protected:
   BatchConfig m_batch = {};
   BatchUBOData m_batch_ubo_data = {};
 
-  // Bounding box of VRAM area that the GPU has drawn into.
-  Common::Rectangle<u32> m_vram_dirty_rect;
+  // VRAM blocks that the GPU has drawn into since they were last copied to the read texture.
+  VRAMBlockMask m_vram_dirty_blocks = {};
+
+  // Bounding box of VRAM area written since the last readback into the shadow copy was started.
+  Common::Rectangle<u32> m_vram_readback_dirty_rect;
 
   // Statistics
   RendererStats m_renderer_stats = {};
@@ -190,6 +217,9 @@ private:
 
   void LoadVertices(RenderCommand rc, u32 num_vertices, const u32* command_ptr);
 
+  /// Copies the dirty blocks which are set in the mask to the read texture. Returns false if none were dirty.
+  bool UpdateVRAMReadTextureBlocks(const VRAMBlockMask& blocks);
+
   ALWAYS_INLINE void AddVertex(const BatchVertex& v)
   {
     std::memcpy(m_batch_current_vertex_ptr, &v, sizeof(BatchVertex));
@@ -2,6 +2,7 @@
 #include "common/assert.h"
 #include "common/d3d11/shader_compiler.h"
 #include "common/log.h"
+#include "common/trace.h"
 #include "gpu_hw_shadergen.h"
 #include "host_display.h"
 #include "host_interface.h"
@@ -203,6 +204,7 @@ void GPU_HW_D3D11::DestroyFramebuffer()
   m_vram_encoding_texture.Destroy();
   m_display_texture.Destroy();
   m_vram_readback_texture.Destroy();
+  m_vram_snapshot_texture.Destroy();
 }
 
 bool GPU_HW_D3D11::CreateVertexBuffer()
@@ -235,11 +237,12 @@ bool GPU_HW_D3D11::CreateTextureBuffer()
 
 bool GPU_HW_D3D11::CreateBatchInputLayout()
 {
-  static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 4> attributes = {
+  static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 5> attributes = {
     {{"ATTR", 0, DXGI_FORMAT_R32G32_SINT, 0, offsetof(BatchVertex, x), D3D11_INPUT_PER_VERTEX_DATA, 0},
      {"ATTR", 1, DXGI_FORMAT_R8G8B8A8_UNORM, 0, offsetof(BatchVertex, color), D3D11_INPUT_PER_VERTEX_DATA, 0},
      {"ATTR", 2, DXGI_FORMAT_R32_SINT, 0, offsetof(BatchVertex, texcoord), D3D11_INPUT_PER_VERTEX_DATA, 0},
-     {"ATTR", 3, DXGI_FORMAT_R32_SINT, 0, offsetof(BatchVertex, texpage), D3D11_INPUT_PER_VERTEX_DATA, 0}}};
+     {"ATTR", 3, DXGI_FORMAT_R32_SINT, 0, offsetof(BatchVertex, texpage), D3D11_INPUT_PER_VERTEX_DATA, 0},
+     {"ATTR", 4, DXGI_FORMAT_R32_SINT, 0, offsetof(BatchVertex, texwindow), D3D11_INPUT_PER_VERTEX_DATA, 0}}};
 
   // we need a vertex shader...
   GPU_HW_ShaderGen shadergen(m_host_display->GetRenderAPI(), m_resolution_scale, m_true_color, m_scaled_dithering,
@@ -497,7 +500,7 @@ void GPU_HW_D3D11::SetDrawState(BatchRenderMode render_mode)
   if (m_drawing_area_changed)
   {
     m_drawing_area_changed = false;
-    m_vram_dirty_rect.Include(m_drawing_area);
+    IncludeVRAMBlocks(m_vram_dirty_blocks, m_drawing_area);
     SetScissorFromDrawingArea();
   }
 
@@ -545,7 +548,7 @@ void GPU_HW_D3D11::UpdateDisplay()
     {
       m_host_display->ClearDisplayTexture();
     }
-    else if (!m_GPUSTAT.display_area_color_depth_24 && !interlaced)
+    else if (!m_GPUSTAT.display_area_color_depth_24 && !interlaced && m_system->GetSettings().runahead_frames == 0)
     {
       m_host_display->SetDisplayTexture(m_vram_texture.GetD3DSRV(), m_vram_texture.GetWidth(),
                                         m_vram_texture.GetHeight(), scaled_vram_offset_x, scaled_vram_offset_y,
@@ -631,15 +634,39 @@ void GPU_HW_D3D11::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
   RestoreGraphicsAPIState();
 }
 
+bool GPU_HW_D3D11::HasVRAMSnapshot() const
+{
+  return static_cast<bool>(m_vram_snapshot_texture);
+}
+
+bool GPU_HW_D3D11::SaveVRAMSnapshot()
+{
+  if (!m_vram_snapshot_texture &&
+      !m_vram_snapshot_texture.Create(m_device.Get(), m_vram_texture.GetWidth(), m_vram_texture.GetHeight(),
+                                      m_vram_texture.GetFormat(), false, false))
+  {
+    Log_ErrorPrintf("Failed to create VRAM snapshot texture");
+    return false;
+  }
+
+  m_context->CopyResource(m_vram_snapshot_texture, m_vram_texture);
+  return true;
+}
+
+bool GPU_HW_D3D11::LoadVRAMSnapshot()
+{
+  if (!m_vram_snapshot_texture)
+    return false;
+
+  m_context->CopyResource(m_vram_texture, m_vram_snapshot_texture);
+  return true;
+}
+
 void GPU_HW_D3D11::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
   if ((x + width) > VRAM_WIDTH || (y + height) > VRAM_HEIGHT)
   {
-    // CPU round trip if oversized for now.
-    Log_WarningPrintf("Oversized VRAM fill (%u-%u, %u-%u), CPU round trip", x, x + width, y, y + height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::FillVRAM(x, y, width, height, color);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    FillWrappedVRAM(x, y, width, height, color);
     return;
   }
 
@@ -663,11 +690,7 @@ void GPU_HW_D3D11::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* d
 {
   if ((x + width) > VRAM_WIDTH || (y + height) > VRAM_HEIGHT)
   {
-    // CPU round trip if oversized for now.
-    Log_WarningPrintf("Oversized VRAM update (%u-%u, %u-%u), CPU round trip", x, x + width, y, y + height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::UpdateVRAM(x, y, width, height, data);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    UpdateWrappedVRAM(x, y, width, height, data);
     return;
   }
 
@@ -694,16 +717,17 @@ void GPU_HW_D3D11::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 widt
   if ((src_x + width) > VRAM_WIDTH || (src_y + height) > VRAM_HEIGHT || (dst_x + width) > VRAM_WIDTH ||
       (dst_y + height) > VRAM_HEIGHT)
   {
-    Log_WarningPrintf("Oversized VRAM copy (%u,%u, %u,%u, %u,%u), CPU round trip", src_x, src_y, dst_x, dst_y, width,
-                      height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    CopyWrappedVRAM(src_x, src_y, dst_x, dst_y, width, height);
     return;
   }
 
   GPU_HW::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height);
 
+  // Copies within a resource are undefined when the areas overlap, so those copy from the read texture instead.
+  // GPU_HW::CopyVRAM has already refreshed the dirty blocks under the source area, so it matches VRAM there.
+  const bool overlapping = Common::Rectangle<u32>::FromExtents(src_x, src_y, width, height)
+                             .Intersects(Common::Rectangle<u32>::FromExtents(dst_x, dst_y, width, height));
+
   src_x *= m_resolution_scale;
   src_y *= m_resolution_scale;
   dst_x *= m_resolution_scale;
@@ -712,12 +736,15 @@ void GPU_HW_D3D11::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 widt
   height *= m_resolution_scale;
 
   const CD3D11_BOX src_box(src_x, src_y, 0, src_x + width, src_y + height, 1);
-  m_context->CopySubresourceRegion(m_vram_texture, 0, dst_x, dst_y, 0, m_vram_texture, 0, &src_box);
+  if (overlapping)
+    m_context->CopySubresourceRegion(m_vram_texture, 0, dst_x, dst_y, 0, m_vram_read_texture, 0, &src_box);
+  else
+    m_context->CopySubresourceRegion(m_vram_texture, 0, dst_x, dst_y, 0, m_vram_texture, 0, &src_box);
 }
 
-void GPU_HW_D3D11::UpdateVRAMReadTexture()
+void GPU_HW_D3D11::UpdateVRAMReadTexture(const Common::Rectangle<u32>& rect)
 {
-  const auto scaled_rect = m_vram_dirty_rect * m_resolution_scale;
+  const auto scaled_rect = rect * m_resolution_scale;
   const CD3D11_BOX src_box(scaled_rect.left, scaled_rect.top, 0, scaled_rect.right, scaled_rect.bottom, 1);
   m_context->CopySubresourceRegion(m_vram_read_texture, 0, scaled_rect.left, scaled_rect.top, 0, m_vram_texture, 0,
                                    &src_box);
@@ -728,6 +755,8 @@ void GPU_HW_D3D11::FlushRender()
   if (!m_batch_current_vertex_ptr)
     return;
 
+  TRACE_SCOPE("FlushRender");
+
   const u32 vertex_count = GetBatchVertexCount();
   m_vertex_stream_buffer.Unmap(m_context.Get(), vertex_count * sizeof(BatchVertex));
   m_batch_start_vertex_ptr = nullptr;
@@ -22,6 +22,7 @@ public:
   bool Initialize(HostDisplay* host_display, System* system, DMA* dma, InterruptController* interrupt_controller,
                   Timers* timers) override;
   void Reset() override;
+  bool HasVRAMSnapshot() const override;
 
   void ResetGraphicsAPIState() override;
   void RestoreGraphicsAPIState() override;
@@ -30,12 +31,14 @@ public:
 protected:
   void UpdateDisplay() override;
   void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
+  bool SaveVRAMSnapshot() override;
+  bool LoadVRAMSnapshot() override;
   void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
   void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data) override;
   void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
   void FlushRender() override;
   void MapBatchVertexPointer(u32 required_vertices) override;
-  void UpdateVRAMReadTexture() override;
+  void UpdateVRAMReadTexture(const Common::Rectangle<u32>& rect) override;
 
 private:
   enum : u32
@@ -80,6 +83,7 @@ private:
   D3D11::Texture m_vram_read_texture;
   D3D11::Texture m_vram_encoding_texture;
   D3D11::Texture m_display_texture;
+  D3D11::Texture m_vram_snapshot_texture; // created on first use
 
   D3D11::StreamBuffer m_vertex_stream_buffer;
 
@@ -1,15 +1,21 @@
 #include "gpu_hw_opengl.h"
+#include "common/align.h"
 #include "common/assert.h"
 #include "common/log.h"
+#include "common/trace.h"
 #include "gpu_hw_shadergen.h"
 #include "host_display.h"
 #include "system.h"
+#include <cstring>
+#include <new>
 Log_SetChannel(GPU_HW_OpenGL);
 
 GPU_HW_OpenGL::GPU_HW_OpenGL() : GPU_HW() {}
 
 GPU_HW_OpenGL::~GPU_HW_OpenGL()
 {
+  StopRenderThread();
+
   // Destroy objects which don't have destructors to clean them up
   if (m_vao_id != 0)
     glDeleteVertexArrays(1, &m_vao_id);
@@ -17,6 +23,10 @@ GPU_HW_OpenGL::~GPU_HW_OpenGL()
     glDeleteVertexArrays(1, &m_attributeless_vao_id);
   if (m_texture_buffer_r16ui_texture != 0)
     glDeleteTextures(1, &m_texture_buffer_r16ui_texture);
+  if (m_vram_readback_fence)
+    glDeleteSync(m_vram_readback_fence);
+  if (m_vram_readback_buffer_id != 0)
+    glDeleteBuffers(1, &m_vram_readback_buffer_id);
 
   if (m_host_display)
   {
@@ -40,6 +50,8 @@ bool GPU_HW_OpenGL::Initialize(HostDisplay* host_display, System* system, DMA* d
   if (!GPU_HW::Initialize(host_display, system, dma, interrupt_controller, timers))
     return false;
 
+  m_shader_cache.Open(m_is_gles, system->GetHostInterface()->GetUserDirectoryRelativePath("cache"));
+
   if (!CreateFramebuffer())
   {
     Log_ErrorPrintf("Failed to create framebuffer");
@@ -64,27 +76,54 @@ bool GPU_HW_OpenGL::Initialize(HostDisplay* host_display, System* system, DMA* d
     return false;
   }
 
+  if (!CreateReadbackBuffer())
+  {
+    Log_ErrorPrintf("Failed to create readback buffer");
+    return false;
+  }
+
   if (!CompilePrograms())
   {
     Log_ErrorPrintf("Failed to compile programs");
     return false;
   }
 
-  RestoreGraphicsAPIState();
+  m_drawing_area_scissor = GetDrawingAreaScissor();
+  RestoreVRAMRenderState();
+
+  if (m_system->GetSettings().gpu_use_thread)
+    StartRenderThread();
+
   return true;
 }
 
 void GPU_HW_OpenGL::Reset()
 {
+  TakeContextFromRenderThread();
+
   GPU_HW::Reset();
 
   ClearFramebuffer();
+
+  if (m_vram_readback_fence)
+  {
+    glDeleteSync(m_vram_readback_fence);
+    m_vram_readback_fence = nullptr;
+  }
+  m_vram_readback_rect.SetInvalid();
+  m_frame_vram_readback_rect.SetInvalid();
+  m_vram_readback_pending = false;
+
+  GiveContextToRenderThread();
 }
 
 void GPU_HW_OpenGL::ResetGraphicsAPIState()
 {
   GPU_HW::ResetGraphicsAPIState();
 
+  // The frontend is about to draw with the context, so it's needed back until RestoreGraphicsAPIState().
+  TakeContextFromRenderThread();
+
   glEnable(GL_CULL_FACE);
   glDisable(GL_SCISSOR_TEST);
   glDisable(GL_BLEND);
@@ -94,6 +133,13 @@ void GPU_HW_OpenGL::ResetGraphicsAPIState()
 }
 
 void GPU_HW_OpenGL::RestoreGraphicsAPIState()
+{
+  m_drawing_area_scissor = GetDrawingAreaScissor();
+  RestoreVRAMRenderState();
+  GiveContextToRenderThread();
+}
+
+void GPU_HW_OpenGL::RestoreVRAMRenderState()
 {
   m_vram_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
   glViewport(0, 0, m_vram_texture.GetWidth(), m_vram_texture.GetHeight());
@@ -106,22 +152,42 @@ void GPU_HW_OpenGL::RestoreGraphicsAPIState()
   glBindVertexArray(m_vao_id);
 
   SetScissorFromDrawingArea();
-  m_batch_ubo_dirty = true;
+  m_batch_ubo_bound = false;
 }
 
 void GPU_HW_OpenGL::UpdateSettings()
 {
+  // The render thread reads the resolution scale and programs.
+  TakeContextFromRenderThread();
+
   GPU_HW::UpdateSettings();
 
   CreateFramebuffer();
   CompilePrograms();
   UpdateDisplay();
+
+  if (m_system->GetSettings().gpu_use_thread)
+    StartRenderThread();
+  else
+    StopRenderThread();
+
+  GiveContextToRenderThread();
 }
 
 void GPU_HW_OpenGL::MapBatchVertexPointer(u32 required_vertices)
 {
   Assert(!m_batch_start_vertex_ptr);
 
+  // The stream buffer belongs to the render thread, so the batch is copied into the FIFO when it's flushed.
+  if (IsUsingRenderThread())
+  {
+    m_batch_start_vertex_ptr = m_cpu_batch_vertices.data();
+    m_batch_current_vertex_ptr = m_batch_start_vertex_ptr;
+    m_batch_end_vertex_ptr = m_batch_start_vertex_ptr + m_cpu_batch_vertices.size();
+    m_batch_base_vertex = 0;
+    return;
+  }
+
   const GL::StreamBuffer::MappingResult res =
     m_vertex_stream_buffer->Map(sizeof(BatchVertex), required_vertices * sizeof(BatchVertex));
 
@@ -173,6 +239,16 @@ void GPU_HW_OpenGL::SetCapabilities(HostDisplay* host_display)
     Log_WarningPrintf("Texture buffers are not supported, VRAM writes will be slower.");
   }
 
+  m_supports_async_readback = (GLAD_GL_VERSION_3_2 || GLAD_GL_ARB_sync || GLAD_GL_ES_VERSION_3_0);
+  if (!m_supports_async_readback)
+    Log_WarningPrintf("Sync objects are not supported, VRAM readbacks will stall.");
+
+  // Batch programs are compiled on demand, so let the driver use as many threads as it likes for them.
+  if (GLAD_GL_KHR_parallel_shader_compile)
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+  else if (GLAD_GL_ARB_parallel_shader_compile)
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+
   int max_dual_source_draw_buffers = 0;
   glGetIntegerv(GL_MAX_DUAL_SOURCE_DRAW_BUFFERS, &max_dual_source_draw_buffers);
   m_supports_dual_source_blend = (max_dual_source_draw_buffers > 0);
@@ -221,6 +297,10 @@ bool GPU_HW_OpenGL::CreateFramebuffer()
     return false;
   }
 
+  // The snapshot is at the old resolution.
+  m_vram_snapshot_texture.Destroy();
+  m_vram_snapshot_valid = false;
+
   m_vram_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
   SetFullVRAMDirtyRectangle();
   return true;
@@ -249,11 +329,14 @@ bool GPU_HW_OpenGL::CreateVertexBuffer()
   glEnableVertexAttribArray(1);
   glEnableVertexAttribArray(2);
   glEnableVertexAttribArray(3);
+  glEnableVertexAttribArray(4);
   glVertexAttribIPointer(0, 2, GL_INT, sizeof(BatchVertex), reinterpret_cast<void*>(offsetof(BatchVertex, x)));
   glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true, sizeof(BatchVertex),
                         reinterpret_cast<void*>(offsetof(BatchVertex, color)));
   glVertexAttribIPointer(2, 1, GL_INT, sizeof(BatchVertex), reinterpret_cast<void*>(offsetof(BatchVertex, texcoord)));
   glVertexAttribIPointer(3, 1, GL_INT, sizeof(BatchVertex), reinterpret_cast<void*>(offsetof(BatchVertex, texpage)));
+  glVertexAttribIPointer(4, 1, GL_INT, sizeof(BatchVertex),
+                         reinterpret_cast<void*>(offsetof(BatchVertex, texwindow)));
   glBindVertexArray(0);
 
   glGenVertexArrays(1, &m_attributeless_vao_id);
@@ -287,6 +370,19 @@ bool GPU_HW_OpenGL::CreateTextureBuffer()
   return true;
 }
 
+bool GPU_HW_OpenGL::CreateReadbackBuffer()
+{
+  if (!m_supports_async_readback)
+    return true;
+
+  // Odd widths are read as whole pairs of pixels, which can spill one pixel past the end of VRAM.
+  glGenBuffers(1, &m_vram_readback_buffer_id);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, m_vram_readback_buffer_id);
+  glBufferData(GL_PIXEL_PACK_BUFFER, (VRAM_WIDTH * VRAM_HEIGHT + 1) * sizeof(u16), nullptr, GL_STREAM_READ);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return (glGetError() == GL_NO_ERROR);
+}
+
 bool GPU_HW_OpenGL::CompilePrograms()
 {
   GPU_HW_ShaderGen shadergen(m_host_display->GetRenderAPI(), m_resolution_scale, m_true_color, m_scaled_dithering,
@@ -294,46 +390,21 @@ bool GPU_HW_OpenGL::CompilePrograms()
 
   m_system->GetHostInterface()->DisplayLoadingScreen("Compiling Shaders...");
 
-  for (u32 render_mode = 0; render_mode < 4; render_mode++)
+  // Batch programs are compiled the first time they're used, with the ubershader drawing until they're ready.
+  DestroyRenderPrograms();
+  if (!m_shader_cache.GetProgram(&m_uber_render_program, shadergen.GenerateBatchVertexShader(true),
+                                 shadergen.GenerateBatchUberFragmentShader(), [this](GL::Program& program) {
+                                   BindRenderProgramAttributes(program, true);
+                                 }))
   {
-    for (u32 texture_mode = 0; texture_mode < 9; texture_mode++)
-    {
-      for (u8 dithering = 0; dithering < 2; dithering++)
-      {
-        const bool textured = (static_cast<TextureMode>(texture_mode) != TextureMode::Disabled);
-        const std::string vs = shadergen.GenerateBatchVertexShader(textured);
-        const std::string fs = shadergen.GenerateBatchFragmentShader(static_cast<BatchRenderMode>(render_mode),
-                                                                     static_cast<TextureMode>(texture_mode),
-                                                                     ConvertToBoolUnchecked(dithering));
-
-        GL::Program& prog = m_render_programs[render_mode][texture_mode][dithering];
-        if (!prog.Compile(vs, fs))
-          return false;
-
-        prog.BindAttribute(0, "a_pos");
-        prog.BindAttribute(1, "a_col0");
-        if (textured)
-        {
-          prog.BindAttribute(2, "a_texcoord");
-          prog.BindAttribute(3, "a_texpage");
-        }
-
-        if (!m_is_gles)
-          prog.BindFragData(0, "o_col0");
-
-        if (!prog.Link())
-          return false;
-
-        prog.BindUniformBlock("UBOBlock", 1);
-        if (textured)
-        {
-          prog.Bind();
-          prog.Uniform1i("samp0", 0);
-        }
-      }
-    }
+    return false;
   }
 
+  SetupRenderProgram(m_uber_render_program, true);
+  m_uber_render_program.RegisterUniform("u_render_mode");
+  m_uber_render_program.RegisterUniform("u_texture_mode");
+  m_uber_render_program.RegisterUniform("u_dithering");
+
   for (u8 depth_24bit = 0; depth_24bit < 2; depth_24bit++)
   {
     for (u8 interlaced = 0; interlaced < 2; interlaced++)
@@ -342,24 +413,23 @@ bool GPU_HW_OpenGL::CompilePrograms()
       const std::string vs = shadergen.GenerateScreenQuadVertexShader();
       const std::string fs = shadergen.GenerateDisplayFragmentShader(ConvertToBoolUnchecked(depth_24bit),
                                                                      ConvertToBoolUnchecked(interlaced));
-      if (!prog.Compile(vs, fs))
-        return false;
-
-      if (!m_is_gles)
+      if (!m_shader_cache.GetProgram(&prog, vs, fs, [this](GL::Program& program) {
+            if (!m_is_gles)
+            {
+              if (m_supports_dual_source_blend)
+              {
+                program.BindFragDataIndexed(0, "o_col0");
+                program.BindFragDataIndexed(1, "o_col1");
+              }
+              else
+              {
+                program.BindFragData(0, "o_col0");
+              }
+            }
+          }))
       {
-        if (m_supports_dual_source_blend)
-        {
-          prog.BindFragDataIndexed(0, "o_col0");
-          prog.BindFragDataIndexed(1, "o_col1");
-        }
-        else
-        {
-          prog.BindFragData(0, "o_col0");
-        }
-      }
-
-      if (!prog.Link())
         return false;
+      }
 
       prog.BindUniformBlock("UBOBlock", 1);
 
@@ -368,18 +438,15 @@ bool GPU_HW_OpenGL::CompilePrograms()
     }
   }
 
-  if (!m_vram_read_program.Compile(shadergen.GenerateScreenQuadVertexShader(),
-                                   shadergen.GenerateVRAMReadFragmentShader()))
+  if (!m_shader_cache.GetProgram(&m_vram_read_program, shadergen.GenerateScreenQuadVertexShader(),
+                                 shadergen.GenerateVRAMReadFragmentShader(), [this](GL::Program& program) {
+                                   if (!m_is_gles)
+                                     program.BindFragData(0, "o_col0");
+                                 }))
   {
     return false;
   }
 
-  if (!m_is_gles)
-    m_vram_read_program.BindFragData(0, "o_col0");
-
-  if (!m_vram_read_program.Link())
-    return false;
-
   m_vram_read_program.BindUniformBlock("UBOBlock", 1);
 
   m_vram_read_program.Bind();
@@ -387,18 +454,15 @@ bool GPU_HW_OpenGL::CompilePrograms()
 
   if (m_supports_texture_buffer)
   {
-    if (!m_vram_write_program.Compile(shadergen.GenerateScreenQuadVertexShader(),
-                                      shadergen.GenerateVRAMWriteFragmentShader()))
+    if (!m_shader_cache.GetProgram(&m_vram_write_program, shadergen.GenerateScreenQuadVertexShader(),
+                                   shadergen.GenerateVRAMWriteFragmentShader(), [this](GL::Program& program) {
+                                     if (!m_is_gles)
+                                       program.BindFragData(0, "o_col0");
+                                   }))
     {
       return false;
     }
 
-    if (!m_is_gles)
-      m_vram_write_program.BindFragData(0, "o_col0");
-
-    if (!m_vram_write_program.Link())
-      return false;
-
     m_vram_write_program.BindUniformBlock("UBOBlock", 1);
 
     m_vram_write_program.Bind();
@@ -408,16 +472,141 @@ bool GPU_HW_OpenGL::CompilePrograms()
   return true;
 }
 
-void GPU_HW_OpenGL::SetDrawState(BatchRenderMode render_mode)
+void GPU_HW_OpenGL::DestroyRenderPrograms()
+{
+  for (u32 render_mode = 0; render_mode < 4; render_mode++)
+  {
+    for (u32 texture_mode = 0; texture_mode < 9; texture_mode++)
+    {
+      for (u8 dithering = 0; dithering < 2; dithering++)
+      {
+        m_render_programs[render_mode][texture_mode][dithering].Destroy();
+        m_render_program_states[render_mode][texture_mode][dithering] = RenderProgramState::NotCompiled;
+      }
+    }
+  }
+
+  m_pending_render_programs.clear();
+  m_uber_render_program.Destroy();
+}
+
+void GPU_HW_OpenGL::BindRenderProgramAttributes(GL::Program& prog, bool textured)
+{
+  prog.BindAttribute(0, "a_pos");
+  prog.BindAttribute(1, "a_col0");
+  if (textured)
+  {
+    prog.BindAttribute(2, "a_texcoord");
+    prog.BindAttribute(3, "a_texpage");
+    prog.BindAttribute(4, "a_texwindow");
+  }
+
+  if (!m_is_gles)
+    prog.BindFragData(0, "o_col0");
+}
+
+void GPU_HW_OpenGL::SetupRenderProgram(GL::Program& prog, bool textured)
+{
+  prog.BindUniformBlock("UBOBlock", 1);
+  if (textured)
+  {
+    prog.Bind();
+    prog.Uniform1i("samp0", 0);
+  }
+}
+
+const GL::Program& GPU_HW_OpenGL::GetRenderProgram(const BatchConfig& batch, BatchRenderMode render_mode)
+{
+  const u8 render_mode_index = static_cast<u8>(render_mode);
+  const u8 texture_mode_index = static_cast<u8>(batch.texture_mode);
+  const u8 dithering_index = BoolToUInt8(batch.dithering);
+  const RenderProgramState state = m_render_program_states[render_mode_index][texture_mode_index][dithering_index];
+  if (state == RenderProgramState::Ready)
+    return m_render_programs[render_mode_index][texture_mode_index][dithering_index];
+
+  if (state == RenderProgramState::NotCompiled)
+  {
+    StartCompilingRenderProgram(render_mode_index, texture_mode_index, dithering_index);
+    if (m_render_program_states[render_mode_index][texture_mode_index][dithering_index] == RenderProgramState::Ready)
+      return m_render_programs[render_mode_index][texture_mode_index][dithering_index];
+  }
+
+  m_uber_render_program.Bind();
+  m_uber_render_program.Uniform1i(0, render_mode_index);
+  m_uber_render_program.Uniform1i(1, texture_mode_index);
+  m_uber_render_program.Uniform1i(2, dithering_index);
+  return m_uber_render_program;
+}
+
+void GPU_HW_OpenGL::StartCompilingRenderProgram(u8 render_mode, u8 texture_mode, u8 dithering)
+{
+  GPU_HW_ShaderGen shadergen(m_host_display->GetRenderAPI(), m_resolution_scale, m_true_color, m_scaled_dithering,
+                             m_texture_filtering, m_supports_dual_source_blend);
+
+  const bool textured = (static_cast<TextureMode>(texture_mode) != TextureMode::Disabled);
+  std::string vs = shadergen.GenerateBatchVertexShader(textured);
+  std::string fs = shadergen.GenerateBatchFragmentShader(static_cast<BatchRenderMode>(render_mode),
+                                                         static_cast<TextureMode>(texture_mode),
+                                                         ConvertToBoolUnchecked(dithering));
+
+  GL::Program& prog = m_render_programs[render_mode][texture_mode][dithering];
+  RenderProgramState& state = m_render_program_states[render_mode][texture_mode][dithering];
+  if (m_shader_cache.GetCachedProgram(&prog, vs, fs))
+  {
+    SetupRenderProgram(prog, textured);
+    state = RenderProgramState::Ready;
+    return;
+  }
+
+  prog.StartCompile(vs, fs);
+  BindRenderProgramAttributes(prog, textured);
+  if (m_shader_cache.IsOpen())
+    prog.SetBinaryRetrievableHint();
+  prog.StartLink();
+
+  state = RenderProgramState::Compiling;
+  m_pending_render_programs.push_back({render_mode, texture_mode, dithering, std::move(vs), std::move(fs)});
+}
+
+void GPU_HW_OpenGL::FinishCompilingRenderPrograms()
+{
+  for (auto iter = m_pending_render_programs.begin(); iter != m_pending_render_programs.end();)
+  {
+    GL::Program& prog = m_render_programs[iter->render_mode][iter->texture_mode][iter->dithering];
+    if (!prog.IsLinkComplete())
+    {
+      ++iter;
+      continue;
+    }
+
+    RenderProgramState& state = m_render_program_states[iter->render_mode][iter->texture_mode][iter->dithering];
+    if (prog.FinishLink())
+    {
+      m_shader_cache.AddProgram(&prog, iter->vertex_shader, iter->fragment_shader);
+      SetupRenderProgram(prog, static_cast<TextureMode>(iter->texture_mode) != TextureMode::Disabled);
+      state = RenderProgramState::Ready;
+    }
+    else
+    {
+      Log_ErrorPrintf("Failed to compile batch program %u/%u/%u, using the ubershader", iter->render_mode,
+                      iter->texture_mode, iter->dithering);
+      state = RenderProgramState::Failed;
+    }
+
+    iter = m_pending_render_programs.erase(iter);
+  }
+}
+
+void GPU_HW_OpenGL::SetDrawState(const DrawBatchCommand* cmd, BatchRenderMode render_mode)
 {
-  const GL::Program& prog = m_render_programs[static_cast<u8>(render_mode)][static_cast<u8>(m_batch.texture_mode)]
-                                             [BoolToUInt8(m_batch.dithering)];
+  const BatchConfig& batch = cmd->batch;
+  const GL::Program& prog = GetRenderProgram(batch, render_mode);
   prog.Bind();
 
-  if (m_batch.texture_mode != TextureMode::Disabled)
+  if (batch.texture_mode != TextureMode::Disabled)
     m_vram_read_texture.Bind();
 
-  if (m_batch.transparency_mode == TransparencyMode::Disabled || render_mode == BatchRenderMode::OnlyOpaque)
+  if (batch.transparency_mode == TransparencyMode::Disabled || render_mode == BatchRenderMode::OnlyOpaque)
   {
     glDisable(GL_BLEND);
   }
@@ -425,26 +614,25 @@ void GPU_HW_OpenGL::SetDrawState(BatchRenderMode render_mode)
   {
     glEnable(GL_BLEND);
     glBlendEquationSeparate(
-      m_batch.transparency_mode == TransparencyMode::BackgroundMinusForeground ? GL_FUNC_REVERSE_SUBTRACT : GL_FUNC_ADD,
+      batch.transparency_mode == TransparencyMode::BackgroundMinusForeground ? GL_FUNC_REVERSE_SUBTRACT : GL_FUNC_ADD,
       GL_FUNC_ADD);
     glBlendFuncSeparate(GL_ONE, m_supports_dual_source_blend ? GL_SRC1_ALPHA : GL_SRC_ALPHA, GL_ONE, GL_ZERO);
   }
 
-  if (m_drawing_area_changed)
+  if (cmd->drawing_area_changed)
   {
-    m_drawing_area_changed = false;
-    m_vram_dirty_rect.Include(m_drawing_area);
+    m_drawing_area_scissor = cmd->scissor;
     SetScissorFromDrawingArea();
   }
 
-  if (m_batch_ubo_dirty)
+  if (cmd->ubo_dirty || !m_batch_ubo_bound)
   {
-    UploadUniformBlock(&m_batch_ubo_data, sizeof(m_batch_ubo_data));
-    m_batch_ubo_dirty = false;
+    UploadUniformBlock(&cmd->ubo_data, sizeof(cmd->ubo_data));
+    m_batch_ubo_bound = true;
   }
 }
 
-void GPU_HW_OpenGL::SetScissorFromDrawingArea()
+std::array<GLint, 4> GPU_HW_OpenGL::GetDrawingAreaScissor()
 {
   int left, top, right, bottom;
   CalcScissorRect(&left, &top, &right, &bottom);
@@ -453,7 +641,12 @@ void GPU_HW_OpenGL::SetScissorFromDrawingArea()
   const int height = bottom - top;
   const int x = left;
   const int y = m_vram_texture.GetHeight() - bottom;
+  return {x, y, width, height};
+}
 
+void GPU_HW_OpenGL::SetScissorFromDrawingArea()
+{
+  const auto [x, y, width, height] = m_drawing_area_scissor;
   Log_DebugPrintf("SetScissor: (%d-%d, %d-%d)", x, x + width, y, y + height);
   glScissor(x, y, width, height);
 }
@@ -466,6 +659,7 @@ void GPU_HW_OpenGL::UploadUniformBlock(const void* data, u32 data_size)
 
   glBindBufferRange(GL_UNIFORM_BUFFER, 1, m_uniform_stream_buffer->GetGLBufferId(), res.buffer_offset, data_size);
 
+  m_batch_ubo_bound = false;
   m_renderer_stats.num_uniform_buffer_updates++;
 }
 
@@ -473,6 +667,24 @@ void GPU_HW_OpenGL::UpdateDisplay()
 {
   GPU_HW::UpdateDisplay();
 
+  // Games which read VRAM back usually read the same area every frame, so start on the next one now. It's redone when
+  // the CPU asks for it if the area is drawn to in the meantime.
+  if (m_frame_vram_readback_rect.Valid())
+  {
+    if (!m_vram_readback_rect.Contains(m_frame_vram_readback_rect) ||
+        m_vram_readback_dirty_rect.Intersects(m_vram_readback_rect))
+    {
+      StartVRAMReadback(m_frame_vram_readback_rect);
+    }
+
+    m_frame_vram_readback_rect.SetInvalid();
+  }
+
+  // The display texture is only drawn to when the host display can't show VRAM directly, but the render thread checks
+  // for compiled programs at the same time.
+  UpdateDisplayCommand* cmd = AllocateCommand<UpdateDisplayCommand>(CommandType::UpdateDisplay);
+  cmd->reinterpret = false;
+
   if (m_system->GetSettings().debugging.show_vram)
   {
     m_host_display->SetDisplayTexture(reinterpret_cast<void*>(static_cast<uintptr_t>(m_vram_texture.GetGLId())),
@@ -499,7 +711,7 @@ void GPU_HW_OpenGL::UpdateDisplay()
     {
       m_host_display->ClearDisplayTexture();
     }
-    else if (!m_GPUSTAT.display_area_color_depth_24 && !interlaced)
+    else if (!m_GPUSTAT.display_area_color_depth_24 && !interlaced && m_system->GetSettings().runahead_frames == 0)
     {
       m_host_display->SetDisplayTexture(reinterpret_cast<void*>(static_cast<uintptr_t>(m_vram_texture.GetGLId())),
                                         m_vram_texture.GetWidth(), m_vram_texture.GetHeight(), scaled_vram_offset_x,
@@ -508,79 +720,240 @@ void GPU_HW_OpenGL::UpdateDisplay()
     }
     else
     {
-      const u32 flipped_vram_offset_y = VRAM_HEIGHT - vram_offset_y - display_height;
-      const u32 scaled_flipped_vram_offset_y =
-        m_vram_texture.GetHeight() - scaled_vram_offset_y - scaled_display_height;
-      const u32 field_offset = BoolToUInt8(interlaced && m_GPUSTAT.interlaced_field);
-
-      glDisable(GL_BLEND);
-      glDisable(GL_SCISSOR_TEST);
-
-      const GL::Program& prog =
-        m_display_programs[BoolToUInt8(m_GPUSTAT.display_area_color_depth_24)][BoolToUInt8(interlaced)];
-      prog.Bind();
-
-      // Because of how the reinterpret shader works, we need to use the downscaled version.
+      cmd->reinterpret = true;
+      cmd->depth_24 = m_GPUSTAT.display_area_color_depth_24;
+      cmd->interlaced = interlaced;
+      cmd->vram_offset_x = vram_offset_x;
+      cmd->vram_offset_y = vram_offset_y;
+      cmd->display_width = display_width;
+      cmd->display_height = display_height;
+      cmd->field_offset = BoolToUInt8(interlaced && m_GPUSTAT.interlaced_field);
+
+      // Because of how the reinterpret shader works, 24-bit output is drawn at 1x.
       if (m_GPUSTAT.display_area_color_depth_24 && m_resolution_scale > 1)
       {
-        const u32 copy_width = std::min<u32>((display_width * 3) / 2, VRAM_WIDTH - vram_offset_x);
-        const u32 scaled_copy_width = copy_width * m_resolution_scale;
-        m_vram_encoding_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
-        m_vram_texture.BindFramebuffer(GL_READ_FRAMEBUFFER);
-        glBlitFramebuffer(scaled_vram_offset_x, scaled_flipped_vram_offset_y, scaled_vram_offset_x + scaled_copy_width,
-                          scaled_flipped_vram_offset_y + scaled_display_height, vram_offset_x, flipped_vram_offset_y,
-                          vram_offset_x + copy_width, flipped_vram_offset_y + display_height, GL_COLOR_BUFFER_BIT,
-                          GL_NEAREST);
-
-        m_display_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
-        m_vram_encoding_texture.Bind();
-
-        glViewport(0, field_offset, display_width, display_height);
-
-        const u32 uniforms[4] = {vram_offset_x, flipped_vram_offset_y, field_offset};
-        UploadUniformBlock(uniforms, sizeof(uniforms));
-        m_batch_ubo_dirty = true;
-
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-
         m_host_display->SetDisplayTexture(reinterpret_cast<void*>(static_cast<uintptr_t>(m_display_texture.GetGLId())),
                                           m_display_texture.GetWidth(), m_display_texture.GetHeight(), 0,
                                           display_height, display_width, -static_cast<s32>(display_height));
       }
       else
       {
-        m_display_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
-        m_vram_texture.Bind();
-
-        glViewport(0, field_offset, scaled_display_width, scaled_display_height);
-
-        const u32 uniforms[4] = {scaled_vram_offset_x, scaled_flipped_vram_offset_y, field_offset};
-        UploadUniformBlock(uniforms, sizeof(uniforms));
-        m_batch_ubo_dirty = true;
-
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-
         m_host_display->SetDisplayTexture(reinterpret_cast<void*>(static_cast<uintptr_t>(m_display_texture.GetGLId())),
                                           m_display_texture.GetWidth(), m_display_texture.GetHeight(), 0,
                                           scaled_display_height, scaled_display_width,
                                           -static_cast<s32>(scaled_display_height));
       }
-
-      // restore state
-      m_vram_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
-      glViewport(0, 0, m_vram_texture.GetWidth(), m_vram_texture.GetHeight());
-      glEnable(GL_SCISSOR_TEST);
     }
 
     m_host_display->SetDisplayParameters(m_crtc_state.visible_display_width, m_crtc_state.visible_display_height,
                                          m_crtc_state.GetActiveDisplayRectangle(), m_crtc_state.display_aspect_ratio);
   }
+
+  PushCommand(cmd);
+}
+
+void GPU_HW_OpenGL::UpdateDisplayImpl(const UpdateDisplayCommand* cmd)
+{
+  FinishCompilingRenderPrograms();
+
+  if (!cmd->reinterpret)
+    return;
+
+  const u32 vram_offset_x = cmd->vram_offset_x;
+  const u32 vram_offset_y = cmd->vram_offset_y;
+  const u32 scaled_vram_offset_x = vram_offset_x * m_resolution_scale;
+  const u32 scaled_vram_offset_y = vram_offset_y * m_resolution_scale;
+  const u32 display_width = cmd->display_width;
+  const u32 display_height = cmd->display_height;
+  const u32 scaled_display_width = display_width * m_resolution_scale;
+  const u32 scaled_display_height = display_height * m_resolution_scale;
+  const u32 flipped_vram_offset_y = VRAM_HEIGHT - vram_offset_y - display_height;
+  const u32 scaled_flipped_vram_offset_y = m_vram_texture.GetHeight() - scaled_vram_offset_y - scaled_display_height;
+  const u32 field_offset = cmd->field_offset;
+
+  glDisable(GL_BLEND);
+  glDisable(GL_SCISSOR_TEST);
+
+  const GL::Program& prog = m_display_programs[BoolToUInt8(cmd->depth_24)][BoolToUInt8(cmd->interlaced)];
+  prog.Bind();
+
+  // Because of how the reinterpret shader works, we need to use the downscaled version.
+  if (cmd->depth_24 && m_resolution_scale > 1)
+  {
+    const u32 copy_width = std::min<u32>((display_width * 3) / 2, VRAM_WIDTH - vram_offset_x);
+    const u32 scaled_copy_width = copy_width * m_resolution_scale;
+    m_vram_encoding_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
+    m_vram_texture.BindFramebuffer(GL_READ_FRAMEBUFFER);
+    glBlitFramebuffer(scaled_vram_offset_x, scaled_flipped_vram_offset_y, scaled_vram_offset_x + scaled_copy_width,
+                      scaled_flipped_vram_offset_y + scaled_display_height, vram_offset_x, flipped_vram_offset_y,
+                      vram_offset_x + copy_width, flipped_vram_offset_y + display_height, GL_COLOR_BUFFER_BIT,
+                      GL_NEAREST);
+
+    m_display_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
+    m_vram_encoding_texture.Bind();
+
+    glViewport(0, field_offset, display_width, display_height);
+
+    const u32 uniforms[4] = {vram_offset_x, flipped_vram_offset_y, field_offset};
+    UploadUniformBlock(uniforms, sizeof(uniforms));
+
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+  else
+  {
+    m_display_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
+    m_vram_texture.Bind();
+
+    glViewport(0, field_offset, scaled_display_width, scaled_display_height);
+
+    const u32 uniforms[4] = {scaled_vram_offset_x, scaled_flipped_vram_offset_y, field_offset};
+    UploadUniformBlock(uniforms, sizeof(uniforms));
+
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+  }
+
+  // restore state
+  m_vram_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
+  glViewport(0, 0, m_vram_texture.GetWidth(), m_vram_texture.GetHeight());
+  glEnable(GL_SCISSOR_TEST);
 }
 
 void GPU_HW_OpenGL::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
 {
-  // Get bounds with wrap-around handled.
+  RectCommand* cmd = AllocateCommand<RectCommand>(CommandType::ReadVRAM);
+  cmd->rect = GetVRAMTransferBounds(x, y, width, height); // wrap-around handled
+  PushCommand(cmd);
+
+  // The shadow copy is written by the render thread.
+  SyncRenderThread();
+}
+
+void GPU_HW_OpenGL::BeginReadVRAM(u32 x, u32 y, u32 width, u32 height)
+{
+  if (!m_supports_async_readback)
+  {
+    ReadVRAM(x, y, width, height);
+    return;
+  }
+
   const Common::Rectangle<u32> copy_rect = GetVRAMTransferBounds(x, y, width, height);
+  m_frame_vram_readback_rect.Include(copy_rect);
+
+  // The last readback is still current if nothing has been written to it since, which is usually the case for the
+  // speculative readback started at the end of the previous frame.
+  if (m_vram_readback_rect.Contains(copy_rect) && !m_vram_readback_dirty_rect.Intersects(m_vram_readback_rect))
+    return;
+
+  StartVRAMReadback(copy_rect);
+}
+
+void GPU_HW_OpenGL::EndReadVRAM()
+{
+  if (!m_vram_readback_pending)
+    return;
+
+  m_vram_readback_pending = false;
+
+  // Loading a state replaces the shadow copy, which is then newer than the readback.
+  if (m_vram_readback_dirty_rect.Intersects(m_vram_readback_rect))
+  {
+    m_vram_readback_rect.SetInvalid();
+    return;
+  }
+
+  RectCommand* cmd = AllocateCommand<RectCommand>(CommandType::EndVRAMReadback);
+  cmd->rect = m_vram_readback_rect;
+  PushCommand(cmd);
+
+  // The shadow copy is written by the render thread.
+  SyncRenderThread();
+}
+
+void GPU_HW_OpenGL::EndVRAMReadbackImpl(const Common::Rectangle<u32>& rect)
+{
+  glClientWaitSync(m_vram_readback_fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+  glDeleteSync(m_vram_readback_fence);
+  m_vram_readback_fence = nullptr;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, m_vram_readback_buffer_id);
+  const u16* src_ptr = static_cast<const u16*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+                                                                rect.top * VRAM_WIDTH * sizeof(u16),
+                                                                rect.GetHeight() * VRAM_WIDTH * sizeof(u16),
+                                                                GL_MAP_READ_BIT));
+  if (src_ptr)
+  {
+    for (u32 row = 0; row < rect.GetHeight(); row++)
+    {
+      std::copy_n(&src_ptr[row * VRAM_WIDTH + rect.left], rect.GetWidth(),
+                  &m_vram_shadow[(rect.top + row) * VRAM_WIDTH + rect.left]);
+    }
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  else
+  {
+    // The emulation thread is waiting for this command, so it's safe to drop the readback from here.
+    Log_ErrorPrintf("Failed to map VRAM readback buffer");
+    m_vram_readback_rect.SetInvalid();
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool GPU_HW_OpenGL::HasVRAMSnapshot() const
+{
+  return m_vram_snapshot_valid;
+}
+
+bool GPU_HW_OpenGL::SaveVRAMSnapshot()
+{
+  PushCommand(AllocateCommand<Command>(CommandType::SaveVRAMSnapshot));
+
+  // The texture is created by the first save after the framebuffer is, so find out whether that worked.
+  if (!m_vram_snapshot_valid)
+  {
+    SyncRenderThread();
+    if (!m_vram_snapshot_texture.IsValid())
+      return false;
+  }
+
+  m_vram_snapshot_valid = true;
+  return true;
+}
+
+void GPU_HW_OpenGL::SaveVRAMSnapshotImpl()
+{
+  if (!m_vram_snapshot_texture.IsValid() &&
+      (!m_vram_snapshot_texture.Create(m_vram_texture.GetWidth(), m_vram_texture.GetHeight(), GL_RGBA,
+                                       GL_UNSIGNED_BYTE, nullptr, false) ||
+       !m_vram_snapshot_texture.CreateFramebuffer()))
+  {
+    Log_ErrorPrintf("Failed to create VRAM snapshot texture");
+    m_vram_snapshot_texture.Destroy();
+    return;
+  }
+
+  CopyTextureRegion(m_vram_texture, m_vram_snapshot_texture, 0, 0, 0, 0, m_vram_texture.GetWidth(),
+                    m_vram_texture.GetHeight());
+}
+
+bool GPU_HW_OpenGL::LoadVRAMSnapshot()
+{
+  if (!m_vram_snapshot_valid)
+    return false;
+
+  PushCommand(AllocateCommand<Command>(CommandType::LoadVRAMSnapshot));
+  return true;
+}
+
+void GPU_HW_OpenGL::LoadVRAMSnapshotImpl()
+{
+  CopyTextureRegion(m_vram_snapshot_texture, m_vram_texture, 0, 0, 0, 0, m_vram_texture.GetWidth(),
+                    m_vram_texture.GetHeight());
+}
+
+void GPU_HW_OpenGL::ReadEncodedVRAM(const Common::Rectangle<u32>& copy_rect, void* out_data)
+{
   const u32 encoded_width = (copy_rect.GetWidth() + 1) / 2;
   const u32 encoded_height = copy_rect.GetHeight();
 
@@ -600,27 +973,62 @@ void GPU_HW_OpenGL::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
   m_vram_encoding_texture.BindFramebuffer(GL_READ_FRAMEBUFFER);
   glPixelStorei(GL_PACK_ALIGNMENT, 2);
   glPixelStorei(GL_PACK_ROW_LENGTH, VRAM_WIDTH / 2);
-  glReadPixels(0, 0, encoded_width, encoded_height, GL_RGBA, GL_UNSIGNED_BYTE,
-               &m_vram_shadow[copy_rect.top * VRAM_WIDTH + copy_rect.left]);
+  glReadPixels(0, 0, encoded_width, encoded_height, GL_RGBA, GL_UNSIGNED_BYTE, out_data);
   glPixelStorei(GL_PACK_ALIGNMENT, 4);
   glPixelStorei(GL_PACK_ROW_LENGTH, 0);
-  RestoreGraphicsAPIState();
+  RestoreVRAMRenderState();
+}
+
+void GPU_HW_OpenGL::StartVRAMReadback(const Common::Rectangle<u32>& copy_rect)
+{
+  // Queued draws have already been counted as writes, so they need to land before the readback.
+  FlushRender();
+
+  RectCommand* cmd = AllocateCommand<RectCommand>(CommandType::StartVRAMReadback);
+  cmd->rect = copy_rect;
+  PushCommand(cmd);
+
+  m_vram_readback_rect = copy_rect;
+  m_vram_readback_dirty_rect.SetInvalid();
+  m_vram_readback_pending = true;
+}
+
+void GPU_HW_OpenGL::StartVRAMReadbackImpl(const Common::Rectangle<u32>& copy_rect)
+{
+  if (m_vram_readback_fence)
+    glDeleteSync(m_vram_readback_fence);
+
+  const uintptr_t offset = (copy_rect.top * VRAM_WIDTH + copy_rect.left) * sizeof(u16);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, m_vram_readback_buffer_id);
+  ReadEncodedVRAM(copy_rect, reinterpret_cast<void*>(offset));
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  // Flush so the GPU gets on with it while we keep emulating.
+  m_vram_readback_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
 }
 
 void GPU_HW_OpenGL::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
   if ((x + width) > VRAM_WIDTH || (y + height) > VRAM_HEIGHT)
   {
-    // CPU round trip if oversized for now.
-    Log_WarningPrintf("Oversized VRAM fill (%u-%u, %u-%u), CPU round trip", x, x + width, y, y + height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::FillVRAM(x, y, width, height, color);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    FillWrappedVRAM(x, y, width, height, color);
     return;
   }
 
   GPU_HW::FillVRAM(x, y, width, height, color);
 
+  FillVRAMCommand* cmd = AllocateCommand<FillVRAMCommand>(CommandType::FillVRAM);
+  cmd->x = x;
+  cmd->y = y;
+  cmd->width = width;
+  cmd->height = height;
+  cmd->color = color;
+  PushCommand(cmd);
+}
+
+void GPU_HW_OpenGL::FillVRAMImpl(u32 x, u32 y, u32 width, u32 height, u32 color)
+{
   // scale coordinates
   x *= m_resolution_scale;
   y *= m_resolution_scale;
@@ -644,16 +1052,36 @@ void GPU_HW_OpenGL::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void*
 {
   if ((x + width) > VRAM_WIDTH || (y + height) > VRAM_HEIGHT)
   {
-    // CPU round trip if oversized for now.
-    Log_WarningPrintf("Oversized VRAM update (%u-%u, %u-%u), CPU round trip", x, x + width, y, y + height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::UpdateVRAM(x, y, width, height, data);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    UpdateWrappedVRAM(x, y, width, height, data);
     return;
   }
 
   GPU_HW::UpdateVRAM(x, y, width, height, data);
 
+  UpdateVRAMCommand* cmd;
+  if (m_render_thread_has_context)
+  {
+    const u32 data_size = width * height * sizeof(u16);
+    cmd = AllocateCommand<UpdateVRAMCommand>(CommandType::UpdateVRAM, sizeof(UpdateVRAMCommand) + data_size);
+    std::memcpy(cmd + 1, data, data_size);
+    cmd->data = cmd + 1;
+  }
+  else
+  {
+    // Executed before returning, so the data can be read in place.
+    cmd = AllocateCommand<UpdateVRAMCommand>(CommandType::UpdateVRAM);
+    cmd->data = data;
+  }
+
+  cmd->x = x;
+  cmd->y = y;
+  cmd->width = width;
+  cmd->height = height;
+  PushCommand(cmd);
+}
+
+void GPU_HW_OpenGL::UpdateVRAMImpl(u32 x, u32 y, u32 width, u32 height, const void* data)
+{
   const u32 num_pixels = width * height;
   if (num_pixels < m_max_texture_buffer_size)
   {
@@ -681,7 +1109,7 @@ void GPU_HW_OpenGL::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void*
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
-    RestoreGraphicsAPIState();
+    RestoreVRAMRenderState();
   }
   else
   {
@@ -746,16 +1174,29 @@ void GPU_HW_OpenGL::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wid
   if ((src_x + width) > VRAM_WIDTH || (src_y + height) > VRAM_HEIGHT || (dst_x + width) > VRAM_WIDTH ||
       (dst_y + height) > VRAM_HEIGHT)
   {
-    Log_WarningPrintf("Oversized VRAM copy (%u,%u, %u,%u, %u,%u), CPU round trip", src_x, src_y, dst_x, dst_y, width,
-                      height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    CopyWrappedVRAM(src_x, src_y, dst_x, dst_y, width, height);
     return;
   }
 
   GPU_HW::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height);
 
+  CopyVRAMCommand* cmd = AllocateCommand<CopyVRAMCommand>(CommandType::CopyVRAM);
+  cmd->src_x = src_x;
+  cmd->src_y = src_y;
+  cmd->dst_x = dst_x;
+  cmd->dst_y = dst_y;
+  cmd->width = width;
+  cmd->height = height;
+  PushCommand(cmd);
+}
+
+void GPU_HW_OpenGL::CopyVRAMImpl(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
+{
+  // Copies within a texture are undefined when the areas overlap, so those copy from the read texture instead.
+  // GPU_HW::CopyVRAM has already refreshed the dirty blocks under the source area, so it matches VRAM there.
+  const bool overlapping = Common::Rectangle<u32>::FromExtents(src_x, src_y, width, height)
+                             .Intersects(Common::Rectangle<u32>::FromExtents(dst_x, dst_y, width, height));
+
   src_x *= m_resolution_scale;
   src_y *= m_resolution_scale;
   dst_x *= m_resolution_scale;
@@ -767,50 +1208,50 @@ void GPU_HW_OpenGL::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wid
   src_y = m_vram_texture.GetHeight() - src_y - height;
   dst_y = m_vram_texture.GetHeight() - dst_y - height;
 
-  if (GLAD_GL_VERSION_4_3)
-  {
-    glCopyImageSubData(m_vram_texture.GetGLId(), GL_TEXTURE_2D, 0, src_x, src_y, 0, m_vram_texture.GetGLId(),
-                       GL_TEXTURE_2D, 0, dst_x, dst_y, 0, width, height, 1);
-  }
-  else if (GLAD_GL_EXT_copy_image)
-  {
-    glCopyImageSubDataEXT(m_vram_texture.GetGLId(), GL_TEXTURE_2D, 0, src_x, src_y, 0, m_vram_texture.GetGLId(),
-                          GL_TEXTURE_2D, 0, dst_x, dst_y, 0, width, height, 1);
-  }
+  if (overlapping)
+    CopyTextureRegion(m_vram_read_texture, m_vram_texture, src_x, src_y, dst_x, dst_y, width, height);
   else
-  {
-    glDisable(GL_SCISSOR_TEST);
-    m_vram_texture.BindFramebuffer(GL_READ_FRAMEBUFFER);
-    glBlitFramebuffer(src_x, src_y, src_x + width, src_y + height, dst_x, dst_y, dst_x + width, dst_y + height,
-                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    glEnable(GL_SCISSOR_TEST);
-  }
+    CopyTextureRegion(m_vram_texture, m_vram_texture, src_x, src_y, dst_x, dst_y, width, height);
 }
 
-void GPU_HW_OpenGL::UpdateVRAMReadTexture()
+void GPU_HW_OpenGL::UpdateVRAMReadTexture(const Common::Rectangle<u32>& rect)
 {
-  const auto scaled_rect = m_vram_dirty_rect * m_resolution_scale;
+  RectCommand* cmd = AllocateCommand<RectCommand>(CommandType::UpdateVRAMReadTexture);
+  cmd->rect = rect;
+  PushCommand(cmd);
+}
+
+void GPU_HW_OpenGL::UpdateVRAMReadTextureImpl(const Common::Rectangle<u32>& rect)
+{
+  const auto scaled_rect = rect * m_resolution_scale;
   const u32 width = scaled_rect.GetWidth();
   const u32 height = scaled_rect.GetHeight();
   const u32 x = scaled_rect.left;
   const u32 y = m_vram_texture.GetHeight() - scaled_rect.top - height;
 
+  CopyTextureRegion(m_vram_texture, m_vram_read_texture, x, y, x, y, width, height);
+}
+
+void GPU_HW_OpenGL::CopyTextureRegion(GL::Texture& src, GL::Texture& dst, u32 src_x, u32 src_y, u32 dst_x,
+                                      u32 dst_y, u32 width, u32 height)
+{
   if (GLAD_GL_VERSION_4_3)
   {
-    glCopyImageSubData(m_vram_texture.GetGLId(), GL_TEXTURE_2D, 0, x, y, 0, m_vram_read_texture.GetGLId(),
-                       GL_TEXTURE_2D, 0, x, y, 0, width, height, 1);
+    glCopyImageSubData(src.GetGLId(), GL_TEXTURE_2D, 0, src_x, src_y, 0, dst.GetGLId(), GL_TEXTURE_2D, 0, dst_x,
+                       dst_y, 0, width, height, 1);
   }
   else if (GLAD_GL_EXT_copy_image)
   {
-    glCopyImageSubDataEXT(m_vram_texture.GetGLId(), GL_TEXTURE_2D, 0, x, y, 0, m_vram_read_texture.GetGLId(),
-                          GL_TEXTURE_2D, 0, x, y, 0, width, height, 1);
+    glCopyImageSubDataEXT(src.GetGLId(), GL_TEXTURE_2D, 0, src_x, src_y, 0, dst.GetGLId(), GL_TEXTURE_2D, 0, dst_x,
+                          dst_y, 0, width, height, 1);
   }
   else
   {
-    m_vram_read_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
-    m_vram_texture.BindFramebuffer(GL_READ_FRAMEBUFFER);
+    dst.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
+    src.BindFramebuffer(GL_READ_FRAMEBUFFER);
     glDisable(GL_SCISSOR_TEST);
-    glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBlitFramebuffer(src_x, src_y, src_x + width, src_y + height, dst_x, dst_y, dst_x + width, dst_y + height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
     glEnable(GL_SCISSOR_TEST);
     m_vram_texture.BindFramebuffer(GL_FRAMEBUFFER);
   }
@@ -818,33 +1259,405 @@ void GPU_HW_OpenGL::UpdateVRAMReadTexture()
 
 void GPU_HW_OpenGL::FlushRender()
 {
-  static constexpr std::array<GLenum, 4> gl_primitives = {{GL_LINES, GL_LINE_STRIP, GL_TRIANGLES, GL_TRIANGLE_STRIP}};
-
   if (!m_batch_current_vertex_ptr)
     return;
 
+  TRACE_SCOPE("FlushRender");
+
+  const BatchVertex* vertices = m_batch_start_vertex_ptr;
   const u32 vertex_count = GetBatchVertexCount();
-  m_vertex_stream_buffer->Unmap(vertex_count * sizeof(BatchVertex));
   m_batch_start_vertex_ptr = nullptr;
   m_batch_end_vertex_ptr = nullptr;
   m_batch_current_vertex_ptr = nullptr;
   if (vertex_count == 0)
+  {
+    if (!IsUsingRenderThread())
+      m_vertex_stream_buffer->Unmap(0);
+
     return;
+  }
 
-  m_vertex_stream_buffer->Bind();
   m_renderer_stats.num_batches++;
 
-  if (m_batch.NeedsTwoPassRendering())
+  // Batches built on the CPU are copied into the FIFO, unless the command is executed before returning.
+  const u32 vertices_size =
+    (IsUsingRenderThread() && m_render_thread_has_context) ? (vertex_count * sizeof(BatchVertex)) : 0;
+  DrawBatchCommand* cmd =
+    AllocateCommand<DrawBatchCommand>(CommandType::DrawBatch, sizeof(DrawBatchCommand) + vertices_size);
+  cmd->batch = m_batch;
+  cmd->ubo_data = m_batch_ubo_data;
+  cmd->ubo_dirty = m_batch_ubo_dirty;
+  cmd->drawing_area_changed = m_drawing_area_changed;
+  if (vertices_size > 0)
   {
-    SetDrawState(BatchRenderMode::OnlyTransparent);
-    glDrawArrays(gl_primitives[static_cast<u8>(m_batch.primitive)], m_batch_base_vertex, vertex_count);
-    SetDrawState(BatchRenderMode::OnlyOpaque);
-    glDrawArrays(gl_primitives[static_cast<u8>(m_batch.primitive)], m_batch_base_vertex, vertex_count);
+    std::memcpy(cmd + 1, vertices, vertices_size);
+    cmd->vertices = reinterpret_cast<const BatchVertex*>(cmd + 1);
   }
   else
   {
-    SetDrawState(m_batch.GetRenderMode());
-    glDrawArrays(gl_primitives[static_cast<u8>(m_batch.primitive)], m_batch_base_vertex, vertex_count);
+    cmd->vertices = IsUsingRenderThread() ? vertices : nullptr;
+  }
+  cmd->base_vertex = m_batch_base_vertex;
+  cmd->num_vertices = vertex_count;
+  m_batch_ubo_dirty = false;
+
+  if (m_drawing_area_changed)
+  {
+    m_drawing_area_changed = false;
+    IncludeVRAMBlocks(m_vram_dirty_blocks, m_drawing_area);
+    cmd->scissor = GetDrawingAreaScissor();
+  }
+
+  PushCommand(cmd);
+}
+
+void GPU_HW_OpenGL::DrawBatchImpl(const DrawBatchCommand* cmd)
+{
+  static constexpr std::array<GLenum, 4> gl_primitives = {{GL_LINES, GL_LINE_STRIP, GL_TRIANGLES, GL_TRIANGLE_STRIP}};
+
+  const u32 vertex_count = cmd->num_vertices;
+  u32 base_vertex = cmd->base_vertex;
+  if (cmd->vertices)
+  {
+    const u32 vertices_size = vertex_count * sizeof(BatchVertex);
+    const GL::StreamBuffer::MappingResult res = m_vertex_stream_buffer->Map(sizeof(BatchVertex), vertices_size);
+    std::memcpy(res.pointer, cmd->vertices, vertices_size);
+    m_vertex_stream_buffer->Unmap(vertices_size);
+    base_vertex = res.index_aligned;
+  }
+  else
+  {
+    m_vertex_stream_buffer->Unmap(vertex_count * sizeof(BatchVertex));
+  }
+
+  m_vertex_stream_buffer->Bind();
+
+  const GLenum primitive = gl_primitives[static_cast<u8>(cmd->batch.primitive)];
+  if (cmd->batch.NeedsTwoPassRendering())
+  {
+    SetDrawState(cmd, BatchRenderMode::OnlyTransparent);
+    glDrawArrays(primitive, base_vertex, vertex_count);
+    SetDrawState(cmd, BatchRenderMode::OnlyOpaque);
+    glDrawArrays(primitive, base_vertex, vertex_count);
+  }
+  else
+  {
+    SetDrawState(cmd, cmd->batch.GetRenderMode());
+    glDrawArrays(primitive, base_vertex, vertex_count);
+  }
+}
+
+void GPU_HW_OpenGL::DrawRendererStats(bool is_idle_frame)
+{
+  // Uniform buffer updates are counted by the render thread.
+  SyncRenderThread();
+  GPU_HW::DrawRendererStats(is_idle_frame);
+}
+
+template<typename T>
+T* GPU_HW_OpenGL::AllocateCommand(CommandType type, u32 size /* = sizeof(T) */)
+{
+  size = Common::AlignUpPow2(size, COMMAND_ALIGNMENT);
+
+  T* cmd = new (AllocateFIFOSpace(size)) T();
+  cmd->type = type;
+  cmd->size = size;
+  return cmd;
+}
+
+void* GPU_HW_OpenGL::AllocateFIFOSpace(u32 size)
+{
+  if (!m_render_thread_has_context)
+    return m_command_fifo.data();
+
+  DebugAssert(size < COMMAND_FIFO_SIZE);
+
+  for (;;)
+  {
+    const u32 read_ptr = m_command_fifo_read_ptr.load();
+    const u32 write_ptr = m_command_fifo_write_ptr.load();
+    if (read_ptr > write_ptr)
+    {
+      // The write pointer can't catch up to the read pointer, otherwise the FIFO would appear empty.
+      if ((write_ptr + size) < read_ptr)
+        return &m_command_fifo[write_ptr];
+    }
+    else
+    {
+      if ((write_ptr + size) < COMMAND_FIFO_SIZE)
+        return &m_command_fifo[write_ptr];
+
+      // Not enough space at the end, so continue from the start once the render thread has moved off it.
+      if (read_ptr > 0)
+      {
+        Command* cmd = reinterpret_cast<Command*>(&m_command_fifo[write_ptr]);
+        cmd->type = CommandType::Wraparound;
+        cmd->size = 0;
+        m_command_fifo_write_ptr.store(0);
+        if (m_render_thread_sleeping.load())
+        {
+          std::unique_lock<std::mutex> lock(m_render_thread_mutex);
+          m_render_thread_wake_cv.notify_one();
+        }
+
+        continue;
+      }
+    }
+
+    // FIFO is full, wait for the render thread to drain it.
+    Log_DevPrintf("Command FIFO full, waiting for render thread");
+    SyncRenderThread();
+  }
+}
+
+void GPU_HW_OpenGL::PushCommand(Command* cmd)
+{
+  if (!m_render_thread_has_context)
+  {
+    ExecuteCommand(cmd);
+    return;
+  }
+
+  const u32 write_ptr = static_cast<u32>(reinterpret_cast<u8*>(cmd) - m_command_fifo.data()) + cmd->size;
+  m_command_fifo_write_ptr.store(write_ptr);
+  if (m_render_thread_sleeping.load())
+  {
+    std::unique_lock<std::mutex> lock(m_render_thread_mutex);
+    m_render_thread_wake_cv.notify_one();
+  }
+}
+
+void GPU_HW_OpenGL::ExecuteCommand(const Command* cmd)
+{
+  switch (cmd->type)
+  {
+    case CommandType::AcquireContext:
+    {
+      if (!m_host_display->MakeRenderContextCurrent())
+        Panic("Failed to make the context current on the render thread");
+    }
+    break;
+
+    case CommandType::ReleaseContext:
+      m_host_display->DoneRenderContextCurrent();
+      break;
+
+    case CommandType::DrawBatch:
+      DrawBatchImpl(static_cast<const DrawBatchCommand*>(cmd));
+      break;
+
+    case CommandType::FillVRAM:
+    {
+      const FillVRAMCommand* fill = static_cast<const FillVRAMCommand*>(cmd);
+      FillVRAMImpl(fill->x, fill->y, fill->width, fill->height, fill->color);
+    }
+    break;
+
+    case CommandType::UpdateVRAM:
+    {
+      const UpdateVRAMCommand* update = static_cast<const UpdateVRAMCommand*>(cmd);
+      UpdateVRAMImpl(update->x, update->y, update->width, update->height, update->data);
+    }
+    break;
+
+    case CommandType::CopyVRAM:
+    {
+      const CopyVRAMCommand* copy = static_cast<const CopyVRAMCommand*>(cmd);
+      CopyVRAMImpl(copy->src_x, copy->src_y, copy->dst_x, copy->dst_y, copy->width, copy->height);
+    }
+    break;
+
+    case CommandType::UpdateVRAMReadTexture:
+      UpdateVRAMReadTextureImpl(static_cast<const RectCommand*>(cmd)->rect);
+      break;
+
+    case CommandType::UpdateDisplay:
+      UpdateDisplayImpl(static_cast<const UpdateDisplayCommand*>(cmd));
+      break;
+
+    case CommandType::ReadVRAM:
+    {
+      const Common::Rectangle<u32>& rect = static_cast<const RectCommand*>(cmd)->rect;
+      ReadEncodedVRAM(rect, &m_vram_shadow[rect.top * VRAM_WIDTH + rect.left]);
+    }
+    break;
+
+    case CommandType::StartVRAMReadback:
+      StartVRAMReadbackImpl(static_cast<const RectCommand*>(cmd)->rect);
+      break;
+
+    case CommandType::EndVRAMReadback:
+      EndVRAMReadbackImpl(static_cast<const RectCommand*>(cmd)->rect);
+      break;
+
+    case CommandType::SaveVRAMSnapshot:
+      SaveVRAMSnapshotImpl();
+      break;
+
+    case CommandType::LoadVRAMSnapshot:
+      LoadVRAMSnapshotImpl();
+      break;
+
+    default:
+      UnreachableCode();
+      break;
+  }
+}
+
+void GPU_HW_OpenGL::StartRenderThread()
+{
+  if (IsUsingRenderThread())
+    return;
+
+  // The render thread would only compete with the emulation thread for the one core.
+  if (std::thread::hardware_concurrency() < 2)
+  {
+    Log_WarningPrintf("Only one host CPU is available, not using a GPU render thread");
+    return;
+  }
+
+  // Batches which were started in the stream buffer are drawn before switching to building them on the CPU.
+  FlushRender();
+
+  if (!m_host_display->DoneRenderContextCurrent())
+  {
+    Log_WarningPrintf("Host display can't move its context to another thread, not using a GPU render thread");
+    return;
+  }
+
+  m_command_fifo_read_ptr.store(0);
+  m_command_fifo_write_ptr.store(0);
+  m_render_thread_sleeping.store(false);
+  m_render_thread_shutdown_flag.store(false);
+  m_cpu_batch_vertices.resize(VERTEX_BUFFER_SIZE / sizeof(BatchVertex));
+
+  std::promise<bool> context_promise;
+  std::future<bool> context_future = context_promise.get_future();
+  m_render_thread = std::thread(&GPU_HW_OpenGL::RenderThreadEntryPoint, this, &context_promise);
+  if (!context_future.get())
+  {
+    Log_ErrorPrintf("Failed to make the context current on the render thread, not using it");
+    m_render_thread.join();
+    m_host_display->MakeRenderContextCurrent();
+    return;
+  }
+
+  Log_InfoPrintf("Using GPU render thread");
+  m_render_thread_has_context = true;
+}
+
+void GPU_HW_OpenGL::StopRenderThread()
+{
+  if (!IsUsingRenderThread())
+    return;
+
+  // CPU-side batches are only drawn from the FIFO.
+  FlushRender();
+  TakeContextFromRenderThread();
+
+  {
+    std::unique_lock<std::mutex> lock(m_render_thread_mutex);
+    m_render_thread_shutdown_flag.store(true);
+    m_render_thread_wake_cv.notify_one();
+  }
+
+  m_render_thread.join();
+  m_cpu_batch_vertices = {};
+}
+
+void GPU_HW_OpenGL::SyncRenderThread()
+{
+  if (!m_render_thread_has_context || m_command_fifo_read_ptr.load() == m_command_fifo_write_ptr.load())
+    return;
+
+  TRACE_SCOPE("SyncRenderThread");
+  std::unique_lock<std::mutex> lock(m_render_thread_mutex);
+  m_render_thread_idle_cv.wait(
+    lock, [this]() { return m_command_fifo_read_ptr.load() == m_command_fifo_write_ptr.load(); });
+}
+
+void GPU_HW_OpenGL::TakeContextFromRenderThread()
+{
+  if (!m_render_thread_has_context)
+    return;
+
+  PushCommand(AllocateCommand<Command>(CommandType::ReleaseContext));
+  SyncRenderThread();
+
+  m_render_thread_has_context = false;
+  if (!m_host_display->MakeRenderContextCurrent())
+    Panic("Failed to take the context back from the render thread");
+}
+
+void GPU_HW_OpenGL::GiveContextToRenderThread()
+{
+  if (!IsUsingRenderThread() || m_render_thread_has_context)
+    return;
+
+  m_host_display->DoneRenderContextCurrent();
+  m_render_thread_has_context = true;
+  PushCommand(AllocateCommand<Command>(CommandType::AcquireContext));
+}
+
+void GPU_HW_OpenGL::RenderThreadEntryPoint(std::promise<bool>* context_promise)
+{
+  // Commands tend to arrive in bursts, so spin for a little while before going to sleep.
+  static constexpr u32 SPIN_COUNT = 1000;
+
+  Trace::SetThreadName("GPU Render");
+
+  const bool has_context = m_host_display->MakeRenderContextCurrent();
+  context_promise->set_value(has_context);
+  if (!has_context)
+    return;
+
+  for (;;)
+  {
+    u32 read_ptr = m_command_fifo_read_ptr.load();
+    const u32 write_ptr = m_command_fifo_write_ptr.load();
+    if (read_ptr != write_ptr)
+    {
+      TRACE_SCOPE("ExecuteCommands");
+      while (read_ptr != write_ptr)
+      {
+        const Command* cmd = reinterpret_cast<const Command*>(&m_command_fifo[read_ptr]);
+        if (cmd->type == CommandType::Wraparound)
+        {
+          read_ptr = 0;
+        }
+        else
+        {
+          ExecuteCommand(cmd);
+          read_ptr += cmd->size;
+        }
+
+        m_command_fifo_read_ptr.store(read_ptr);
+      }
+
+      continue;
+    }
+
+    // wake up anyone waiting for us to finish
+    {
+      std::unique_lock<std::mutex> lock(m_render_thread_mutex);
+      m_render_thread_idle_cv.notify_all();
+    }
+
+    for (u32 i = 0; i < SPIN_COUNT && m_command_fifo_write_ptr.load() == read_ptr; i++)
+      std::this_thread::yield();
+    if (m_command_fifo_write_ptr.load() != read_ptr)
+      continue;
+
+    std::unique_lock<std::mutex> lock(m_render_thread_mutex);
+    m_render_thread_sleeping.store(true);
+    m_render_thread_wake_cv.wait(lock, [this]() {
+      return (m_render_thread_shutdown_flag.load() ||
+              m_command_fifo_read_ptr.load() != m_command_fifo_write_ptr.load());
+    });
+    m_render_thread_sleeping.store(false);
+
+    if (m_render_thread_shutdown_flag.load())
+      break;
   }
 }
 
@@ -1,12 +1,19 @@
 #pragma once
 #include "common/gl/program.h"
+#include "common/gl/shader_cache.h"
 #include "common/gl/stream_buffer.h"
 #include "common/gl/texture.h"
 #include "glad.h"
 #include "gpu_hw.h"
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <tuple>
+#include <vector>
 
 class GPU_HW_OpenGL : public GPU_HW
 {
@@ -17,6 +24,7 @@ public:
   bool Initialize(HostDisplay* host_display, System* system, DMA* dma, InterruptController* interrupt_controller,
                   Timers* timers) override;
   void Reset() override;
+  bool HasVRAMSnapshot() const override;
 
   void ResetGraphicsAPIState() override;
   void RestoreGraphicsAPIState() override;
@@ -25,14 +33,36 @@ public:
 protected:
   void UpdateDisplay() override;
   void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
+  void BeginReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
+  void EndReadVRAM() override;
+  bool SaveVRAMSnapshot() override;
+  bool LoadVRAMSnapshot() override;
   void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
   void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data) override;
   void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
   void FlushRender() override;
   void MapBatchVertexPointer(u32 required_vertices) override;
-  void UpdateVRAMReadTexture() override;
+  void UpdateVRAMReadTexture(const Common::Rectangle<u32>& rect) override;
+  void DrawRendererStats(bool is_idle_frame) override;
 
 private:
+  enum class RenderProgramState : u8
+  {
+    NotCompiled,
+    Compiling,
+    Ready,
+    Failed
+  };
+
+  struct PendingRenderProgram
+  {
+    u8 render_mode;
+    u8 texture_mode;
+    u8 dithering;
+    std::string vertex_shader;
+    std::string fragment_shader;
+  };
+
   struct GLStats
   {
     u32 num_batches;
@@ -43,6 +73,121 @@ private:
     u32 num_uniform_buffer_updates;
   };
 
+  //////////////////////////////////////////////////////////////////////////
+  // Command FIFO
+  //////////////////////////////////////////////////////////////////////////
+  enum : u32
+  {
+    COMMAND_FIFO_SIZE = 4 * 1024 * 1024,
+    COMMAND_ALIGNMENT = 8
+  };
+
+  enum class CommandType : u8
+  {
+    Wraparound,
+    AcquireContext,
+    ReleaseContext,
+    DrawBatch,
+    FillVRAM,
+    UpdateVRAM,
+    CopyVRAM,
+    UpdateVRAMReadTexture,
+    UpdateDisplay,
+    ReadVRAM,
+    StartVRAMReadback,
+    EndVRAMReadback,
+    SaveVRAMSnapshot,
+    LoadVRAMSnapshot
+  };
+
+  struct Command
+  {
+    CommandType type;
+    u32 size;
+  };
+
+  // Followed by num_vertices vertices when the batch was built on the CPU rather than in the stream buffer.
+  struct DrawBatchCommand : Command
+  {
+    BatchConfig batch;
+    BatchUBOData ubo_data;
+    bool ubo_dirty;
+    bool drawing_area_changed;
+    std::array<GLint, 4> scissor; // x, y, width, height of the drawing area, when it changed
+    const BatchVertex* vertices;  // null when they're already in the stream buffer
+    u32 base_vertex;
+    u32 num_vertices;
+  };
+
+  struct FillVRAMCommand : Command
+  {
+    u32 x, y, width, height;
+    u32 color;
+  };
+
+  // Followed by the pixels when the data can't be read in place.
+  struct UpdateVRAMCommand : Command
+  {
+    u32 x, y, width, height;
+    const void* data;
+  };
+
+  struct CopyVRAMCommand : Command
+  {
+    u32 src_x, src_y, dst_x, dst_y, width, height;
+  };
+
+  struct RectCommand : Command
+  {
+    Common::Rectangle<u32> rect;
+  };
+
+  struct UpdateDisplayCommand : Command
+  {
+    bool reinterpret; // otherwise only the programs are checked, as the display shows VRAM directly
+    bool depth_24;
+    bool interlaced;
+    u32 vram_offset_x, vram_offset_y;
+    u32 display_width, display_height;
+    u32 field_offset;
+  };
+
+  /// Returns true if commands are being executed by the render thread, rather than on the calling thread.
+  bool IsUsingRenderThread() const { return m_render_thread.joinable(); }
+
+  /// Reserves space for a command. When the render thread isn't running or doesn't have the context, the start of the
+  /// FIFO is used as scratch.
+  template<typename T>
+  T* AllocateCommand(CommandType type, u32 size = sizeof(T));
+  void* AllocateFIFOSpace(u32 size);
+
+  /// Executes the command immediately, or hands it to the render thread.
+  void PushCommand(Command* cmd);
+  void ExecuteCommand(const Command* cmd);
+
+  void StartRenderThread();
+  void StopRenderThread();
+  void RenderThreadEntryPoint(std::promise<bool>* context_promise);
+
+  /// Blocks until the render thread has executed all queued commands.
+  void SyncRenderThread();
+
+  /// Moves the GL context from the render thread to the calling thread, so the frontend or a state change can use it.
+  /// Commands are executed immediately until it's given back.
+  void TakeContextFromRenderThread();
+  void GiveContextToRenderThread();
+
+  void DrawBatchImpl(const DrawBatchCommand* cmd);
+  void FillVRAMImpl(u32 x, u32 y, u32 width, u32 height, u32 color);
+  void UpdateVRAMImpl(u32 x, u32 y, u32 width, u32 height, const void* data);
+  void CopyVRAMImpl(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height);
+  void UpdateVRAMReadTextureImpl(const Common::Rectangle<u32>& rect);
+  void UpdateDisplayImpl(const UpdateDisplayCommand* cmd);
+  void StartVRAMReadbackImpl(const Common::Rectangle<u32>& copy_rect);
+  void EndVRAMReadbackImpl(const Common::Rectangle<u32>& rect);
+  void SaveVRAMSnapshotImpl();
+  void LoadVRAMSnapshotImpl();
+
   std::tuple<s32, s32> ConvertToFramebufferCoordinates(s32 x, s32 y);
 
   void SetCapabilities(HostDisplay* host_display);
@@ -52,17 +197,48 @@ private:
   bool CreateVertexBuffer();
   bool CreateUniformBuffer();
   bool CreateTextureBuffer();
+  bool CreateReadbackBuffer();
 
   bool CompilePrograms();
-  void SetDrawState(BatchRenderMode render_mode);
+  void DestroyRenderPrograms();
+  void BindRenderProgramAttributes(GL::Program& prog, bool textured);
+  void SetupRenderProgram(GL::Program& prog, bool textured);
+
+  /// Returns the program for the batch. Draws with the ubershader while the specialised one is compiling.
+  const GL::Program& GetRenderProgram(const BatchConfig& batch, BatchRenderMode render_mode);
+  void StartCompilingRenderProgram(u8 render_mode, u8 texture_mode, u8 dithering);
+
+  /// Switches to the specialised programs which have finished compiling. Without parallel compile support this can't
+  /// be checked, so it waits for them instead, which is usually quick as the driver has had a frame to compile them.
+  void FinishCompilingRenderPrograms();
+
+  void SetDrawState(const DrawBatchCommand* cmd, BatchRenderMode render_mode);
+
+  /// Returns the scissor rectangle for the current drawing area, in framebuffer coordinates.
+  std::array<GLint, 4> GetDrawingAreaScissor();
   void SetScissorFromDrawingArea();
+
+  /// Sets up the state for drawing to VRAM, after the frontend or a copy has changed it.
+  void RestoreVRAMRenderState();
+
   void UploadUniformBlock(const void* data, u32 data_size);
 
+  /// Copies a region between textures, in framebuffer coordinates.
+  void CopyTextureRegion(GL::Texture& src, GL::Texture& dst, u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width,
+                         u32 height);
+
+  /// Encodes the area of VRAM as 16-bit and reads it into out_data, which is an offset when a pack buffer is bound.
+  void ReadEncodedVRAM(const Common::Rectangle<u32>& copy_rect, void* out_data);
+
+  /// Starts reading the area of VRAM into the readback buffer, replacing any readback which is in progress.
+  void StartVRAMReadback(const Common::Rectangle<u32>& copy_rect);
+
   // downsample texture - used for readbacks at >1xIR.
   GL::Texture m_vram_texture;
   GL::Texture m_vram_read_texture;
   GL::Texture m_vram_encoding_texture;
   GL::Texture m_display_texture;
+  GL::Texture m_vram_snapshot_texture; // created on first use
 
   std::unique_ptr<GL::StreamBuffer> m_vertex_stream_buffer;
   GLuint m_vao_id = 0;
@@ -73,7 +249,19 @@ private:
   std::unique_ptr<GL::StreamBuffer> m_texture_stream_buffer;
   GLuint m_texture_buffer_r16ui_texture = 0;
 
+  // Pixel pack buffer which VRAM is read back into asynchronously, laid out like the shadow copy.
+  GLuint m_vram_readback_buffer_id = 0;
+  GLsync m_vram_readback_fence = nullptr;         // signalled when the readback has completed
+  Common::Rectangle<u32> m_vram_readback_rect;       // area of the last readback, in the buffer or the shadow copy
+  Common::Rectangle<u32> m_frame_vram_readback_rect; // area read back by the CPU since the last display update
+  bool m_vram_readback_pending = false;              // readback started but not yet copied to the shadow copy
+  bool m_vram_snapshot_valid = false;
+
+  GL::ShaderCache m_shader_cache;
   std::array<std::array<std::array<GL::Program, 2>, 9>, 4> m_render_programs; // [render_mode][texture_mode][dithering]
+  std::array<std::array<std::array<RenderProgramState, 2>, 9>, 4> m_render_program_states{};
+  std::vector<PendingRenderProgram> m_pending_render_programs;
+  GL::Program m_uber_render_program;
   std::array<std::array<GL::Program, 2>, 2> m_display_programs;               // [depth_24][interlaced]
   GL::Program m_vram_read_program;
   GL::Program m_vram_write_program;
@@ -83,4 +271,24 @@ private:
 
   bool m_is_gles = false;
   bool m_supports_texture_buffer = false;
+  bool m_supports_async_readback = false;
+
+  // State of the context, which is only touched by whichever thread is executing commands.
+  std::array<GLint, 4> m_drawing_area_scissor = {};
+  bool m_batch_ubo_bound = false;
+
+  // Batches are built here instead of the stream buffer while the render thread is running.
+  std::vector<BatchVertex> m_cpu_batch_vertices;
+
+  HeapArray<u8, COMMAND_FIFO_SIZE> m_command_fifo;
+  std::atomic<u32> m_command_fifo_read_ptr{0};
+  std::atomic<u32> m_command_fifo_write_ptr{0};
+
+  std::thread m_render_thread;
+  std::mutex m_render_thread_mutex;
+  std::condition_variable m_render_thread_wake_cv;
+  std::condition_variable m_render_thread_idle_cv;
+  std::atomic_bool m_render_thread_sleeping{false};
+  std::atomic_bool m_render_thread_shutdown_flag{false};
+  bool m_render_thread_has_context = false;
 };
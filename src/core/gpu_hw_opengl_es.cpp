@@ -1,6 +1,7 @@
 #include "gpu_hw_opengl_es.h"
 #include "common/assert.h"
 #include "common/log.h"
+#include "common/trace.h"
 #include "gpu_hw_shadergen.h"
 #include "host_display.h"
 #include "system.h"
@@ -32,6 +33,8 @@ bool GPU_HW_OpenGL_ES::Initialize(HostDisplay* host_display, System* system, DMA
   if (!GPU_HW::Initialize(host_display, system, dma, interrupt_controller, timers))
     return false;
 
+  m_shader_cache.Open(true, system->GetHostInterface()->GetUserDirectoryRelativePath("cache"));
+
   if (!CreateFramebuffer())
   {
     Log_ErrorPrintf("Failed to create framebuffer");
@@ -69,6 +72,7 @@ void GPU_HW_OpenGL_ES::ResetGraphicsAPIState()
   glDisableVertexAttribArray(1);
   glDisableVertexAttribArray(2);
   glDisableVertexAttribArray(3);
+  glDisableVertexAttribArray(4);
 }
 
 void GPU_HW_OpenGL_ES::RestoreGraphicsAPIState()
@@ -170,6 +174,9 @@ bool GPU_HW_OpenGL_ES::CreateFramebuffer()
     return false;
   }
 
+  // The snapshot is at the old resolution.
+  m_vram_snapshot_texture.Destroy();
+
   m_vram_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
   SetFullVRAMDirtyRectangle();
   return true;
@@ -202,25 +209,22 @@ bool GPU_HW_OpenGL_ES::CompilePrograms()
                                                                      ConvertToBoolUnchecked(dithering));
 
         GL::Program& prog = m_render_programs[render_mode][texture_mode][dithering];
-        if (!prog.Compile(vs, fs))
-          return false;
-
-        prog.BindAttribute(0, "a_pos");
-        prog.BindAttribute(1, "a_col0");
-        if (textured)
+        if (!m_shader_cache.GetProgram(&prog, vs, fs, [textured](GL::Program& program) {
+              program.BindAttribute(0, "a_pos");
+              program.BindAttribute(1, "a_col0");
+              if (textured)
+              {
+                program.BindAttribute(2, "a_texcoord");
+                program.BindAttribute(3, "a_texpage");
+                program.BindAttribute(4, "a_texwindow");
+              }
+            }))
         {
-          prog.BindAttribute(2, "a_texcoord");
-          prog.BindAttribute(3, "a_texpage");
-        }
-
-        if (!prog.Link())
           return false;
+        }
 
         prog.Bind();
 
-        prog.RegisterUniform("u_pos_offset");
-        prog.RegisterUniform("u_texture_window_mask");
-        prog.RegisterUniform("u_texture_window_offset");
         prog.RegisterUniform("u_src_alpha_factor");
         prog.RegisterUniform("u_dst_alpha_factor");
         prog.RegisterUniform("u_set_mask_while_drawing");
@@ -239,10 +243,7 @@ bool GPU_HW_OpenGL_ES::CompilePrograms()
       const std::string vs = shadergen.GenerateScreenQuadVertexShader();
       const std::string fs = shadergen.GenerateDisplayFragmentShader(ConvertToBoolUnchecked(depth_24bit),
                                                                      ConvertToBoolUnchecked(interlaced));
-      if (!prog.Compile(vs, fs))
-        return false;
-
-      if (!prog.Link())
+      if (!m_shader_cache.GetProgram(&prog, vs, fs))
         return false;
 
       prog.Bind();
@@ -251,15 +252,12 @@ bool GPU_HW_OpenGL_ES::CompilePrograms()
     }
   }
 
-  if (!m_vram_read_program.Compile(shadergen.GenerateScreenQuadVertexShader(),
-                                   shadergen.GenerateVRAMReadFragmentShader()))
+  if (!m_shader_cache.GetProgram(&m_vram_read_program, shadergen.GenerateScreenQuadVertexShader(),
+                                 shadergen.GenerateVRAMReadFragmentShader()))
   {
     return false;
   }
 
-  if (!m_vram_read_program.Link())
-    return false;
-
   m_vram_read_program.Bind();
   m_vram_read_program.RegisterUniform("u_base_coords");
   m_vram_read_program.RegisterUniform("u_size");
@@ -273,10 +271,12 @@ void GPU_HW_OpenGL_ES::SetVertexPointers()
   glEnableVertexAttribArray(1);
   glEnableVertexAttribArray(2);
   glEnableVertexAttribArray(3);
+  glEnableVertexAttribArray(4);
   glVertexAttribIPointer(0, 2, GL_INT, sizeof(BatchVertex), &m_vertex_buffer[0].x);
   glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true, sizeof(BatchVertex), &m_vertex_buffer[0].color);
   glVertexAttribIPointer(2, 1, GL_INT, sizeof(BatchVertex), &m_vertex_buffer[0].texcoord);
   glVertexAttribIPointer(3, 1, GL_INT, sizeof(BatchVertex), &m_vertex_buffer[0].texpage);
+  glVertexAttribIPointer(4, 1, GL_INT, sizeof(BatchVertex), &m_vertex_buffer[0].texwindow);
 }
 
 void GPU_HW_OpenGL_ES::SetDrawState(BatchRenderMode render_mode)
@@ -305,18 +305,15 @@ void GPU_HW_OpenGL_ES::SetDrawState(BatchRenderMode render_mode)
   if (m_drawing_area_changed)
   {
     m_drawing_area_changed = false;
-    m_vram_dirty_rect.Include(m_drawing_area);
+    IncludeVRAMBlocks(m_vram_dirty_blocks, m_drawing_area);
     SetScissorFromDrawingArea();
   }
 
   if (m_batch_ubo_dirty)
   {
-    prog.Uniform2iv(0, m_batch_ubo_data.u_pos_offset);
-    prog.Uniform2uiv(1, m_batch_ubo_data.u_texture_window_mask);
-    prog.Uniform2uiv(2, m_batch_ubo_data.u_texture_window_offset);
-    prog.Uniform1f(3, m_batch_ubo_data.u_src_alpha_factor);
-    prog.Uniform1f(4, m_batch_ubo_data.u_dst_alpha_factor);
-    prog.Uniform1i(5, static_cast<s32>(m_batch_ubo_data.u_set_mask_while_drawing));
+    prog.Uniform1f(0, m_batch_ubo_data.u_src_alpha_factor);
+    prog.Uniform1f(1, m_batch_ubo_data.u_dst_alpha_factor);
+    prog.Uniform1i(2, static_cast<s32>(m_batch_ubo_data.u_set_mask_while_drawing));
     m_batch_ubo_dirty = false;
   }
 }
@@ -365,7 +362,7 @@ void GPU_HW_OpenGL_ES::UpdateDisplay()
     {
       m_host_display->ClearDisplayTexture();
     }
-    else if (!m_GPUSTAT.display_area_color_depth_24 && !interlaced)
+    else if (!m_GPUSTAT.display_area_color_depth_24 && !interlaced && m_system->GetSettings().runahead_frames == 0)
     {
       m_host_display->SetDisplayTexture(reinterpret_cast<void*>(static_cast<uintptr_t>(m_vram_texture.GetGLId())),
                                         m_vram_texture.GetWidth(), m_vram_texture.GetHeight(), scaled_vram_offset_x,
@@ -472,15 +469,42 @@ void GPU_HW_OpenGL_ES::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
   RestoreGraphicsAPIState();
 }
 
+bool GPU_HW_OpenGL_ES::HasVRAMSnapshot() const
+{
+  return m_vram_snapshot_texture.IsValid();
+}
+
+bool GPU_HW_OpenGL_ES::SaveVRAMSnapshot()
+{
+  if (!m_vram_snapshot_texture.IsValid() &&
+      (!m_vram_snapshot_texture.Create(m_vram_texture.GetWidth(), m_vram_texture.GetHeight(), GL_RGBA,
+                                       GL_UNSIGNED_BYTE, nullptr, false) ||
+       !m_vram_snapshot_texture.CreateFramebuffer()))
+  {
+    Log_ErrorPrintf("Failed to create VRAM snapshot texture");
+    return false;
+  }
+
+  CopyTextureRegion(m_vram_texture, m_vram_snapshot_texture, 0, 0, 0, 0, m_vram_texture.GetWidth(),
+                    m_vram_texture.GetHeight());
+  return true;
+}
+
+bool GPU_HW_OpenGL_ES::LoadVRAMSnapshot()
+{
+  if (!m_vram_snapshot_texture.IsValid())
+    return false;
+
+  CopyTextureRegion(m_vram_snapshot_texture, m_vram_texture, 0, 0, 0, 0, m_vram_texture.GetWidth(),
+                    m_vram_texture.GetHeight());
+  return true;
+}
+
 void GPU_HW_OpenGL_ES::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
 {
   if ((x + width) > VRAM_WIDTH || (y + height) > VRAM_HEIGHT)
   {
-    // CPU round trip if oversized for now.
-    Log_WarningPrintf("Oversized VRAM fill (%u-%u, %u-%u), CPU round trip", x, x + width, y, y + height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::FillVRAM(x, y, width, height, color);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    FillWrappedVRAM(x, y, width, height, color);
     return;
   }
 
@@ -509,11 +533,7 @@ void GPU_HW_OpenGL_ES::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const voi
 {
   if ((x + width) > VRAM_WIDTH || (y + height) > VRAM_HEIGHT)
   {
-    // CPU round trip if oversized for now.
-    Log_WarningPrintf("Oversized VRAM update (%u-%u, %u-%u), CPU round trip", x, x + width, y, y + height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::UpdateVRAM(x, y, width, height, data);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    UpdateWrappedVRAM(x, y, width, height, data);
     return;
   }
 
@@ -575,16 +595,17 @@ void GPU_HW_OpenGL_ES::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32
   if ((src_x + width) > VRAM_WIDTH || (src_y + height) > VRAM_HEIGHT || (dst_x + width) > VRAM_WIDTH ||
       (dst_y + height) > VRAM_HEIGHT)
   {
-    Log_WarningPrintf("Oversized VRAM copy (%u,%u, %u,%u, %u,%u), CPU round trip", src_x, src_y, dst_x, dst_y, width,
-                      height);
-    ReadVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT);
-    GPU::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height);
-    UpdateVRAM(0, 0, VRAM_WIDTH, VRAM_HEIGHT, m_vram_shadow.data());
+    CopyWrappedVRAM(src_x, src_y, dst_x, dst_y, width, height);
     return;
   }
 
   GPU_HW::CopyVRAM(src_x, src_y, dst_x, dst_y, width, height);
 
+  // Copies within a texture are undefined when the areas overlap, so those copy from the read texture instead.
+  // GPU_HW::CopyVRAM has already refreshed the dirty blocks under the source area, so it matches VRAM there.
+  const bool overlapping = Common::Rectangle<u32>::FromExtents(src_x, src_y, width, height)
+                             .Intersects(Common::Rectangle<u32>::FromExtents(dst_x, dst_y, width, height));
+
   src_x *= m_resolution_scale;
   src_y *= m_resolution_scale;
   dst_x *= m_resolution_scale;
@@ -596,40 +617,38 @@ void GPU_HW_OpenGL_ES::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32
   src_y = m_vram_texture.GetHeight() - src_y - height;
   dst_y = m_vram_texture.GetHeight() - dst_y - height;
 
-  if (GLAD_GL_EXT_copy_image)
-  {
-    glCopyImageSubDataEXT(m_vram_texture.GetGLId(), GL_TEXTURE_2D, 0, src_x, src_y, 0, m_vram_texture.GetGLId(),
-                          GL_TEXTURE_2D, 0, dst_x, dst_y, 0, width, height, 1);
-  }
+  if (overlapping)
+    CopyTextureRegion(m_vram_read_texture, m_vram_texture, src_x, src_y, dst_x, dst_y, width, height);
   else
-  {
-    glDisable(GL_SCISSOR_TEST);
-    m_vram_texture.BindFramebuffer(GL_READ_FRAMEBUFFER);
-    glBlitFramebuffer(src_x, src_y, src_x + width, src_y + height, dst_x, dst_y, dst_x + width, dst_y + height,
-                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    glEnable(GL_SCISSOR_TEST);
-  }
+    CopyTextureRegion(m_vram_texture, m_vram_texture, src_x, src_y, dst_x, dst_y, width, height);
 }
 
-void GPU_HW_OpenGL_ES::UpdateVRAMReadTexture()
+void GPU_HW_OpenGL_ES::UpdateVRAMReadTexture(const Common::Rectangle<u32>& rect)
 {
-  const auto scaled_rect = m_vram_dirty_rect * m_resolution_scale;
+  const auto scaled_rect = rect * m_resolution_scale;
   const u32 width = scaled_rect.GetWidth();
   const u32 height = scaled_rect.GetHeight();
   const u32 x = scaled_rect.left;
   const u32 y = m_vram_texture.GetHeight() - scaled_rect.top - height;
 
+  CopyTextureRegion(m_vram_texture, m_vram_read_texture, x, y, x, y, width, height);
+}
+
+void GPU_HW_OpenGL_ES::CopyTextureRegion(GL::Texture& src, GL::Texture& dst, u32 src_x, u32 src_y, u32 dst_x,
+                                         u32 dst_y, u32 width, u32 height)
+{
   if (GLAD_GL_EXT_copy_image)
   {
-    glCopyImageSubDataEXT(m_vram_texture.GetGLId(), GL_TEXTURE_2D, 0, x, y, 0, m_vram_read_texture.GetGLId(),
-                          GL_TEXTURE_2D, 0, x, y, 0, width, height, 1);
+    glCopyImageSubDataEXT(src.GetGLId(), GL_TEXTURE_2D, 0, src_x, src_y, 0, dst.GetGLId(), GL_TEXTURE_2D, 0, dst_x,
+                          dst_y, 0, width, height, 1);
   }
   else
   {
-    m_vram_read_texture.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
-    m_vram_texture.BindFramebuffer(GL_READ_FRAMEBUFFER);
+    dst.BindFramebuffer(GL_DRAW_FRAMEBUFFER);
+    src.BindFramebuffer(GL_READ_FRAMEBUFFER);
     glDisable(GL_SCISSOR_TEST);
-    glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBlitFramebuffer(src_x, src_y, src_x + width, src_y + height, dst_x, dst_y, dst_x + width, dst_y + height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
     glEnable(GL_SCISSOR_TEST);
     m_vram_texture.BindFramebuffer(GL_FRAMEBUFFER);
   }
@@ -642,6 +661,8 @@ void GPU_HW_OpenGL_ES::FlushRender()
   if (!m_batch_current_vertex_ptr)
     return;
 
+  TRACE_SCOPE("FlushRender");
+
   const u32 vertex_count = GetBatchVertexCount();
   m_batch_start_vertex_ptr = nullptr;
   m_batch_end_vertex_ptr = nullptr;
@@ -1,5 +1,6 @@
 #pragma once
 #include "common/gl/program.h"
+#include "common/gl/shader_cache.h"
 #include "common/gl/stream_buffer.h"
 #include "common/gl/texture.h"
 #include "glad.h"
@@ -16,6 +17,7 @@ public:
   bool Initialize(HostDisplay* host_display, System* system, DMA* dma, InterruptController* interrupt_controller,
                   Timers* timers) override;
   void Reset() override;
+  bool HasVRAMSnapshot() const override;
 
   void ResetGraphicsAPIState() override;
   void RestoreGraphicsAPIState() override;
@@ -24,12 +26,14 @@ public:
 protected:
   void UpdateDisplay() override;
   void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
+  bool SaveVRAMSnapshot() override;
+  bool LoadVRAMSnapshot() override;
   void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
   void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data) override;
   void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
   void FlushRender() override;
   void MapBatchVertexPointer(u32 required_vertices) override;
-  void UpdateVRAMReadTexture() override;
+  void UpdateVRAMReadTexture(const Common::Rectangle<u32>& rect) override;
 
 private:
   struct GLStats
@@ -53,14 +57,20 @@ private:
   void SetDrawState(BatchRenderMode render_mode);
   void SetScissorFromDrawingArea();
 
+  /// Copies a region between textures, in framebuffer coordinates.
+  void CopyTextureRegion(GL::Texture& src, GL::Texture& dst, u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width,
+                         u32 height);
+
   // downsample texture - used for readbacks at >1xIR.
   GL::Texture m_vram_texture;
   GL::Texture m_vram_read_texture;
   GL::Texture m_vram_encoding_texture;
   GL::Texture m_display_texture;
+  GL::Texture m_vram_snapshot_texture; // created on first use
 
   std::vector<BatchVertex> m_vertex_buffer;
 
+  GL::ShaderCache m_shader_cache;
   std::array<std::array<std::array<GL::Program, 2>, 9>, 4> m_render_programs; // [render_mode][texture_mode][dithering]
   std::array<std::array<GL::Program, 2>, 2> m_display_programs;               // [depth_24][interlaced]
   GL::Program m_vram_read_program;
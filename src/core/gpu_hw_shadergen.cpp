@@ -344,8 +344,40 @@ void GPU_HW_ShaderGen::DeclareFragmentEntryPoint(std::stringstream& ss, u32 num_
 
 void GPU_HW_ShaderGen::WriteBatchUniformBuffer(std::stringstream& ss)
 {
-  DeclareUniformBuffer(ss, {"int2 u_pos_offset", "uint2 u_texture_window_mask", "uint2 u_texture_window_offset",
-                            "float u_src_alpha_factor", "float u_dst_alpha_factor", "bool u_set_mask_while_drawing"});
+  DeclareUniformBuffer(ss, {"float u_src_alpha_factor", "float u_dst_alpha_factor", "bool u_set_mask_while_drawing"});
+}
+
+void GPU_HW_ShaderGen::WriteBatchColorFunctions(std::stringstream& ss)
+{
+  if (m_glsl)
+    ss << "CONSTANT int[16] s_dither_values = int[16]( ";
+  else
+    ss << "CONSTANT int s_dither_values[] = {";
+  for (u32 i = 0; i < 16; i++)
+  {
+    if (i > 0)
+      ss << ", ";
+    ss << GPU::DITHER_MATRIX[i / 4][i % 4];
+  }
+  if (m_glsl)
+    ss << " );\n";
+  else
+    ss << "};\n";
+
+  ss << R"(
+int3 ApplyDithering(int2 coord, int3 icol)
+{
+  int2 fc = coord & int2(3, 3);
+  int offset = s_dither_values[fc.y * 4 + fc.x];
+  return icol + int3(offset, offset, offset);
+}
+
+int3 TruncateTo15Bit(int3 icol)
+{
+  icol = clamp(icol, int3(0, 0, 0), int3(255, 255, 255));
+  return (icol & int3(~7, ~7, ~7)) | ((icol >> 3) & int3(7, 7, 7));
+}
+)";
 }
 
 std::string GPU_HW_ShaderGen::GenerateBatchVertexShader(bool textured)
@@ -359,8 +391,8 @@ std::string GPU_HW_ShaderGen::GenerateBatchVertexShader(bool textured)
 
   if (textured)
   {
-    DeclareVertexEntryPoint(ss, {"int2 a_pos", "float4 a_col0", "int a_texcoord", "int a_texpage"}, 1, 1,
-                            {"nointerpolation out int4 v_texpage"});
+    DeclareVertexEntryPoint(ss, {"int2 a_pos", "float4 a_col0", "int a_texcoord", "int a_texpage", "int a_texwindow"},
+                            1, 1, {"nointerpolation out int4 v_texpage", "nointerpolation out uint4 v_texwindow"});
   }
   else
   {
@@ -370,8 +402,8 @@ std::string GPU_HW_ShaderGen::GenerateBatchVertexShader(bool textured)
   ss << R"(
 {
   // 0..+1023 -> -1..1
-  float pos_x = (float(a_pos.x + u_pos_offset.x) / 512.0) - 1.0;
-  float pos_y = (float(a_pos.y + u_pos_offset.y) / -256.0) + 1.0;
+  float pos_x = (float(a_pos.x) / 512.0) - 1.0;
+  float pos_y = (float(a_pos.y) / -256.0) + 1.0;
   v_pos = float4(pos_x, pos_y, 0.0, 1.0);
 
   v_col0 = a_col0;
@@ -383,6 +415,12 @@ std::string GPU_HW_ShaderGen::GenerateBatchVertexShader(bool textured)
     v_texpage.y = ((a_texpage >> 4) & 1) * 256 * RESOLUTION_SCALE;
     v_texpage.z = ((a_texpage >> 16) & 63) * 16 * RESOLUTION_SCALE;
     v_texpage.w = ((a_texpage >> 22) & 511) * RESOLUTION_SCALE;
+
+    // and mask x,y, or value x,y
+    uint2 texwindow_mask = uint2(uint(a_texwindow) & 31u, (uint(a_texwindow) >> 5) & 31u);
+    uint2 texwindow_offset = uint2((uint(a_texwindow) >> 10) & 31u, (uint(a_texwindow) >> 15) & 31u);
+    v_texwindow.xy = ~(texwindow_mask * 8u);
+    v_texwindow.zw = (texwindow_offset & texwindow_mask) * 8u;
   #endif
 }
 )";
@@ -393,25 +431,28 @@ std::string GPU_HW_ShaderGen::GenerateBatchVertexShader(bool textured)
 std::string GPU_HW_ShaderGen::GenerateBatchFragmentShader(GPU_HW::BatchRenderMode transparency,
                                                           GPU::TextureMode texture_mode, bool dithering)
 {
-  const GPU::TextureMode actual_texture_mode = texture_mode & ~GPU::TextureMode::RawTextureBit;
-  const bool raw_texture = (texture_mode & GPU::TextureMode::RawTextureBit) == GPU::TextureMode::RawTextureBit;
-  const bool textured = (texture_mode != GPU::TextureMode::Disabled);
-  const bool use_dual_source = m_supports_dual_source_blend &&
-                               (transparency != GPU_HW::BatchRenderMode::TransparencyDisabled || m_texture_filering);
+  return GenerateBatchFragmentShaderImpl(false, transparency, texture_mode, dithering);
+}
+
+std::string GPU_HW_ShaderGen::GenerateBatchUberFragmentShader()
+{
+  // Only the OpenGL renderers draw with the ubershader, so the permutation uniforms are plain GLSL uniforms.
+  Assert(m_glsl);
+  return GenerateBatchFragmentShaderImpl(true, GPU_HW::BatchRenderMode::TransparencyDisabled,
+                                         GPU::TextureMode::Disabled, false);
+}
+
+std::string GPU_HW_ShaderGen::GenerateBatchFragmentShaderImpl(bool uber, GPU_HW::BatchRenderMode transparency,
+                                                              GPU::TextureMode texture_mode, bool dithering)
+{
+  const bool textured = uber || (texture_mode != GPU::TextureMode::Disabled);
+  const bool use_dual_source =
+    m_supports_dual_source_blend &&
+    (uber || transparency != GPU_HW::BatchRenderMode::TransparencyDisabled || m_texture_filering);
 
   std::stringstream ss;
   WriteHeader(ss);
-  DefineMacro(ss, "TRANSPARENCY", transparency != GPU_HW::BatchRenderMode::TransparencyDisabled);
-  DefineMacro(ss, "TRANSPARENCY_ONLY_OPAQUE", transparency == GPU_HW::BatchRenderMode::OnlyOpaque);
-  DefineMacro(ss, "TRANSPARENCY_ONLY_TRANSPARENCY", transparency == GPU_HW::BatchRenderMode::OnlyTransparent);
   DefineMacro(ss, "TEXTURED", textured);
-  DefineMacro(ss, "PALETTE",
-              actual_texture_mode == GPU::TextureMode::Palette4Bit ||
-                actual_texture_mode == GPU::TextureMode::Palette8Bit);
-  DefineMacro(ss, "PALETTE_4_BIT", actual_texture_mode == GPU::TextureMode::Palette4Bit);
-  DefineMacro(ss, "PALETTE_8_BIT", actual_texture_mode == GPU::TextureMode::Palette8Bit);
-  DefineMacro(ss, "RAW_TEXTURE", raw_texture);
-  DefineMacro(ss, "DITHERING", dithering);
   DefineMacro(ss, "DITHERING_SCALED", m_scaled_dithering);
   DefineMacro(ss, "TRUE_COLOR", m_true_color);
   DefineMacro(ss, "TEXTURE_FILTERING", m_texture_filering);
@@ -420,57 +461,54 @@ std::string GPU_HW_ShaderGen::GenerateBatchFragmentShader(GPU_HW::BatchRenderMod
   WriteCommonFunctions(ss);
   WriteBatchUniformBuffer(ss);
   DeclareTexture(ss, "samp0", 0);
-
-  if (m_glsl)
-    ss << "CONSTANT int[16] s_dither_values = int[16]( ";
-  else
-    ss << "CONSTANT int s_dither_values[] = {";
-  for (u32 i = 0; i < 16; i++)
+  WriteBatchColorFunctions(ss);
+
+  ss << "CONSTANT int RENDER_MODE_TRANSPARENCY_DISABLED = "
+     << static_cast<u32>(GPU_HW::BatchRenderMode::TransparencyDisabled) << ";\n";
+  ss << "CONSTANT int RENDER_MODE_ONLY_OPAQUE = " << static_cast<u32>(GPU_HW::BatchRenderMode::OnlyOpaque) << ";\n";
+  ss << "CONSTANT int RENDER_MODE_ONLY_TRANSPARENT = " << static_cast<u32>(GPU_HW::BatchRenderMode::OnlyTransparent)
+     << ";\n";
+  ss << "CONSTANT int TEXTURE_MODE_PALETTE_4_BIT = " << static_cast<u32>(GPU::TextureMode::Palette4Bit) << ";\n";
+  ss << "CONSTANT int TEXTURE_MODE_PALETTE_8_BIT = " << static_cast<u32>(GPU::TextureMode::Palette8Bit) << ";\n";
+  ss << "CONSTANT int TEXTURE_MODE_RAW_BIT = " << static_cast<u32>(GPU::TextureMode::RawTextureBit) << ";\n";
+  ss << "CONSTANT int TEXTURE_MODE_DISABLED = " << static_cast<u32>(GPU::TextureMode::Disabled) << ";\n";
+
+  // The ubershader selects the permutation with uniforms outside the batch uniform block, so it can change without
+  // an upload. Otherwise they're constants, and the compiler drops the branches which aren't taken.
+  if (uber)
   {
-    if (i > 0)
-      ss << ", ";
-    ss << GPU::DITHER_MATRIX[i / 4][i % 4];
+    ss << "uniform int u_render_mode;\nuniform int u_texture_mode;\nuniform bool u_dithering;\n";
+    ss << "#define RENDER_MODE u_render_mode\n#define TEXTURE_MODE u_texture_mode\n#define DITHERING u_dithering\n";
   }
-  if (m_glsl)
-    ss << " );\n";
   else
-    ss << "};\n";
+  {
+    ss << "#define RENDER_MODE " << static_cast<u32>(transparency) << "\n";
+    ss << "#define TEXTURE_MODE " << static_cast<u32>(texture_mode) << "\n";
+    ss << "#define DITHERING " << (dithering ? "true" : "false") << "\n";
+  }
 
   ss << R"(
-int3 ApplyDithering(int2 coord, int3 icol)
-{
-  int2 fc = coord & int2(3, 3);
-  int offset = s_dither_values[fc.y * 4 + fc.x];
-  return icol + int3(offset, offset, offset);
-}
-
-int3 TruncateTo15Bit(int3 icol)
-{
-  icol = clamp(icol, int3(0, 0, 0), int3(255, 255, 255));
-  return (icol & int3(~7, ~7, ~7)) | ((icol >> 3) & int3(7, 7, 7));
-}
-
 #if TEXTURED
 CONSTANT float4 TRANSPARENT_PIXEL_COLOR = float4(0.0, 0.0, 0.0, 0.0);
 
-int2 ApplyTextureWindow(int2 coords)
+int2 ApplyTextureWindow(uint4 texwindow, int2 coords)
 {
-  uint x = (uint(coords.x) & ~(u_texture_window_mask.x * 8u)) | ((u_texture_window_offset.x & u_texture_window_mask.x) * 8u);
-  uint y = (uint(coords.y) & ~(u_texture_window_mask.y * 8u)) | ((u_texture_window_offset.y & u_texture_window_mask.y) * 8u);
+  uint x = (uint(coords.x) & texwindow.x) | texwindow.z;
+  uint y = (uint(coords.y) & texwindow.y) | texwindow.w;
   return int2(int(x), int(y));
-}  
+}
 
-float4 SampleFromVRAM(int4 texpage, int2 icoord)
+float4 SampleFromVRAM(int4 texpage, uint4 texwindow, int2 icoord)
 {
-  icoord = ApplyTextureWindow(icoord);
+  icoord = ApplyTextureWindow(texwindow, icoord);
 
   // adjust for tightly packed palette formats
+  int palette_mode = TEXTURE_MODE & ~TEXTURE_MODE_RAW_BIT;
   int2 index_coord = icoord;
-  #if PALETTE_4_BIT
+  if (palette_mode == TEXTURE_MODE_PALETTE_4_BIT)
     index_coord.x /= 4;
-  #elif PALETTE_8_BIT
+  else if (palette_mode == TEXTURE_MODE_PALETTE_8_BIT)
     index_coord.x /= 2;
-  #endif
 
   // fixup coords
   int2 vicoord = int2(texpage.x + index_coord.x * RESOLUTION_SCALE, fixYCoord(texpage.y + index_coord.y * RESOLUTION_SCALE));
@@ -479,28 +517,29 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
   float4 color = LOAD_TEXTURE(samp0, vicoord, 0);
 
   // apply palette
-  #if PALETTE
-    #if PALETTE_4_BIT
-      int subpixel = int(icoord.x) & 3;
-      uint vram_value = RGBA8ToRGBA5551(color);
-      int palette_index = int((vram_value >> (subpixel * 4)) & 0x0Fu);
-    #elif PALETTE_8_BIT
-      int subpixel = int(icoord.x) & 1;
-      uint vram_value = RGBA8ToRGBA5551(color);
-      int palette_index = int((vram_value >> (subpixel * 8)) & 0xFFu);
-    #endif
+  if (palette_mode == TEXTURE_MODE_PALETTE_4_BIT || palette_mode == TEXTURE_MODE_PALETTE_8_BIT)
+  {
+    uint vram_value = RGBA8ToRGBA5551(color);
+    int palette_index;
+    if (palette_mode == TEXTURE_MODE_PALETTE_4_BIT)
+      palette_index = int((vram_value >> ((int(icoord.x) & 3) * 4)) & 0x0Fu);
+    else
+      palette_index = int((vram_value >> ((int(icoord.x) & 1) * 8)) & 0xFFu);
+
     int2 palette_icoord = int2(texpage.z + (palette_index * RESOLUTION_SCALE), fixYCoord(texpage.w));
     color = LOAD_TEXTURE(samp0, palette_icoord, 0);
-  #endif
+  }
 
   return color;
 }
 #endif
 )";
 
+  // The ubershader declares the textured inputs for every batch, the vertex shader writes them regardless.
   if (textured)
   {
-    DeclareFragmentEntryPoint(ss, 1, 1, {"nointerpolation in int4 v_texpage"}, true, use_dual_source);
+    DeclareFragmentEntryPoint(ss, 1, 1, {"nointerpolation in int4 v_texpage", "nointerpolation in uint4 v_texwindow"},
+                              true, use_dual_source);
   }
   else
   {
@@ -517,6 +556,8 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
   float oalpha;
 
   #if TEXTURED
+  if (TEXTURE_MODE != TEXTURE_MODE_DISABLED)
+  {
     #if TEXTURE_FILTERING
       int2 icoord = int2(v_tex0);
       float2 pcoord = frac(v_tex0) - float2(0.5, 0.5);
@@ -524,10 +565,10 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
       pcoord = abs(pcoord);
 
       // TODO: Clamp to page
-      float4 tl = SampleFromVRAM(v_texpage, int2(v_tex0));
-      float4 tr = SampleFromVRAM(v_texpage, int2(min(v_tex0.x + poffs.x, 255.0), v_tex0.y));
-      float4 bl = SampleFromVRAM(v_texpage, int2(v_tex0.x, min(v_tex0.y + poffs.y, 255.0)));
-      float4 br = SampleFromVRAM(v_texpage, int2(min(v_tex0.x + poffs.x, 255.0), min(v_tex0.y + poffs.y, 255.0)));
+      float4 tl = SampleFromVRAM(v_texpage, v_texwindow, int2(v_tex0));
+      float4 tr = SampleFromVRAM(v_texpage, v_texwindow, int2(min(v_tex0.x + poffs.x, 255.0), v_tex0.y));
+      float4 bl = SampleFromVRAM(v_texpage, v_texwindow, int2(v_tex0.x, min(v_tex0.y + poffs.y, 255.0)));
+      float4 br = SampleFromVRAM(v_texpage, v_texwindow, int2(min(v_tex0.x + poffs.x, 255.0), min(v_tex0.y + poffs.y, 255.0)));
 
       // Compute alpha from how many texels aren't pixel color 0000h.
       float tl_a = float(VECTOR_NEQ(tl, TRANSPARENT_PIXEL_COLOR));
@@ -544,7 +585,7 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
       texcol.rgb /= float3(ialpha, ialpha, ialpha);
       semitransparent = (texcol.a != 0.0);
     #else
-      float4 texcol = SampleFromVRAM(v_texpage, int2(v_tex0));
+      float4 texcol = SampleFromVRAM(v_texpage, v_texwindow, int2(v_tex0));
       if (VECTOR_EQ(texcol, TRANSPARENT_PIXEL_COLOR))
         discard;
 
@@ -552,15 +593,17 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
       ialpha = 1.0;
     #endif
 
-    #if RAW_TEXTURE
+    if ((TEXTURE_MODE & TEXTURE_MODE_RAW_BIT) != 0)
       icolor = int3(texcol.rgb * float3(255.0, 255.0, 255.0));
-    #else
+    else
       icolor = (vertcol * int3(texcol.rgb * float3(255.0, 255.0, 255.0))) >> 7;
-    #endif
 
     // Compute output alpha (mask bit)
     oalpha = float(u_set_mask_while_drawing ? 1 : int(semitransparent));
-  #else
+  }
+  else
+  #endif
+  {
     // All pixels are semitransparent for untextured polygons.
     semitransparent = true;
     icolor = vertcol;
@@ -568,16 +611,17 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
 
     // However, the mask bit is cleared if set mask bit is false.
     oalpha = float(u_set_mask_while_drawing);
-  #endif
+  }
 
   // Apply dithering
-  #if DITHERING
+  if (DITHERING)
+  {
     #if DITHERING_SCALED
       icolor = ApplyDithering(int2(v_pos.xy), icolor);
     #else
       icolor = ApplyDithering(int2(v_pos.xy) / int2(RESOLUTION_SCALE, RESOLUTION_SCALE), icolor);
     #endif
-  #endif
+  }
 
   // Clip to 15-bit range
   #if !TRUE_COLOR
@@ -587,13 +631,13 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
   // Normalize
   float3 color = float3(icolor) / float3(255.0, 255.0, 255.0);
 
-  #if TRANSPARENCY
+  if (RENDER_MODE != RENDER_MODE_TRANSPARENCY_DISABLED)
+  {
     // Apply semitransparency. If not a semitransparent texel, destination alpha is ignored.
     if (semitransparent)
     {
-      #if TRANSPARENCY_ONLY_OPAQUE
+      if (RENDER_MODE == RENDER_MODE_ONLY_OPAQUE)
         discard;
-      #endif
 
       #if USE_DUAL_SOURCE
         o_col0 = float4(color * (u_src_alpha_factor * ialpha), oalpha);
@@ -604,9 +648,8 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
     }
     else
     {
-      #if TRANSPARENCY_ONLY_TRANSPARENCY
+      if (RENDER_MODE == RENDER_MODE_ONLY_TRANSPARENT)
         discard;
-      #endif
 
       #if USE_DUAL_SOURCE
         o_col0 = float4(color * ialpha, oalpha);
@@ -615,14 +658,16 @@ float4 SampleFromVRAM(int4 texpage, int2 icoord)
         o_col0 = float4(color * ialpha, 1.0 - ialpha);
       #endif
     }
-  #else
+  }
+  else
+  {
     // Non-transparency won't enable blending so we can write the mask here regardless.
     o_col0 = float4(color * ialpha, oalpha);
 
     #if USE_DUAL_SOURCE
       o_col1 = float4(0.0, 0.0, 0.0, 1.0 - ialpha);
     #endif
-  #endif
+  }
 }
 )";
 
@@ -14,6 +14,9 @@ public:
   std::string GenerateBatchVertexShader(bool textured);
   std::string GenerateBatchFragmentShader(GPU_HW::BatchRenderMode transparency, GPU::TextureMode texture_mode,
                                           bool dithering);
+
+  /// Generates a fragment shader which handles every batch permutation, selected by uniforms at runtime.
+  std::string GenerateBatchUberFragmentShader();
   std::string GenerateBatchLineExpandGeometryShader();
   std::string GenerateScreenQuadVertexShader();
   std::string GenerateFillFragmentShader();
@@ -49,4 +52,9 @@ private:
 
   void WriteCommonFunctions(std::stringstream& ss);
   void WriteBatchUniformBuffer(std::stringstream& ss);
+  void WriteBatchColorFunctions(std::stringstream& ss);
+
+  /// Generates a batch fragment shader, with the permutation either fixed or selected by uniforms for the ubershader.
+  std::string GenerateBatchFragmentShaderImpl(bool uber, GPU_HW::BatchRenderMode transparency,
+                                              GPU::TextureMode texture_mode, bool dithering);
 };
@@ -1,17 +1,38 @@
 #include "gpu_sw.h"
+#include "common/align.h"
 #include "common/assert.h"
+#include "common/cpu_detect.h"
+#include "common/log.h"
+#include "common/string.h"
+#include "common/trace.h"
 #include "host_display.h"
 #include "system.h"
 #include <algorithm>
+#include <cstring>
+#include <new>
+
+#if defined(CPU_X64)
+#include <emmintrin.h>
+#elif defined(CPU_AARCH64)
+#include <arm_neon.h>
+#endif
+Log_SetChannel(GPU_SW);
 
 GPU_SW::GPU_SW()
 {
   m_vram.fill(0);
+#ifdef WITH_SW_TILED_VRAM
+  m_vram_shadow.fill(0);
+  m_vram_ptr = m_vram_shadow.data();
+#else
   m_vram_ptr = m_vram.data();
+#endif
 }
 
 GPU_SW::~GPU_SW()
 {
+  StopWorkerThreads();
+
   if (m_host_display)
     m_host_display->ClearDisplayTexture();
 }
@@ -27,18 +48,43 @@ bool GPU_SW::Initialize(HostDisplay* host_display, System* system, DMA* dma, Int
   if (!GPU::Initialize(host_display, system, dma, interrupt_controller, timers))
     return false;
 
-  m_display_texture = host_display->CreateTexture(VRAM_WIDTH, VRAM_HEIGHT, nullptr, 0, true);
+  // Not dynamic, since only the rows which changed are uploaded, and D3D11 discards the rest of a dynamic texture.
+  m_display_texture = host_display->CreateTexture(VRAM_WIDTH, VRAM_HEIGHT, nullptr, 0, false);
   if (!m_display_texture)
     return false;
 
+  if (m_system->GetSettings().gpu_use_thread)
+    StartWorkerThreads();
+
   return true;
 }
 
 void GPU_SW::Reset()
 {
+  SyncWorkerThreads();
+
   GPU::Reset();
 
   m_vram.fill(0);
+  InvalidateAllTexturePages();
+  m_scanout_dirty_row_blocks = ~UINT64_C(0);
+}
+
+bool GPU_SW::DoState(StateWrapper& sw, bool use_vram_snapshot)
+{
+  // VRAM is read and written directly by the base class.
+  SyncWorkerThreads();
+  return GPU::DoState(sw, use_vram_snapshot);
+}
+
+void GPU_SW::UpdateSettings()
+{
+  GPU::UpdateSettings();
+
+  if (m_system->GetSettings().gpu_use_thread)
+    StartWorkerThreads();
+  else
+    StopWorkerThreads();
 }
 
 void GPU_SW::CopyOut15Bit(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width, u32 height)
@@ -47,7 +93,55 @@ void GPU_SW::CopyOut15Bit(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32
   {
     const u16* src_row_ptr = src_ptr;
     u32* dst_row_ptr = dst_ptr;
-    for (u32 col = 0; col < width; col++)
+    u32 col = 0;
+
+#if defined(CPU_X64)
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask3 = _mm_set1_epi16(0x07);
+    const __m128i mask8 = _mm_set1_epi16(0xFF);
+    for (; (col + 8) <= width; col += 8)
+    {
+      const __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_row_ptr));
+      const __m128i r = _mm_and_si128(color, mask5);
+      const __m128i g = _mm_and_si128(_mm_srli_epi16(color, 5), mask5);
+      const __m128i b = _mm_and_si128(_mm_srli_epi16(color, 10), mask5);
+      const __m128i a = _mm_and_si128(_mm_srai_epi16(color, 15), mask8);
+
+      // 00012345 -> 1234545
+      const __m128i r8 = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_and_si128(r, mask3));
+      const __m128i g8 = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_and_si128(g, mask3));
+      const __m128i b8 = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_and_si128(b, mask3));
+
+      const __m128i rg = _mm_or_si128(r8, _mm_slli_epi16(g8, 8));
+      const __m128i ba = _mm_or_si128(b8, _mm_slli_epi16(a, 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_row_ptr), _mm_unpacklo_epi16(rg, ba));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_row_ptr + 4), _mm_unpackhi_epi16(rg, ba));
+      src_row_ptr += 8;
+      dst_row_ptr += 8;
+    }
+#elif defined(CPU_AARCH64)
+    const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+    const uint16x8_t mask3 = vdupq_n_u16(0x07);
+    for (; (col + 8) <= width; col += 8)
+    {
+      const uint16x8_t color = vld1q_u16(src_row_ptr);
+      const uint16x8_t r = vandq_u16(color, mask5);
+      const uint16x8_t g = vandq_u16(vshrq_n_u16(color, 5), mask5);
+      const uint16x8_t b = vandq_u16(vshrq_n_u16(color, 10), mask5);
+
+      // 00012345 -> 1234545
+      uint8x8x4_t rgba;
+      rgba.val[0] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vandq_u16(r, mask3)));
+      rgba.val[1] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 3), vandq_u16(g, mask3)));
+      rgba.val[2] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vandq_u16(b, mask3)));
+      rgba.val[3] = vmovn_u16(vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(color), 15)));
+      vst4_u8(reinterpret_cast<u8*>(dst_row_ptr), rgba);
+      src_row_ptr += 8;
+      dst_row_ptr += 8;
+    }
+#endif
+
+    for (; col < width; col++)
       *(dst_row_ptr++) = RGBA5551ToRGBA8888(*(src_row_ptr++));
 
     src_ptr += src_stride;
@@ -61,11 +155,25 @@ void GPU_SW::CopyOut24Bit(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32
   {
     const u8* src_row_ptr = reinterpret_cast<const u8*>(src_ptr);
     u32* dst_row_ptr = dst_ptr;
+    u32 col = 0;
+
+    // Four pixels at a time from three words. The alpha channel is filled with junk, but that's okay since we
+    // don't use it.
+    for (; (col + 4) <= width; col += 4)
+    {
+      u32 words[3];
+      std::memcpy(words, src_row_ptr, sizeof(words));
+      dst_row_ptr[0] = words[0];
+      dst_row_ptr[1] = (words[0] >> 24) | (words[1] << 8);
+      dst_row_ptr[2] = (words[1] >> 16) | (words[2] << 16);
+      dst_row_ptr[3] = words[2] >> 8;
+      src_row_ptr += 12;
+      dst_row_ptr += 4;
+    }
 
     // Beware unaligned accesses.
-    for (u32 col = 0; col < width; col++)
+    for (; col < width; col++)
     {
-      // This will fill the alpha channel with junk, but that's okay since we don't use it
       std::memcpy(dst_row_ptr, src_row_ptr, sizeof(u32));
       src_row_ptr += 3;
       dst_row_ptr++;
@@ -76,8 +184,54 @@ void GPU_SW::CopyOut24Bit(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32
   }
 }
 
+void GPU_SW::UpdateDisplayTexture(u32 x, u32 y, u32 width, u32 height, bool color_24bit)
+{
+  // Only rows which have been written since the last scanout need converting and uploading, unless the area moved.
+  const bool area_changed = (x != m_scanout_x || y != m_scanout_y || width != m_scanout_width ||
+                             height != m_scanout_height || color_24bit != m_scanout_24bit);
+  const u64 dirty_row_blocks = area_changed ? ~UINT64_C(0) : m_scanout_dirty_row_blocks;
+  m_scanout_dirty_row_blocks = 0;
+  m_scanout_x = x;
+  m_scanout_y = y;
+  m_scanout_width = width;
+  m_scanout_height = height;
+  m_scanout_24bit = color_24bit;
+
+  u32 row = 0;
+  while (row < height)
+  {
+    const u32 first_row = row;
+    while (row < height && (dirty_row_blocks & (UINT64_C(1) << ((y + row) / BAND_HEIGHT))) != 0)
+      row++;
+
+    if (row == first_row)
+    {
+      row++;
+      continue;
+    }
+
+#ifdef WITH_SW_TILED_VRAM
+    // 24-bit rows are 1.5 halfwords per pixel, and the last pixel is read as a whole word.
+    const u32 vram_width = color_24bit ? ((width * 3 + 2) / 2) : width;
+    UpdateVRAMShadow(x, y + first_row, std::min<u32>(vram_width, VRAM_WIDTH - x), row - first_row);
+#endif
+
+    const u16* src_ptr = m_vram_ptr + (y + first_row) * VRAM_WIDTH + x;
+    u32* dst_ptr = m_display_texture_buffer.data() + first_row * width;
+    if (color_24bit)
+      CopyOut24Bit(src_ptr, VRAM_WIDTH, dst_ptr, width, width, row - first_row);
+    else
+      CopyOut15Bit(src_ptr, VRAM_WIDTH, dst_ptr, width, width, row - first_row);
+
+    m_host_display->UpdateTexture(m_display_texture.get(), 0, first_row, width, row - first_row, dst_ptr,
+                                  width * sizeof(u32));
+  }
+}
+
 void GPU_SW::UpdateDisplay()
 {
+  SyncWorkerThreads();
+
   // fill display texture
   m_display_texture_buffer.resize(VRAM_WIDTH * VRAM_HEIGHT);
 
@@ -95,19 +249,9 @@ void GPU_SW::UpdateDisplay()
       m_host_display->ClearDisplayTexture();
       return;
     }
-    else if (m_GPUSTAT.display_area_color_depth_24)
-    {
-      CopyOut24Bit(m_vram.data() + vram_offset_y * VRAM_WIDTH + vram_offset_x, VRAM_WIDTH,
-                   m_display_texture_buffer.data(), display_width, display_width, display_height);
-    }
-    else
-    {
-      CopyOut15Bit(m_vram.data() + vram_offset_y * VRAM_WIDTH + vram_offset_x, VRAM_WIDTH,
-                   m_display_texture_buffer.data(), display_width, display_width, display_height);
-    }
 
-    m_host_display->UpdateTexture(m_display_texture.get(), 0, 0, display_width, display_height,
-                                  m_display_texture_buffer.data(), display_width * sizeof(u32));
+    UpdateDisplayTexture(vram_offset_x, vram_offset_y, display_width, display_height,
+                         m_GPUSTAT.display_area_color_depth_24);
     m_host_display->SetDisplayTexture(m_display_texture->GetHandle(), VRAM_WIDTH, VRAM_HEIGHT, 0, 0, display_width,
                                       display_height);
     m_host_display->SetDisplayParameters(m_crtc_state.visible_display_width, m_crtc_state.visible_display_height,
@@ -115,9 +259,7 @@ void GPU_SW::UpdateDisplay()
   }
   else
   {
-    CopyOut15Bit(m_vram.data(), VRAM_WIDTH, m_display_texture_buffer.data(), VRAM_WIDTH, VRAM_WIDTH, VRAM_HEIGHT);
-    m_host_display->UpdateTexture(m_display_texture.get(), 0, 0, VRAM_WIDTH, VRAM_HEIGHT,
-                                  m_display_texture_buffer.data(), VRAM_WIDTH * sizeof(u32));
+    UpdateDisplayTexture(0, 0, VRAM_WIDTH, VRAM_HEIGHT, false);
     m_host_display->SetDisplayTexture(m_display_texture->GetHandle(), VRAM_WIDTH, VRAM_HEIGHT, 0, 0, VRAM_WIDTH,
                                       VRAM_HEIGHT);
     m_host_display->SetDisplayParameters(VRAM_WIDTH, VRAM_HEIGHT, Common::Rectangle<s32>(0, 0, VRAM_WIDTH, VRAM_HEIGHT),
@@ -125,10 +267,348 @@ void GPU_SW::UpdateDisplay()
   }
 }
 
+void GPU_SW::ReadVRAM(u32 x, u32 y, u32 width, u32 height)
+{
+  // GPUREAD and VRAM dumps read straight from our copy, so any queued drawing needs to land first.
+  SyncWorkerThreads();
+
+#ifdef WITH_SW_TILED_VRAM
+  UpdateVRAMShadow(x, y, width, height);
+#endif
+}
+
+#ifdef WITH_SW_TILED_VRAM
+void GPU_SW::UpdateVRAMShadow(u32 x, u32 y, u32 width, u32 height)
+{
+  for (u32 yoffs = 0; yoffs < height; yoffs++)
+  {
+    const u32 row = (y + yoffs) % VRAM_HEIGHT;
+    u16* shadow_row_ptr = &m_vram_shadow[row * VRAM_WIDTH];
+    for (u32 xoffs = 0; xoffs < width;)
+    {
+      const u32 col = (x + xoffs) % VRAM_WIDTH;
+      const u32 count = std::min(width - xoffs, GetContiguousPixels(col));
+      std::copy_n(GetPixelPtr(col, row), count, &shadow_row_ptr[col]);
+      xoffs += count;
+    }
+  }
+}
+#endif
+
+void GPU_SW::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color)
+{
+  m_scanout_dirty_row_blocks |= GetRowBlockMask(y, height);
+
+  BlockMask write_blocks = {};
+  AddRectToBlockMask(write_blocks, x, y, width, height);
+  CheckForBandHazard({}, write_blocks);
+
+  FillVRAMCommand* cmd = AllocateCommand<FillVRAMCommand>(CommandType::FillVRAM);
+  cmd->x = Truncate16(x);
+  cmd->y = Truncate16(y);
+  cmd->width = Truncate16(width);
+  cmd->height = Truncate16(height);
+  cmd->color = RGBA8888ToRGBA5551(color);
+  PushCommand(cmd);
+}
+
+void GPU_SW::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data)
+{
+  // Save state loads hand our own VRAM back to us, which doesn't need to be copied through the FIFO.
+  const u16* data_ptr = static_cast<const u16*>(data);
+  const bool is_own_vram = (data_ptr >= m_vram_ptr && data_ptr < (m_vram_ptr + VRAM_WIDTH * VRAM_HEIGHT));
+  m_scanout_dirty_row_blocks |= GetRowBlockMask(y, height);
+  if (!IsUsingThread() || is_own_vram)
+  {
+    SyncWorkerThreads();
+
+    BlockMask write_blocks = {};
+    AddRectToBlockMask(write_blocks, x, y, width, height);
+    for (TexturePageCache& cache : m_texture_page_caches)
+      InvalidateTexturePages(cache, write_blocks);
+
+    UpdateVRAMImpl(Band{0, 1}, x, y, width, height, data, m_GPUSTAT.GetMaskAND(), m_GPUSTAT.GetMaskOR());
+    return;
+  }
+
+  BlockMask write_blocks = {};
+  AddRectToBlockMask(write_blocks, x, y, width, height);
+  CheckForBandHazard({}, write_blocks);
+
+  const u32 data_size = width * height * sizeof(u16);
+  UpdateVRAMCommand* cmd =
+    AllocateCommand<UpdateVRAMCommand>(CommandType::UpdateVRAM, sizeof(UpdateVRAMCommand) + data_size);
+  cmd->x = Truncate16(x);
+  cmd->y = Truncate16(y);
+  cmd->width = Truncate16(width);
+  cmd->height = Truncate16(height);
+  cmd->mask_and = m_GPUSTAT.GetMaskAND();
+  cmd->mask_or = m_GPUSTAT.GetMaskOR();
+  std::memcpy(cmd + 1, data, data_size);
+  PushCommand(cmd);
+}
+
+void GPU_SW::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height)
+{
+  m_scanout_dirty_row_blocks |= GetRowBlockMask(dst_y, height);
+
+  // Rows can be both read and written by a copy, so it's executed by the first worker alone, in between barriers.
+  const bool use_barriers = (m_num_workers > 1);
+  if (use_barriers)
+    PushBarrier();
+
+  CopyVRAMCommand* cmd = AllocateCommand<CopyVRAMCommand>(CommandType::CopyVRAM);
+  cmd->src_x = Truncate16(src_x);
+  cmd->src_y = Truncate16(src_y);
+  cmd->dst_x = Truncate16(dst_x);
+  cmd->dst_y = Truncate16(dst_y);
+  cmd->width = Truncate16(width);
+  cmd->height = Truncate16(height);
+  cmd->mask_and = m_GPUSTAT.GetMaskAND();
+  cmd->mask_or = m_GPUSTAT.GetMaskOR();
+  cmd->serial = true;
+  PushCommand(cmd);
+
+  if (use_barriers)
+    PushBarrier();
+}
+
+void GPU_SW::FillVRAMImpl(const Band& band, u32 x, u32 y, u32 width, u32 height, u16 color)
+{
+  for (u32 yoffs = 0; yoffs < height; yoffs++)
+  {
+    const u32 row = (y + yoffs) % VRAM_HEIGHT;
+    if (!band.ContainsRow(row))
+      continue;
+
+    // Split at wrap-around and tile boundaries.
+    for (u32 xoffs = 0; xoffs < width;)
+    {
+      const u32 col = (x + xoffs) % VRAM_WIDTH;
+      const u32 count = std::min(width - xoffs, GetContiguousPixels(col));
+      std::fill_n(GetPixelPtr(col, row), count, color);
+      xoffs += count;
+    }
+  }
+}
+
+void GPU_SW::UpdateVRAMImpl(const Band& band, u32 x, u32 y, u32 width, u32 height, const void* data, u16 mask_and,
+                            u16 mask_or)
+{
+  // Fast path when the copy is not oversized.
+  if ((x + width) <= VRAM_WIDTH && (y + height) <= VRAM_HEIGHT && (mask_and | mask_or) == 0)
+  {
+    const u16* src_ptr = static_cast<const u16*>(data);
+    if (src_ptr == GetPixelPtr(x, y) && width == VRAM_WIDTH)
+      return;
+
+    for (u32 yoffs = 0; yoffs < height; yoffs++)
+    {
+      if (!band.ContainsRow(y + yoffs))
+        continue;
+
+      const u16* src_row_ptr = src_ptr + yoffs * width;
+      for (u32 xoffs = 0; xoffs < width;)
+      {
+        const u32 count = std::min(width - xoffs, GetContiguousPixels(x + xoffs));
+        std::copy_n(src_row_ptr + xoffs, count, GetPixelPtr(x + xoffs, y + yoffs));
+        xoffs += count;
+      }
+    }
+  }
+  else
+  {
+    // Slow path when we need to handle wrap-around. Masked pixels still consume their source pixel, so the result
+    // doesn't depend on which band a row is in.
+    const u16* src_ptr = static_cast<const u16*>(data);
+    for (u32 row = 0; row < height; row++)
+    {
+      const u32 dst_row = (y + row) % VRAM_HEIGHT;
+      if (!band.ContainsRow(dst_row))
+        continue;
+
+      const u16* src_row_ptr = src_ptr + row * width;
+      for (u32 col = 0; col < width; col++)
+      {
+        u16* pixel_ptr = GetPixelPtr((x + col) % VRAM_WIDTH, dst_row);
+        if (((*pixel_ptr) & mask_and) == 0)
+          *pixel_ptr = src_row_ptr[col] | mask_or;
+      }
+    }
+  }
+}
+
+void GPU_SW::CopyVRAMImpl(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height, u16 mask_and,
+                          u16 mask_or)
+{
+  for (u32 row = 0; row < height; row++)
+  {
+    const u32 src_row = (src_y + row) % VRAM_HEIGHT;
+    const u32 dst_row = (dst_y + row) % VRAM_HEIGHT;
+
+    for (u32 col = 0; col < width; col++)
+    {
+      const u16 src_pixel = GetPixel((src_x + col) % VRAM_WIDTH, src_row);
+      u16* dst_pixel_ptr = GetPixelPtr((dst_x + col) % VRAM_WIDTH, dst_row);
+      if ((*dst_pixel_ptr & mask_and) == 0)
+        *dst_pixel_ptr = src_pixel | mask_or;
+    }
+  }
+}
+
+GPU_SW::DrawState GPU_SW::GetDrawState() const
+{
+  DrawState ds;
+  ds.drawing_area_left = static_cast<s32>(m_drawing_area.left);
+  ds.drawing_area_top = static_cast<s32>(m_drawing_area.top);
+  ds.drawing_area_right = static_cast<s32>(m_drawing_area.right);
+  ds.drawing_area_bottom = static_cast<s32>(m_drawing_area.bottom);
+  ds.drawing_offset_x = m_drawing_offset.x;
+  ds.drawing_offset_y = m_drawing_offset.y;
+  ds.texture_page_x = m_draw_mode.texture_page_x;
+  ds.texture_page_y = m_draw_mode.texture_page_y;
+  ds.texture_palette_x = m_draw_mode.texture_palette_x;
+  ds.texture_palette_y = m_draw_mode.texture_palette_y;
+  ds.texture_window_and_x = Truncate8(~(m_draw_mode.texture_window_mask_x * 8u));
+  ds.texture_window_and_y = Truncate8(~(m_draw_mode.texture_window_mask_y * 8u));
+  ds.texture_window_or_x =
+    Truncate8((m_draw_mode.texture_window_offset_x & m_draw_mode.texture_window_mask_x) * 8u);
+  ds.texture_window_or_y =
+    Truncate8((m_draw_mode.texture_window_offset_y & m_draw_mode.texture_window_mask_y) * 8u);
+  ds.texture_mode = m_draw_mode.GetTextureMode();
+  ds.transparency_mode = m_draw_mode.GetTransparencyMode();
+  ds.mask_and = m_GPUSTAT.GetMaskAND();
+  ds.mask_or = m_GPUSTAT.GetMaskOR();
+  ds.band = Band{0, 1};
+  ds.use_texture_page_cache = false;
+  ds.texture_page = nullptr;
+  return ds;
+}
+
+u64 GPU_SW::GetRowBlockMask(u32 y, u32 height)
+{
+  static_assert(NUM_ROW_BLOCKS == 64, "row blocks fit in a u64");
+  if (height == 0)
+    return 0;
+  if (height >= VRAM_HEIGHT)
+    return ~UINT64_C(0);
+
+  y %= VRAM_HEIGHT;
+  const u32 last_row = y + height - 1;
+  if (last_row >= VRAM_HEIGHT)
+    return GetRowBlockMask(y, VRAM_HEIGHT - y) | GetRowBlockMask(0, last_row - VRAM_HEIGHT + 1);
+
+  const u32 first_block = y / BAND_HEIGHT;
+  const u32 last_block = last_row / BAND_HEIGHT;
+  const u64 upper_mask = (last_block == (NUM_ROW_BLOCKS - 1)) ? ~UINT64_C(0) : ((UINT64_C(1) << (last_block + 1)) - 1);
+  return upper_mask & ~((UINT64_C(1) << first_block) - 1);
+}
+
+void GPU_SW::AddRectToBlockMask(BlockMask& mask, u32 x, u32 y, u32 width, u32 height)
+{
+  if (width == 0)
+    return;
+
+  const u64 row_blocks = GetRowBlockMask(y, height);
+  if (width >= VRAM_WIDTH)
+  {
+    for (u64& column : mask)
+      column |= row_blocks;
+    return;
+  }
+
+  x %= VRAM_WIDTH;
+  const u32 first_block = x / HAZARD_BLOCK_WIDTH;
+  const u32 last_block = (x + width - 1) / HAZARD_BLOCK_WIDTH;
+  for (u32 i = first_block; i <= last_block; i++)
+    mask[i % NUM_COLUMN_BLOCKS] |= row_blocks;
+}
+
+bool GPU_SW::BlockMasksOverlap(const BlockMask& lhs, const BlockMask& rhs)
+{
+  u64 overlap = 0;
+  for (u32 i = 0; i < NUM_COLUMN_BLOCKS; i++)
+    overlap |= lhs[i] & rhs[i];
+  return (overlap != 0);
+}
+
+void GPU_SW::CheckForBandHazard(const BlockMask& read_blocks, const BlockMask& write_blocks)
+{
+  if (m_num_workers <= 1)
+    return;
+
+  if (BlockMasksOverlap(m_pending_write_blocks, read_blocks) || BlockMasksOverlap(m_pending_read_blocks, write_blocks))
+    PushBarrier();
+
+  for (u32 i = 0; i < NUM_COLUMN_BLOCKS; i++)
+  {
+    m_pending_read_blocks[i] |= read_blocks[i];
+    m_pending_write_blocks[i] |= write_blocks[i];
+  }
+}
+
+void GPU_SW::PushBarrier()
+{
+  PushCommand(AllocateCommand<Command>(CommandType::Barrier));
+  m_pending_read_blocks = {};
+  m_pending_write_blocks = {};
+}
+
+void GPU_SW::MarkDrawnRowsDirty(s32 min_y, s32 max_y)
+{
+  min_y = std::max(min_y + m_drawing_offset.y, static_cast<s32>(m_drawing_area.top));
+  max_y = std::min(max_y + m_drawing_offset.y, static_cast<s32>(m_drawing_area.bottom));
+  if (min_y <= max_y)
+    m_scanout_dirty_row_blocks |= GetRowBlockMask(static_cast<u32>(min_y), static_cast<u32>(max_y - min_y + 1));
+}
+
 void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32* command_ptr)
 {
   const bool dithering_enable = rc.IsDitheringEnabled() && m_GPUSTAT.dither_enable;
 
+  // Texels can come from rows which belong to another band, so make sure they have been drawn first, and aren't
+  // overwritten by a band which has run ahead.
+  BlockMask read_blocks = {};
+  BlockMask write_blocks = {};
+  if (m_num_workers > 1)
+  {
+    if (rc.texture_enable)
+    {
+      const Common::Rectangle<u32> page_rect = m_draw_mode.GetTexturePageRectangle();
+      AddRectToBlockMask(read_blocks, page_rect.left, page_rect.top,
+                         std::min<u32>(page_rect.GetWidth(), VRAM_WIDTH - page_rect.left), page_rect.GetHeight());
+      if (m_draw_mode.IsUsingPalette())
+      {
+        const Common::Rectangle<u32> palette_rect = m_draw_mode.GetTexturePaletteRectangle();
+        AddRectToBlockMask(read_blocks, palette_rect.left, palette_rect.top,
+                           std::min<u32>(palette_rect.GetWidth(), VRAM_WIDTH - palette_rect.left), 1);
+      }
+    }
+
+    if (m_drawing_area.right >= m_drawing_area.left && m_drawing_area.bottom >= m_drawing_area.top)
+    {
+      AddRectToBlockMask(write_blocks, m_drawing_area.left, m_drawing_area.top,
+                         m_drawing_area.right - m_drawing_area.left + 1, m_drawing_area.bottom - m_drawing_area.top + 1);
+    }
+  }
+
+  // A draw which samples the area it draws to depends on its own pixel order, so it can't be split into bands.
+  const bool serial = BlockMasksOverlap(read_blocks, write_blocks);
+  if (serial)
+    PushBarrier();
+  else
+    CheckForBandHazard(read_blocks, write_blocks);
+
+  // Palette textures are sampled through the page cache, unless the draw could write to its own texels.
+  bool use_texture_page_cache = false;
+  if (rc.texture_enable && m_draw_mode.IsUsingPalette())
+  {
+    const Common::Rectangle<u32> drawing_area(m_drawing_area.left, m_drawing_area.top, m_drawing_area.right + 1,
+                                              m_drawing_area.bottom + 1);
+    use_texture_page_cache = !drawing_area.Intersects(m_draw_mode.GetTexturePageRectangle()) &&
+                             !drawing_area.Intersects(m_draw_mode.GetTexturePaletteRectangle());
+  }
+
   switch (rc.primitive)
   {
     case Primitive::Polygon:
@@ -137,12 +617,18 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
       const bool shaded = rc.shading_enable;
       const bool textured = rc.texture_enable;
 
-      std::array<SWVertex, 4> vertices;
+      DrawPolygonCommand* cmd = AllocateCommand<DrawPolygonCommand>(CommandType::DrawPolygon);
+      cmd->draw_state = GetDrawState();
+      cmd->draw_state.use_texture_page_cache = use_texture_page_cache;
+      cmd->draw_function = GetDrawTriangleFunction(rc.shading_enable, rc.texture_enable, rc.raw_texture_enable,
+                                                   rc.transparency_enable, dithering_enable);
+      cmd->num_vertices = num_vertices;
+      cmd->serial = serial;
 
       u32 buffer_pos = 1;
       for (u32 i = 0; i < num_vertices; i++)
       {
-        SWVertex& vert = vertices[i];
+        SWVertex& vert = cmd->vertices[i];
         const u32 color_rgb = (shaded && i > 0) ? (command_ptr[buffer_pos++] & UINT32_C(0x00FFFFFF)) : first_color;
         vert.color_r = Truncate8(color_rgb);
         vert.color_g = Truncate8(color_rgb >> 8);
@@ -163,12 +649,16 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
         }
       }
 
-      const DrawTriangleFunction DrawFunction = GetDrawTriangleFunction(
-        rc.shading_enable, rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable, dithering_enable);
+      s32 min_y = cmd->vertices[0].y;
+      s32 max_y = cmd->vertices[0].y;
+      for (u32 i = 1; i < num_vertices; i++)
+      {
+        min_y = std::min(min_y, cmd->vertices[i].y);
+        max_y = std::max(max_y, cmd->vertices[i].y);
+      }
+      MarkDrawnRowsDirty(min_y, max_y);
 
-      (this->*DrawFunction)(&vertices[0], &vertices[1], &vertices[2]);
-      if (num_vertices > 3)
-        (this->*DrawFunction)(&vertices[2], &vertices[1], &vertices[3]);
+      PushCommand(cmd);
     }
     break;
 
@@ -202,10 +692,22 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
           break;
       }
 
-      const DrawRectangleFunction DrawFunction =
-        GetDrawRectangleFunction(rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable);
-
-      (this->*DrawFunction)(vp.x, vp.y, width, height, r, g, b, texcoord_x, texcoord_y);
+      DrawRectangleCommand* cmd = AllocateCommand<DrawRectangleCommand>(CommandType::DrawRectangle);
+      cmd->draw_state = GetDrawState();
+      cmd->draw_state.use_texture_page_cache = use_texture_page_cache;
+      cmd->draw_function = GetDrawRectangleFunction(rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable);
+      cmd->x = vp.x;
+      cmd->y = vp.y;
+      cmd->width = static_cast<u32>(width);
+      cmd->height = static_cast<u32>(height);
+      cmd->r = r;
+      cmd->g = g;
+      cmd->b = b;
+      cmd->texcoord_x = texcoord_x;
+      cmd->texcoord_y = texcoord_y;
+      cmd->serial = serial;
+      MarkDrawnRowsDirty(vp.y, vp.y + height - 1);
+      PushCommand(cmd);
     }
     break;
 
@@ -213,28 +715,41 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
     {
       const u32 first_color = rc.color_for_first_vertex;
       const bool shaded = rc.shading_enable;
+      const DrawState draw_state = GetDrawState();
+      const DrawLineFunction draw_function = GetDrawLineFunction(shaded, rc.transparency_enable, dithering_enable);
 
-      const DrawLineFunction DrawFunction = GetDrawLineFunction(shaded, rc.transparency_enable, dithering_enable);
-
-      std::array<SWVertex, 2> vertices = {};
       u32 buffer_pos = 1;
 
       // first vertex
-      SWVertex* p0 = &vertices[0];
-      SWVertex* p1 = &vertices[1];
-      p0->SetPosition(VertexPosition{command_ptr[buffer_pos++]});
-      p0->SetColorRGB24(first_color);
+      SWVertex last_vertex;
+      last_vertex.SetPosition(VertexPosition{command_ptr[buffer_pos++]});
+      last_vertex.SetColorRGB24(first_color);
 
-      // remaining vertices in line strip
-      for (u32 i = 1; i < num_vertices; i++)
+      // long polylines are split across multiple commands, with the last vertex of one being the first of the next
+      for (u32 first = 0; (first + 1) < num_vertices; first += MAX_LINE_VERTICES_PER_COMMAND - 1)
       {
-        p1->SetColorRGB24(shaded ? (command_ptr[buffer_pos++] & UINT32_C(0x00FFFFFF)) : first_color);
-        p1->SetPosition(VertexPosition{command_ptr[buffer_pos++]});
-
-        (this->*DrawFunction)(p0, p1);
+        const u32 count = std::min<u32>(num_vertices - first, MAX_LINE_VERTICES_PER_COMMAND);
+        DrawLineCommand* cmd =
+          AllocateCommand<DrawLineCommand>(CommandType::DrawLine, sizeof(DrawLineCommand) + sizeof(SWVertex) * count);
+        cmd->draw_state = draw_state;
+        cmd->draw_function = draw_function;
+        cmd->num_vertices = count;
+
+        SWVertex* vertices = reinterpret_cast<SWVertex*>(cmd + 1);
+        vertices[0] = last_vertex;
+        s32 min_y = last_vertex.y;
+        s32 max_y = last_vertex.y;
+        for (u32 i = 1; i < count; i++)
+        {
+          vertices[i].SetColorRGB24(shaded ? (command_ptr[buffer_pos++] & UINT32_C(0x00FFFFFF)) : first_color);
+          vertices[i].SetPosition(VertexPosition{command_ptr[buffer_pos++]});
+          min_y = std::min(min_y, vertices[i].y);
+          max_y = std::max(max_y, vertices[i].y);
+        }
+        MarkDrawnRowsDirty(min_y, max_y);
 
-        // swap p0/p1 so that the last vertex is used as the first for the next line
-        std::swap(p0, p1);
+        last_vertex = vertices[count - 1];
+        PushCommand(cmd);
       }
     }
     break;
@@ -243,101 +758,652 @@ void GPU_SW::DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32
       UnreachableCode();
       break;
   }
+
+  if (serial)
+    PushBarrier();
 }
 
-enum : u32
+template<typename T>
+T* GPU_SW::AllocateCommand(CommandType type, u32 size /* = sizeof(T) */)
 {
-  COORD_FRAC_BITS = 32,
-  COLOR_FRAC_BITS = 12
-};
+  size = Common::AlignUpPow2(size, COMMAND_ALIGNMENT);
 
-using FixedPointCoord = u64;
+  T* cmd = new (AllocateFIFOSpace(size)) T();
+  cmd->type = type;
+  cmd->size = size;
+  return cmd;
+}
 
-constexpr FixedPointCoord IntToFixedCoord(s32 x)
+void* GPU_SW::AllocateFIFOSpace(u32 size)
 {
-  return (ZeroExtend64(static_cast<u32>(x)) << COORD_FRAC_BITS) | (ZeroExtend64(1u) << (COORD_FRAC_BITS - 1));
-}
+  if (!IsUsingThread())
+    return m_command_fifo.data();
 
-using FixedPointColor = u32;
+  DebugAssert(size < COMMAND_FIFO_SIZE);
 
-constexpr FixedPointColor IntToFixedColor(u8 r)
-{
-  return ZeroExtend32(r) << COLOR_FRAC_BITS | (1u << (COLOR_FRAC_BITS - 1));
-}
+  for (;;)
+  {
+    const u32 read_ptr = GetSlowestWorkerReadPtr();
+    const u32 write_ptr = m_command_fifo_write_ptr.load();
+    if (read_ptr > write_ptr)
+    {
+      // The write pointer can't catch up to the read pointer, otherwise the FIFO would appear empty.
+      if ((write_ptr + size) < read_ptr)
+        return &m_command_fifo[write_ptr];
+    }
+    else
+    {
+      if ((write_ptr + size) < COMMAND_FIFO_SIZE)
+        return &m_command_fifo[write_ptr];
 
-constexpr u8 FixedColorToInt(FixedPointColor r)
-{
-  return Truncate8(r >> 12);
-}
+      // Not enough space at the end, so continue from the start once the worker has moved off it.
+      if (read_ptr > 0)
+      {
+        Command* cmd = reinterpret_cast<Command*>(&m_command_fifo[write_ptr]);
+        cmd->type = CommandType::Wraparound;
+        cmd->size = 0;
+        m_command_fifo_write_ptr.store(0);
+        if (m_workers_sleeping.load() > 0)
+        {
+          std::unique_lock<std::mutex> lock(m_worker_mutex);
+          m_worker_wake_cv.notify_all();
+        }
 
-bool GPU_SW::IsClockwiseWinding(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2)
-{
-  const s32 abx = v1->x - v0->x;
-  const s32 aby = v1->y - v0->y;
-  const s32 acx = v2->x - v0->x;
-  const s32 acy = v2->y - v0->y;
-  return ((abx * acy) - (aby * acx) < 0);
-}
+        continue;
+      }
+    }
 
-static constexpr bool IsTopLeftEdge(s32 ex, s32 ey)
-{
-  return (ey < 0 || (ey == 0 && ex < 0));
+    // FIFO is full, wait for the workers to drain it.
+    Log_DevPrintf("Command FIFO full, waiting for worker threads");
+    SyncWorkerThreads();
+  }
 }
 
-static constexpr u8 Interpolate(u8 v0, u8 v1, u8 v2, s32 w0, s32 w1, s32 w2, s32 ws)
+void GPU_SW::PushCommand(Command* cmd)
 {
-  const s32 v = w0 * static_cast<s32>(static_cast<u32>(v0)) + w1 * static_cast<s32>(static_cast<u32>(v1)) +
-                w2 * static_cast<s32>(static_cast<u32>(v2));
-  const s32 vd = v / ws;
-  return (vd < 0) ? 0 : ((vd > 0xFF) ? 0xFF : static_cast<u8>(vd));
+  if (!IsUsingThread())
+  {
+    ExecuteCommand(cmd, Band{0, 1});
+    return;
+  }
+
+  const u32 write_ptr = static_cast<u32>(reinterpret_cast<u8*>(cmd) - m_command_fifo.data()) + cmd->size;
+  m_command_fifo_write_ptr.store(write_ptr);
+  if (m_workers_sleeping.load() > 0)
+  {
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_worker_wake_cv.notify_all();
+  }
 }
 
-template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
-         bool dithering_enable>
-void GPU_SW::DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2)
+void GPU_SW::ExecuteCommand(const Command* cmd, const Band& worker_band)
 {
-#define orient2d(ax, ay, bx, by, cx, cy) ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax))
+  TexturePageCache& texture_page_cache = m_texture_page_caches[worker_band.index];
+  if (!texture_page_cache.pages.empty())
+    InvalidateTexturePages(texture_page_cache, cmd);
 
-  // ensure the vertices follow a counter-clockwise order
-  if (IsClockwiseWinding(v0, v1, v2))
-    std::swap(v1, v2);
+  Band band = worker_band;
+  if (cmd->serial)
+  {
+    if (band.index != 0)
+      return;
 
-  const s32 px0 = v0->x + m_drawing_offset.x;
-  const s32 py0 = v0->y + m_drawing_offset.y;
-  const s32 px1 = v1->x + m_drawing_offset.x;
-  const s32 py1 = v1->y + m_drawing_offset.y;
-  const s32 px2 = v2->x + m_drawing_offset.x;
-  const s32 py2 = v2->y + m_drawing_offset.y;
+    band = Band{0, 1};
+  }
 
-  // Barycentric coordinates at minX/minY corner
-  const s32 ws = orient2d(px0, py0, px1, py1, px2, py2);
-  if (ws == 0)
-    return;
+  switch (cmd->type)
+  {
+    case CommandType::Barrier:
+      WaitForBarrier();
+      break;
 
-  // compute bounding box of triangle
-  s32 min_x = std::min(px0, std::min(px1, px2));
-  s32 max_x = std::max(px0, std::max(px1, px2));
-  s32 min_y = std::min(py0, std::min(py1, py2));
-  s32 max_y = std::max(py0, std::max(py1, py2));
+    case CommandType::FillVRAM:
+    {
+      const FillVRAMCommand* fill = static_cast<const FillVRAMCommand*>(cmd);
+      FillVRAMImpl(band, fill->x, fill->y, fill->width, fill->height, fill->color);
+    }
+    break;
 
-  // reject triangles which cover the whole vram area
-  if (static_cast<u32>(max_x - min_x) > MAX_PRIMITIVE_WIDTH || static_cast<u32>(max_y - min_y) > MAX_PRIMITIVE_HEIGHT)
-    return;
+    case CommandType::UpdateVRAM:
+    {
+      const UpdateVRAMCommand* update = static_cast<const UpdateVRAMCommand*>(cmd);
+      UpdateVRAMImpl(band, update->x, update->y, update->width, update->height, update + 1, update->mask_and,
+                     update->mask_or);
+    }
+    break;
 
-  // clip to drawing area
-  min_x = std::clamp(min_x, static_cast<s32>(m_drawing_area.left), static_cast<s32>(m_drawing_area.right));
-  max_x = std::clamp(max_x, static_cast<s32>(m_drawing_area.left), static_cast<s32>(m_drawing_area.right));
-  min_y = std::clamp(min_y, static_cast<s32>(m_drawing_area.top), static_cast<s32>(m_drawing_area.bottom));
-  max_y = std::clamp(max_y, static_cast<s32>(m_drawing_area.top), static_cast<s32>(m_drawing_area.bottom));
+    case CommandType::CopyVRAM:
+    {
+      const CopyVRAMCommand* copy = static_cast<const CopyVRAMCommand*>(cmd);
+      CopyVRAMImpl(copy->src_x, copy->src_y, copy->dst_x, copy->dst_y, copy->width, copy->height, copy->mask_and,
+                   copy->mask_or);
+    }
+    break;
 
-  // compute per-pixel increments
-  const s32 a01 = py0 - py1, b01 = px1 - px0;
-  const s32 a12 = py1 - py2, b12 = px2 - px1;
-  const s32 a20 = py2 - py0, b20 = px0 - px2;
+    case CommandType::DrawPolygon:
+    {
+      const DrawPolygonCommand* polygon = static_cast<const DrawPolygonCommand*>(cmd);
+      DrawState ds = polygon->draw_state;
+      ds.band = band;
+      if (ds.use_texture_page_cache)
+        ds.texture_page = LookupTexturePage(texture_page_cache, ds);
+      (this->*polygon->draw_function)(ds, &polygon->vertices[0], &polygon->vertices[1], &polygon->vertices[2]);
+      if (polygon->num_vertices > 3)
+        (this->*polygon->draw_function)(ds, &polygon->vertices[2], &polygon->vertices[1], &polygon->vertices[3]);
+    }
+    break;
 
-  // top-left edge rule
-  const s32 w0_bias = 0 - s32(IsTopLeftEdge(b12, a12));
-  const s32 w1_bias = 0 - s32(IsTopLeftEdge(b20, a20));
+    case CommandType::DrawRectangle:
+    {
+      const DrawRectangleCommand* rect = static_cast<const DrawRectangleCommand*>(cmd);
+      DrawState ds = rect->draw_state;
+      ds.band = band;
+      if (ds.use_texture_page_cache)
+        ds.texture_page = LookupTexturePage(texture_page_cache, ds);
+      (this->*rect->draw_function)(ds, rect->x, rect->y, rect->width, rect->height, rect->r, rect->g, rect->b,
+                                   rect->texcoord_x, rect->texcoord_y);
+    }
+    break;
+
+    case CommandType::DrawLine:
+    {
+      const DrawLineCommand* line = static_cast<const DrawLineCommand*>(cmd);
+      const SWVertex* vertices = reinterpret_cast<const SWVertex*>(line + 1);
+      DrawState ds = line->draw_state;
+      ds.band = band;
+      for (u32 i = 1; i < line->num_vertices; i++)
+        (this->*line->draw_function)(ds, &vertices[i - 1], &vertices[i]);
+    }
+    break;
+
+    default:
+      UnreachableCode();
+      break;
+  }
+}
+
+u32 GPU_SW::GetSlowestWorkerReadPtr() const
+{
+  const u32 write_ptr = m_command_fifo_write_ptr.load();
+  u32 slowest_read_ptr = write_ptr;
+  u32 max_pending = 0;
+  for (u32 i = 0; i < m_num_workers; i++)
+  {
+    const u32 read_ptr = m_command_fifo_read_ptrs[i].load();
+    const u32 pending = (write_ptr >= read_ptr) ? (write_ptr - read_ptr) : (COMMAND_FIFO_SIZE - read_ptr + write_ptr);
+    if (pending > max_pending)
+    {
+      max_pending = pending;
+      slowest_read_ptr = read_ptr;
+    }
+  }
+
+  return slowest_read_ptr;
+}
+
+bool GPU_SW::AreWorkersIdle() const
+{
+  const u32 write_ptr = m_command_fifo_write_ptr.load();
+  for (u32 i = 0; i < m_num_workers; i++)
+  {
+    if (m_command_fifo_read_ptrs[i].load() != write_ptr)
+      return false;
+  }
+
+  return true;
+}
+
+void GPU_SW::StartWorkerThreads()
+{
+  if (IsUsingThread())
+    return;
+
+  // The workers would only compete with the emulation thread for the one core.
+  const u32 num_cpus = std::thread::hardware_concurrency();
+  if (num_cpus < 2)
+  {
+    Log_WarningPrintf("Only one host CPU is available, not using GPU worker threads");
+    return;
+  }
+
+  // Leave a CPU for the emulation thread.
+  m_num_workers = std::min<u32>(num_cpus - 1, MAX_WORKER_THREADS);
+  Log_InfoPrintf("Using %u GPU worker thread(s)", m_num_workers);
+
+  for (std::atomic<u32>& read_ptr : m_command_fifo_read_ptrs)
+    read_ptr.store(0);
+  m_command_fifo_write_ptr.store(0);
+  m_workers_sleeping.store(0);
+  m_worker_shutdown_flag.store(false);
+  m_barrier_arrived.store(0);
+  m_pending_read_blocks = {};
+  m_pending_write_blocks = {};
+
+  // The caches of the other workers haven't seen any commands while rasterizing on this thread.
+  InvalidateAllTexturePages();
+
+  for (u32 i = 0; i < m_num_workers; i++)
+    m_worker_threads.emplace_back(&GPU_SW::WorkerThreadEntryPoint, this, i);
+}
+
+void GPU_SW::StopWorkerThreads()
+{
+  if (!IsUsingThread())
+    return;
+
+  SyncWorkerThreads();
+
+  {
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_worker_shutdown_flag.store(true);
+    m_worker_wake_cv.notify_all();
+  }
+
+  for (std::thread& thread : m_worker_threads)
+    thread.join();
+  m_worker_threads.clear();
+  m_num_workers = 0;
+}
+
+void GPU_SW::SyncWorkerThreads()
+{
+  if (!IsUsingThread())
+    return;
+
+  if (!AreWorkersIdle())
+  {
+    TRACE_SCOPE("SyncWorkerThreads");
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_worker_idle_cv.wait(lock, [this]() { return AreWorkersIdle(); });
+  }
+
+  m_pending_read_blocks = {};
+  m_pending_write_blocks = {};
+}
+
+void GPU_SW::WaitForBarrier()
+{
+  const u32 generation = m_barrier_generation.load();
+  if ((m_barrier_arrived.fetch_add(1) + 1) == m_num_workers)
+  {
+    // last one in releases everyone else
+    m_barrier_arrived.store(0);
+    m_barrier_generation.fetch_add(1);
+    return;
+  }
+
+  TRACE_SCOPE("WaitForBarrier");
+  while (m_barrier_generation.load() == generation)
+    std::this_thread::yield();
+}
+
+void GPU_SW::WorkerThreadEntryPoint(u32 index)
+{
+  // Primitives tend to arrive in bursts, so spin for a little while before going to sleep.
+  static constexpr u32 SPIN_COUNT = 1000;
+
+  Trace::SetThreadName(TinyString::FromFormat("GPU Worker %u", index).GetCharArray());
+
+  const Band band{index, m_num_workers};
+  std::atomic<u32>& read_ptr_ref = m_command_fifo_read_ptrs[index];
+
+  for (;;)
+  {
+    u32 read_ptr = read_ptr_ref.load();
+    u32 write_ptr = m_command_fifo_write_ptr.load();
+    if (read_ptr != write_ptr)
+    {
+      TRACE_SCOPE("ExecuteCommands");
+      while (read_ptr != write_ptr)
+      {
+        const Command* cmd = reinterpret_cast<const Command*>(&m_command_fifo[read_ptr]);
+        if (cmd->type == CommandType::Wraparound)
+        {
+          read_ptr = 0;
+        }
+        else
+        {
+          ExecuteCommand(cmd, band);
+          read_ptr += cmd->size;
+        }
+
+        read_ptr_ref.store(read_ptr);
+      }
+
+      continue;
+    }
+
+    // wake up anyone waiting for us to finish
+    {
+      std::unique_lock<std::mutex> lock(m_worker_mutex);
+      m_worker_idle_cv.notify_all();
+    }
+
+    for (u32 i = 0; i < SPIN_COUNT && m_command_fifo_write_ptr.load() == read_ptr; i++)
+      std::this_thread::yield();
+    if (m_command_fifo_write_ptr.load() != read_ptr)
+      continue;
+
+    std::unique_lock<std::mutex> lock(m_worker_mutex);
+    m_workers_sleeping.fetch_add(1);
+    m_worker_wake_cv.wait(lock, [this, &read_ptr_ref]() {
+      return (m_worker_shutdown_flag.load() || read_ptr_ref.load() != m_command_fifo_write_ptr.load());
+    });
+    m_workers_sleeping.fetch_sub(1);
+
+    if (m_worker_shutdown_flag.load())
+      break;
+  }
+}
+
+GPU_SW::TexturePage* GPU_SW::LookupTexturePage(TexturePageCache& cache, const DrawState& ds)
+{
+  const u32 key = (ds.texture_page_x / 64) | ((ds.texture_page_y / TEXTURE_PAGE_HEIGHT) << 4) |
+                  ((ds.texture_palette_x / 16) << 5) | (ds.texture_palette_y << 11) |
+                  (static_cast<u32>(ds.texture_mode) << 20);
+
+  TexturePage* page = nullptr;
+  for (const std::unique_ptr<TexturePage>& it : cache.pages)
+  {
+    if (it->key == key)
+    {
+      it->last_used = ++cache.counter;
+      return it.get();
+    }
+
+    if (!page || it->last_used < page->last_used)
+      page = it.get();
+  }
+
+  if (cache.pages.size() < TEXTURE_PAGE_CACHE_SIZE)
+    page = cache.pages.emplace_back(std::make_unique<TexturePage>()).get();
+
+  page->key = key;
+  page->last_used = ++cache.counter;
+  page->page_x = ds.texture_page_x;
+  page->page_y = ds.texture_page_y;
+  page->palette_x = ds.texture_palette_x;
+  page->palette_y = ds.texture_palette_y;
+  page->mode = ds.texture_mode;
+  page->valid_tiles = {};
+
+  const bool is_4bit = (ds.texture_mode == TextureMode::Palette4Bit);
+  const u32 page_width = is_4bit ? (TEXTURE_PAGE_WIDTH / 4) : (TEXTURE_PAGE_WIDTH / 2);
+  const u32 palette_width = is_4bit ? 16 : 256;
+  page->source_blocks = {};
+  AddRectToBlockMask(page->source_blocks, page->page_x, page->page_y,
+                     std::min<u32>(page_width, VRAM_WIDTH - page->page_x),
+                     std::min<u32>(TEXTURE_PAGE_HEIGHT, VRAM_HEIGHT - page->page_y));
+  AddRectToBlockMask(page->source_blocks, page->palette_x, page->palette_y,
+                     std::min<u32>(palette_width, VRAM_WIDTH - page->palette_x), 1);
+  return page;
+}
+
+void GPU_SW::InvalidateTexturePages(TexturePageCache& cache, const Command* cmd)
+{
+  BlockMask write_blocks = {};
+  switch (cmd->type)
+  {
+    case CommandType::FillVRAM:
+    {
+      const FillVRAMCommand* fill = static_cast<const FillVRAMCommand*>(cmd);
+      AddRectToBlockMask(write_blocks, fill->x, fill->y, fill->width, fill->height);
+    }
+    break;
+
+    case CommandType::UpdateVRAM:
+    {
+      const UpdateVRAMCommand* update = static_cast<const UpdateVRAMCommand*>(cmd);
+      AddRectToBlockMask(write_blocks, update->x, update->y, update->width, update->height);
+    }
+    break;
+
+    case CommandType::CopyVRAM:
+    {
+      const CopyVRAMCommand* copy = static_cast<const CopyVRAMCommand*>(cmd);
+      AddRectToBlockMask(write_blocks, copy->dst_x, copy->dst_y, copy->width, copy->height);
+    }
+    break;
+
+    case CommandType::DrawPolygon:
+    case CommandType::DrawRectangle:
+    case CommandType::DrawLine:
+    {
+      // draws can only write within the drawing area
+      const DrawState& ds =
+        (cmd->type == CommandType::DrawPolygon) ?
+          static_cast<const DrawPolygonCommand*>(cmd)->draw_state :
+          ((cmd->type == CommandType::DrawRectangle) ? static_cast<const DrawRectangleCommand*>(cmd)->draw_state :
+                                                       static_cast<const DrawLineCommand*>(cmd)->draw_state);
+      if (ds.drawing_area_right < ds.drawing_area_left || ds.drawing_area_bottom < ds.drawing_area_top)
+        return;
+
+      AddRectToBlockMask(write_blocks, static_cast<u32>(ds.drawing_area_left), static_cast<u32>(ds.drawing_area_top),
+                         static_cast<u32>(ds.drawing_area_right - ds.drawing_area_left + 1),
+                         static_cast<u32>(ds.drawing_area_bottom - ds.drawing_area_top + 1));
+    }
+    break;
+
+    default:
+      return;
+  }
+
+  InvalidateTexturePages(cache, write_blocks);
+}
+
+void GPU_SW::InvalidateTexturePages(TexturePageCache& cache, const BlockMask& write_blocks)
+{
+  for (const std::unique_ptr<TexturePage>& page : cache.pages)
+  {
+    if (page->key != INVALID_TEXTURE_PAGE_KEY && BlockMasksOverlap(page->source_blocks, write_blocks))
+    {
+      page->key = INVALID_TEXTURE_PAGE_KEY;
+      page->last_used = 0;
+    }
+  }
+}
+
+void GPU_SW::InvalidateAllTexturePages()
+{
+  for (TexturePageCache& cache : m_texture_page_caches)
+  {
+    for (const std::unique_ptr<TexturePage>& page : cache.pages)
+    {
+      page->key = INVALID_TEXTURE_PAGE_KEY;
+      page->last_used = 0;
+    }
+  }
+}
+
+void GPU_SW::DecodeTexturePageTile(TexturePage* page, u32 tile)
+{
+  const u32 base_x = (tile % TEXTURE_PAGE_TILES_PER_ROW) * TEXTURE_PAGE_TILE_SIZE;
+  const u32 base_y = (tile / TEXTURE_PAGE_TILES_PER_ROW) * TEXTURE_PAGE_TILE_SIZE;
+  for (u32 texcoord_y = base_y; texcoord_y < (base_y + TEXTURE_PAGE_TILE_SIZE); texcoord_y++)
+  {
+    const u32 vram_y = std::min<u32>(page->page_y + texcoord_y, VRAM_HEIGHT - 1);
+    u16* dst = &page->texels[texcoord_y * TEXTURE_PAGE_WIDTH];
+    if (page->mode == TextureMode::Palette4Bit)
+    {
+      for (u32 texcoord_x = base_x; texcoord_x < (base_x + TEXTURE_PAGE_TILE_SIZE); texcoord_x++)
+      {
+        const u16 palette_value = GetPixel(std::min<u32>(page->page_x + texcoord_x / 4, VRAM_WIDTH - 1), vram_y);
+        const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
+        dst[texcoord_x] = GetPixel(std::min<u32>(page->palette_x + palette_index, VRAM_WIDTH - 1), page->palette_y);
+      }
+    }
+    else
+    {
+      for (u32 texcoord_x = base_x; texcoord_x < (base_x + TEXTURE_PAGE_TILE_SIZE); texcoord_x++)
+      {
+        const u16 palette_value = GetPixel(std::min<u32>(page->page_x + texcoord_x / 2, VRAM_WIDTH - 1), vram_y);
+        const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
+        dst[texcoord_x] = GetPixel(std::min<u32>(page->palette_x + palette_index, VRAM_WIDTH - 1), page->palette_y);
+      }
+    }
+  }
+
+  page->valid_tiles[tile / 64] |= UINT64_C(1) << (tile % 64);
+}
+
+ALWAYS_INLINE u16 GPU_SW::GetCachedTexel(TexturePage* page, u8 texcoord_x, u8 texcoord_y)
+{
+  const u32 tile =
+    (texcoord_y / TEXTURE_PAGE_TILE_SIZE) * TEXTURE_PAGE_TILES_PER_ROW + (texcoord_x / TEXTURE_PAGE_TILE_SIZE);
+  if (!(page->valid_tiles[tile / 64] & (UINT64_C(1) << (tile % 64))))
+    DecodeTexturePageTile(page, tile);
+
+  return page->texels[ZeroExtend32(texcoord_y) * TEXTURE_PAGE_WIDTH + ZeroExtend32(texcoord_x)];
+}
+
+enum : u32
+{
+  COORD_FRAC_BITS = 32,
+  COLOR_FRAC_BITS = 12
+};
+
+using FixedPointCoord = u64;
+
+constexpr FixedPointCoord IntToFixedCoord(s32 x)
+{
+  return (ZeroExtend64(static_cast<u32>(x)) << COORD_FRAC_BITS) | (ZeroExtend64(1u) << (COORD_FRAC_BITS - 1));
+}
+
+using FixedPointColor = u32;
+
+constexpr FixedPointColor IntToFixedColor(u8 r)
+{
+  return ZeroExtend32(r) << COLOR_FRAC_BITS | (1u << (COLOR_FRAC_BITS - 1));
+}
+
+constexpr u8 FixedColorToInt(FixedPointColor r)
+{
+  return Truncate8(r >> 12);
+}
+
+bool GPU_SW::IsClockwiseWinding(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2)
+{
+  const s32 abx = v1->x - v0->x;
+  const s32 aby = v1->y - v0->y;
+  const s32 acx = v2->x - v0->x;
+  const s32 acy = v2->y - v0->y;
+  return ((abx * acy) - (aby * acx) < 0);
+}
+
+static constexpr bool IsTopLeftEdge(s32 ex, s32 ey)
+{
+  return (ey < 0 || (ey == 0 && ex < 0));
+}
+
+#if defined(CPU_X64)
+
+static ALWAYS_INLINE __m128i DivideTruncate(__m128i num, __m128d divisor)
+{
+  const __m128i lo = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(num), divisor));
+  const __m128i hi = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(num, num)), divisor));
+  return _mm_unpacklo_epi64(lo, hi);
+}
+
+#elif defined(CPU_AARCH64)
+
+static ALWAYS_INLINE int32x4_t DivideTruncate(int32x4_t num, float64x2_t divisor)
+{
+  const int64x2_t lo = vcvtq_s64_f64(vdivq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(num))), divisor));
+  const int64x2_t hi = vcvtq_s64_f64(vdivq_f64(vcvtq_f64_s64(vmovl_high_s32(num)), divisor));
+  return vcombine_s32(vmovn_s64(lo), vmovn_s64(hi));
+}
+
+#endif
+
+/// Interpolates one attribute across a run of pixels. The numerator is linear in x, so it is stepped rather than
+/// recomputed per pixel. Both operands fit in 31 bits, so a double-precision divide truncates to the same quotient as
+/// an integer divide, and eight pixels can be divided at once.
+static void InterpolateSpan(u8* out, s32 numerator, s32 step, s32 divisor, u32 count)
+{
+  u32 i = 0;
+
+#if defined(CPU_X64)
+  const __m128d vdivisor = _mm_set1_pd(static_cast<double>(divisor));
+  const __m128i vstep = _mm_set1_epi32(step * 8);
+  __m128i vnum0 = _mm_add_epi32(_mm_set1_epi32(numerator), _mm_setr_epi32(0, step, step * 2, step * 3));
+  __m128i vnum1 = _mm_add_epi32(vnum0, _mm_set1_epi32(step * 4));
+  for (; (i + 8) <= count; i += 8)
+  {
+    const __m128i q = _mm_packs_epi32(DivideTruncate(vnum0, vdivisor), DivideTruncate(vnum1, vdivisor));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(q, q));
+    vnum0 = _mm_add_epi32(vnum0, vstep);
+    vnum1 = _mm_add_epi32(vnum1, vstep);
+  }
+#elif defined(CPU_AARCH64)
+  static constexpr s32 lane_index[4] = {0, 1, 2, 3};
+  const float64x2_t vdivisor = vdupq_n_f64(static_cast<double>(divisor));
+  const int32x4_t vstep = vdupq_n_s32(step * 8);
+  int32x4_t vnum0 = vmlaq_n_s32(vdupq_n_s32(numerator), vld1q_s32(lane_index), step);
+  int32x4_t vnum1 = vaddq_s32(vnum0, vdupq_n_s32(step * 4));
+  for (; (i + 8) <= count; i += 8)
+  {
+    const int16x8_t q =
+      vcombine_s16(vqmovn_s32(DivideTruncate(vnum0, vdivisor)), vqmovn_s32(DivideTruncate(vnum1, vdivisor)));
+    vst1_u8(out + i, vqmovun_s16(q));
+    vnum0 = vaddq_s32(vnum0, vstep);
+    vnum1 = vaddq_s32(vnum1, vstep);
+  }
+#endif
+
+  numerator += static_cast<s32>(i) * step;
+  for (; i < count; i++, numerator += step)
+  {
+    const s32 vd = numerator / divisor;
+    out[i] = (vd < 0) ? 0 : ((vd > 0xFF) ? 0xFF : static_cast<u8>(vd));
+  }
+}
+
+template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
+         bool dithering_enable>
+void GPU_SW::DrawTriangle(const DrawState& ds, const SWVertex* v0, const SWVertex* v1, const SWVertex* v2)
+{
+#define orient2d(ax, ay, bx, by, cx, cy) ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax))
+
+  // ensure the vertices follow a counter-clockwise order
+  if (IsClockwiseWinding(v0, v1, v2))
+    std::swap(v1, v2);
+
+  const s32 px0 = v0->x + ds.drawing_offset_x;
+  const s32 py0 = v0->y + ds.drawing_offset_y;
+  const s32 px1 = v1->x + ds.drawing_offset_x;
+  const s32 py1 = v1->y + ds.drawing_offset_y;
+  const s32 px2 = v2->x + ds.drawing_offset_x;
+  const s32 py2 = v2->y + ds.drawing_offset_y;
+
+  // Barycentric coordinates at minX/minY corner
+  const s32 ws = orient2d(px0, py0, px1, py1, px2, py2);
+  if (ws == 0)
+    return;
+
+  // compute bounding box of triangle
+  s32 min_x = std::min(px0, std::min(px1, px2));
+  s32 max_x = std::max(px0, std::max(px1, px2));
+  s32 min_y = std::min(py0, std::min(py1, py2));
+  s32 max_y = std::max(py0, std::max(py1, py2));
+
+  // reject triangles which cover the whole vram area
+  if (static_cast<u32>(max_x - min_x) > MAX_PRIMITIVE_WIDTH || static_cast<u32>(max_y - min_y) > MAX_PRIMITIVE_HEIGHT)
+    return;
+
+  // clip to drawing area
+  min_x = std::clamp(min_x, ds.drawing_area_left, ds.drawing_area_right);
+  max_x = std::clamp(max_x, ds.drawing_area_left, ds.drawing_area_right);
+  min_y = std::clamp(min_y, ds.drawing_area_top, ds.drawing_area_bottom);
+  max_y = std::clamp(max_y, ds.drawing_area_top, ds.drawing_area_bottom);
+
+  // compute per-pixel increments
+  const s32 a01 = py0 - py1, b01 = px1 - px0;
+  const s32 a12 = py1 - py2, b12 = px2 - px1;
+  const s32 a20 = py2 - py0, b20 = px0 - px2;
+
+  // top-left edge rule
+  const s32 w0_bias = 0 - s32(IsTopLeftEdge(b12, a12));
+  const s32 w1_bias = 0 - s32(IsTopLeftEdge(b20, a20));
   const s32 w2_bias = 0 - s32(IsTopLeftEdge(b01, a01));
 
   // compute base barycentric coordinates
@@ -345,40 +1411,82 @@ void GPU_SW::DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex
   s32 w1 = orient2d(px2, py2, px0, py0, min_x, min_y);
   s32 w2 = orient2d(px0, py0, px1, py1, min_x, min_y);
 
+  u8 span_r[VRAM_WIDTH];
+  u8 span_g[VRAM_WIDTH];
+  u8 span_b[VRAM_WIDTH];
+  u8 span_u[VRAM_WIDTH];
+  u8 span_v[VRAM_WIDTH];
+
   // *exclusive* of max coordinate in PSX
-  for (s32 y = min_y; y <= max_y; y++)
+  for (s32 y = min_y; y <= max_y; y++, w0 += b12, w1 += b20, w2 += b01)
   {
+    if (!ds.band.ContainsRow(static_cast<u32>(y)))
+      continue;
+
     s32 row_w0 = w0;
     s32 row_w1 = w1;
     s32 row_w2 = w2;
 
-    for (s32 x = min_x; x <= max_x; x++)
+    // The covered pixels of a row are contiguous, since each edge test is monotonic in x. Find the run, then
+    // interpolate and shade it as a whole.
+    s32 x = min_x;
+    for (; x <= max_x; x++, row_w0 += a12, row_w1 += a20, row_w2 += a01)
     {
       if (((row_w0 + w0_bias) | (row_w1 + w1_bias) | (row_w2 + w2_bias)) >= 0)
-      {
-        const s32 b0 = row_w0;
-        const s32 b1 = row_w1;
-        const s32 b2 = row_w2;
+        break;
+    }
+    if (x > max_x)
+      continue;
 
-        const u8 r = shading_enable ? Interpolate(v0->color_r, v1->color_r, v2->color_r, b0, b1, b2, ws) : v0->color_r;
-        const u8 g = shading_enable ? Interpolate(v0->color_g, v1->color_g, v2->color_g, b0, b1, b2, ws) : v0->color_g;
-        const u8 b = shading_enable ? Interpolate(v0->color_b, v1->color_b, v2->color_b, b0, b1, b2, ws) : v0->color_b;
+    const s32 span_x = x;
+    const s32 b0 = row_w0;
+    const s32 b1 = row_w1;
+    const s32 b2 = row_w2;
+    for (; x <= max_x; x++, row_w0 += a12, row_w1 += a20, row_w2 += a01)
+    {
+      if (((row_w0 + w0_bias) | (row_w1 + w1_bias) | (row_w2 + w2_bias)) < 0)
+        break;
+    }
+
+    const u32 count = static_cast<u32>(x - span_x);
+    const auto interpolate = [b0, b1, b2, a01, a12, a20, ws, count](u8* out, u8 c0, u8 c1, u8 c2) {
+      const s32 s0 = static_cast<s32>(ZeroExtend32(c0));
+      const s32 s1 = static_cast<s32>(ZeroExtend32(c1));
+      const s32 s2 = static_cast<s32>(ZeroExtend32(c2));
+      InterpolateSpan(out, b0 * s0 + b1 * s1 + b2 * s2, a12 * s0 + a20 * s1 + a01 * s2, ws, count);
+    };
+
+    if constexpr (shading_enable)
+    {
+      interpolate(span_r, v0->color_r, v1->color_r, v2->color_r);
+      interpolate(span_g, v0->color_g, v1->color_g, v2->color_g);
+      interpolate(span_b, v0->color_b, v1->color_b, v2->color_b);
+    }
 
-        const u8 texcoord_x = Interpolate(v0->texcoord_x, v1->texcoord_x, v2->texcoord_x, b0, b1, b2, ws);
-        const u8 texcoord_y = Interpolate(v0->texcoord_y, v1->texcoord_y, v2->texcoord_y, b0, b1, b2, ws);
+    if constexpr (texture_enable)
+    {
+      interpolate(span_u, v0->texcoord_x, v1->texcoord_x, v2->texcoord_x);
+      interpolate(span_v, v0->texcoord_y, v1->texcoord_y, v2->texcoord_y);
 
+      for (u32 i = 0; i < count; i++)
+      {
         ShadePixel<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-          static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
+          ds, static_cast<u32>(span_x) + i, static_cast<u32>(y), shading_enable ? span_r[i] : v0->color_r,
+          shading_enable ? span_g[i] : v0->color_g, shading_enable ? span_b[i] : v0->color_b, span_u[i], span_v[i]);
       }
-
-      row_w0 += a12;
-      row_w1 += a20;
-      row_w2 += a01;
     }
+    else
+    {
+      if constexpr (!shading_enable)
+      {
+        std::memset(span_r, v0->color_r, count);
+        std::memset(span_g, v0->color_g, count);
+        std::memset(span_b, v0->color_b, count);
+      }
 
-    w0 += b12;
-    w1 += b20;
-    w2 += b01;
+      ShadeSpan<transparency_enable, dithering_enable>(ds, static_cast<u32>(span_x), static_cast<u32>(y), count,
+                                                       span_r, span_g, span_b);
+    }
   }
 
 #undef orient2d
@@ -416,82 +1524,304 @@ GPU_SW::DrawTriangleFunction GPU_SW::GetDrawTriangleFunction(bool shading_enable
 }
 
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-void GPU_SW::DrawRectangle(s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b, u8 origin_texcoord_x,
-                           u8 origin_texcoord_y)
+void GPU_SW::DrawRectangle(const DrawState& ds, s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b,
+                           u8 origin_texcoord_x, u8 origin_texcoord_y)
 {
-  origin_x += m_drawing_offset.x;
-  origin_y += m_drawing_offset.y;
+  origin_x += ds.drawing_offset_x;
+  origin_y += ds.drawing_offset_y;
+
+  // clip horizontally once, every row covers the same columns
+  const s32 start_x = std::max(origin_x, ds.drawing_area_left);
+  const s32 end_x = std::min(origin_x + static_cast<s32>(width) - 1, ds.drawing_area_right);
+  if (start_x > end_x)
+    return;
+
+  const u32 count = static_cast<u32>(end_x - start_x + 1);
+  const u32 start_offset_x = static_cast<u32>(start_x - origin_x);
+
+  u8 span_r[VRAM_WIDTH];
+  u8 span_g[VRAM_WIDTH];
+  u8 span_b[VRAM_WIDTH];
+  if constexpr (!texture_enable)
+  {
+    std::memset(span_r, r, count);
+    std::memset(span_g, g, count);
+    std::memset(span_b, b, count);
+  }
 
   for (u32 offset_y = 0; offset_y < height; offset_y++)
   {
     const s32 y = origin_y + static_cast<s32>(offset_y);
-    if (y < static_cast<s32>(m_drawing_area.top) || y > static_cast<s32>(m_drawing_area.bottom))
+    if (y < ds.drawing_area_top || y > ds.drawing_area_bottom || !ds.band.ContainsRow(static_cast<u32>(y)))
+      continue;
+
+    if constexpr (!texture_enable)
+    {
+      ShadeSpan<transparency_enable, false>(ds, static_cast<u32>(start_x), static_cast<u32>(y), count, span_r, span_g,
+                                            span_b);
       continue;
+    }
 
     const u8 texcoord_y = Truncate8(ZeroExtend32(origin_texcoord_y) + offset_y);
 
-    for (u32 offset_x = 0; offset_x < width; offset_x++)
+    for (u32 i = 0; i < count; i++)
     {
-      const s32 x = origin_x + static_cast<s32>(offset_x);
-      if (x < static_cast<s32>(m_drawing_area.left) || x > static_cast<s32>(m_drawing_area.right))
-        continue;
-
-      const u8 texcoord_x = Truncate8(ZeroExtend32(origin_texcoord_x) + offset_x);
+      const u8 texcoord_x = Truncate8(ZeroExtend32(origin_texcoord_x) + start_offset_x + i);
 
       ShadePixel<texture_enable, raw_texture_enable, transparency_enable, false>(
-        static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
+        ds, static_cast<u32>(start_x) + i, static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
     }
   }
 }
 
+template<bool transparency_enable, bool dithering_enable>
+void GPU_SW::ShadeSpan(const DrawState& ds, u32 x, u32 y, u32 count, const u8* color_r, const u8* color_g,
+                       const u8* color_b)
+{
+  // Pixels are only adjacent in memory within a tile row, so wider spans are shaded a piece at a time.
+  while (count > GetContiguousPixels(x))
+  {
+    const u32 piece = GetContiguousPixels(x);
+    ShadeSpan<transparency_enable, dithering_enable>(ds, x, y, piece, color_r, color_g, color_b);
+    x += piece;
+    count -= piece;
+    color_r += piece;
+    color_g += piece;
+    color_b += piece;
+  }
+
+  u32 i = 0;
+
+#if defined(CPU_X64)
+  u16* row = GetPixelPtr(x, y);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max8 = _mm_set1_epi16(0xFF);
+  const __m128i max5 = _mm_set1_epi16(0x1F);
+  const __m128i mask_and = _mm_set1_epi16(static_cast<s16>(ds.mask_and));
+  const __m128i mask_or = _mm_set1_epi16(static_cast<s16>(ds.mask_or));
+
+  // the dither pattern repeats every four pixels, so eight pixels always see the same offsets
+  __m128i dither = zero;
+  if constexpr (dithering_enable)
+  {
+    const s32* dr = DITHER_MATRIX[y & 3];
+    dither = _mm_setr_epi16(static_cast<s16>(dr[x & 3]), static_cast<s16>(dr[(x + 1) & 3]),
+                            static_cast<s16>(dr[(x + 2) & 3]), static_cast<s16>(dr[(x + 3) & 3]),
+                            static_cast<s16>(dr[x & 3]), static_cast<s16>(dr[(x + 1) & 3]),
+                            static_cast<s16>(dr[(x + 2) & 3]), static_cast<s16>(dr[(x + 3) & 3]));
+  }
+
+  for (; (i + 8) <= count; i += 8)
+  {
+    __m128i r = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(color_r + i)), zero);
+    __m128i g = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(color_g + i)), zero);
+    __m128i b = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(color_b + i)), zero);
+    if constexpr (dithering_enable)
+    {
+      r = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(r, dither), zero), max8);
+      g = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(g, dither), zero), max8);
+      b = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(b, dither), zero), max8);
+    }
+    r = _mm_srli_epi16(r, 3);
+    g = _mm_srli_epi16(g, 3);
+    b = _mm_srli_epi16(b, 3);
+
+    const __m128i bg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+    if constexpr (transparency_enable)
+    {
+      const __m128i bg_r = _mm_and_si128(bg, max5);
+      const __m128i bg_g = _mm_and_si128(_mm_srli_epi16(bg, 5), max5);
+      const __m128i bg_b = _mm_and_si128(_mm_srli_epi16(bg, 10), max5);
+
+#define BLEND_AVERAGE(bg, fg) _mm_min_epi16(_mm_add_epi16(_mm_srli_epi16(bg, 1), _mm_srli_epi16(fg, 1)), max5)
+#define BLEND_ADD(bg, fg) _mm_min_epi16(_mm_add_epi16(bg, fg), max5)
+#define BLEND_SUBTRACT(bg, fg) _mm_subs_epu16(bg, fg)
+#define BLEND_QUARTER(bg, fg) _mm_min_epi16(_mm_add_epi16(bg, _mm_srli_epi16(fg, 2)), max5)
+
+#define BLEND_RGB(func)                                                                                                \
+  r = func(bg_r, r);                                                                                                   \
+  g = func(bg_g, g);                                                                                                   \
+  b = func(bg_b, b)
+
+      switch (ds.transparency_mode)
+      {
+        case GPU::TransparencyMode::HalfBackgroundPlusHalfForeground:
+          BLEND_RGB(BLEND_AVERAGE);
+          break;
+        case GPU::TransparencyMode::BackgroundPlusForeground:
+          BLEND_RGB(BLEND_ADD);
+          break;
+        case GPU::TransparencyMode::BackgroundMinusForeground:
+          BLEND_RGB(BLEND_SUBTRACT);
+          break;
+        case GPU::TransparencyMode::BackgroundPlusQuarterForeground:
+          BLEND_RGB(BLEND_QUARTER);
+          break;
+        default:
+          break;
+      }
+
+#undef BLEND_RGB
+
+#undef BLEND_QUARTER
+#undef BLEND_SUBTRACT
+#undef BLEND_ADD
+#undef BLEND_AVERAGE
+    }
+
+    const __m128i color =
+      _mm_or_si128(_mm_or_si128(r, _mm_slli_epi16(g, 5)), _mm_or_si128(_mm_slli_epi16(b, 10), mask_or));
+
+    // pixels whose background has the mask bit set are left untouched
+    const __m128i write = _mm_cmpeq_epi16(_mm_and_si128(bg, mask_and), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i),
+                     _mm_or_si128(_mm_and_si128(write, color), _mm_andnot_si128(write, bg)));
+  }
+#elif defined(CPU_AARCH64)
+  u16* row = GetPixelPtr(x, y);
+  const int16x8_t zero = vdupq_n_s16(0);
+  const int16x8_t max8 = vdupq_n_s16(0xFF);
+  const uint16x8_t max5 = vdupq_n_u16(0x1F);
+  const uint16x8_t mask_and = vdupq_n_u16(ds.mask_and);
+  const uint16x8_t mask_or = vdupq_n_u16(ds.mask_or);
+
+  // the dither pattern repeats every four pixels, so eight pixels always see the same offsets
+  int16x8_t dither = zero;
+  if constexpr (dithering_enable)
+  {
+    const s32* dr = DITHER_MATRIX[y & 3];
+    const s16 offsets[8] = {static_cast<s16>(dr[x & 3]),       static_cast<s16>(dr[(x + 1) & 3]),
+                            static_cast<s16>(dr[(x + 2) & 3]), static_cast<s16>(dr[(x + 3) & 3]),
+                            static_cast<s16>(dr[x & 3]),       static_cast<s16>(dr[(x + 1) & 3]),
+                            static_cast<s16>(dr[(x + 2) & 3]), static_cast<s16>(dr[(x + 3) & 3])};
+    dither = vld1q_s16(offsets);
+  }
+
+  for (; (i + 8) <= count; i += 8)
+  {
+    uint16x8_t r = vmovl_u8(vld1_u8(color_r + i));
+    uint16x8_t g = vmovl_u8(vld1_u8(color_g + i));
+    uint16x8_t b = vmovl_u8(vld1_u8(color_b + i));
+    if constexpr (dithering_enable)
+    {
+      r = vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(vaddq_s16(vreinterpretq_s16_u16(r), dither), zero), max8));
+      g = vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(vaddq_s16(vreinterpretq_s16_u16(g), dither), zero), max8));
+      b = vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(vaddq_s16(vreinterpretq_s16_u16(b), dither), zero), max8));
+    }
+    r = vshrq_n_u16(r, 3);
+    g = vshrq_n_u16(g, 3);
+    b = vshrq_n_u16(b, 3);
+
+    const uint16x8_t bg = vld1q_u16(row + i);
+    if constexpr (transparency_enable)
+    {
+      const uint16x8_t bg_r = vandq_u16(bg, max5);
+      const uint16x8_t bg_g = vandq_u16(vshrq_n_u16(bg, 5), max5);
+      const uint16x8_t bg_b = vandq_u16(vshrq_n_u16(bg, 10), max5);
+
+#define BLEND_AVERAGE(bg, fg) vminq_u16(vaddq_u16(vshrq_n_u16(bg, 1), vshrq_n_u16(fg, 1)), max5)
+#define BLEND_ADD(bg, fg) vminq_u16(vaddq_u16(bg, fg), max5)
+#define BLEND_SUBTRACT(bg, fg) vqsubq_u16(bg, fg)
+#define BLEND_QUARTER(bg, fg) vminq_u16(vaddq_u16(bg, vshrq_n_u16(fg, 2)), max5)
+
+#define BLEND_RGB(func)                                                                                                \
+  r = func(bg_r, r);                                                                                                   \
+  g = func(bg_g, g);                                                                                                   \
+  b = func(bg_b, b)
+
+      switch (ds.transparency_mode)
+      {
+        case GPU::TransparencyMode::HalfBackgroundPlusHalfForeground:
+          BLEND_RGB(BLEND_AVERAGE);
+          break;
+        case GPU::TransparencyMode::BackgroundPlusForeground:
+          BLEND_RGB(BLEND_ADD);
+          break;
+        case GPU::TransparencyMode::BackgroundMinusForeground:
+          BLEND_RGB(BLEND_SUBTRACT);
+          break;
+        case GPU::TransparencyMode::BackgroundPlusQuarterForeground:
+          BLEND_RGB(BLEND_QUARTER);
+          break;
+        default:
+          break;
+      }
+
+#undef BLEND_RGB
+
+#undef BLEND_QUARTER
+#undef BLEND_SUBTRACT
+#undef BLEND_ADD
+#undef BLEND_AVERAGE
+    }
+
+    const uint16x8_t color = vorrq_u16(vorrq_u16(r, vshlq_n_u16(g, 5)), vorrq_u16(vshlq_n_u16(b, 10), mask_or));
+
+    // pixels whose background has the mask bit set are left untouched
+    vst1q_u16(row + i, vbslq_u16(vtstq_u16(bg, mask_and), bg, color));
+  }
+#endif
+
+  for (; i < count; i++)
+  {
+    ShadePixel<false, false, transparency_enable, dithering_enable>(ds, x + i, y, color_r[i], color_g[i], color_b[i],
+                                                                    0, 0);
+  }
+}
+
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
-void GPU_SW::ShadePixel(u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y)
+void GPU_SW::ShadePixel(const DrawState& ds, u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x,
+                        u8 texcoord_y)
 {
   VRAMPixel color;
   bool transparent;
   if constexpr (texture_enable)
   {
     // Apply texture window
-    // TODO: Precompute the second half
-    texcoord_x = (texcoord_x & ~(m_draw_mode.texture_window_mask_x * 8u)) |
-                 ((m_draw_mode.texture_window_offset_x & m_draw_mode.texture_window_mask_x) * 8u);
-    texcoord_y = (texcoord_y & ~(m_draw_mode.texture_window_mask_y * 8u)) |
-                 ((m_draw_mode.texture_window_offset_y & m_draw_mode.texture_window_mask_y) * 8u);
+    texcoord_x = (texcoord_x & ds.texture_window_and_x) | ds.texture_window_or_x;
+    texcoord_y = (texcoord_y & ds.texture_window_and_y) | ds.texture_window_or_y;
 
     VRAMPixel texture_color;
-    switch (m_draw_mode.GetTextureMode())
+    if (ds.texture_page)
+    {
+      texture_color.bits = GetCachedTexel(ds.texture_page, texcoord_x, texcoord_y);
+    }
+    else
     {
-      case GPU::TextureMode::Palette4Bit:
+      switch (ds.texture_mode)
       {
-        const u16 palette_value =
-          GetPixel(std::min<u32>(m_draw_mode.texture_page_x + ZeroExtend32(texcoord_x / 4), VRAM_WIDTH - 1),
-                   std::min<u32>(m_draw_mode.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
-        const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
-        texture_color.bits =
-          GetPixel(std::min<u32>(m_draw_mode.texture_palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1),
-                   m_draw_mode.texture_palette_y);
-      }
-      break;
+        case GPU::TextureMode::Palette4Bit:
+        {
+          const u16 palette_value =
+            GetPixel(std::min<u32>(ds.texture_page_x + ZeroExtend32(texcoord_x / 4), VRAM_WIDTH - 1),
+                     std::min<u32>(ds.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
+          const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
+          texture_color.bits =
+            GetPixel(std::min<u32>(ds.texture_palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1),
+                     ds.texture_palette_y);
+        }
+        break;
 
-      case GPU::TextureMode::Palette8Bit:
-      {
-        const u16 palette_value =
-          GetPixel(std::min<u32>(m_draw_mode.texture_page_x + ZeroExtend32(texcoord_x / 2), VRAM_WIDTH - 1),
-                   std::min<u32>(m_draw_mode.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
-        const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
-        texture_color.bits =
-          GetPixel(std::min<u32>(m_draw_mode.texture_palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1),
-                   m_draw_mode.texture_palette_y);
-      }
-      break;
+        case GPU::TextureMode::Palette8Bit:
+        {
+          const u16 palette_value =
+            GetPixel(std::min<u32>(ds.texture_page_x + ZeroExtend32(texcoord_x / 2), VRAM_WIDTH - 1),
+                     std::min<u32>(ds.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
+          const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
+          texture_color.bits =
+            GetPixel(std::min<u32>(ds.texture_palette_x + ZeroExtend32(palette_index), VRAM_WIDTH - 1),
+                     ds.texture_palette_y);
+        }
+        break;
 
-      default:
-      {
-        texture_color.bits =
-          GetPixel(std::min<u32>(m_draw_mode.texture_page_x + ZeroExtend32(texcoord_x), VRAM_WIDTH - 1),
-                   std::min<u32>(m_draw_mode.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
+        default:
+        {
+          texture_color.bits =
+            GetPixel(std::min<u32>(ds.texture_page_x + ZeroExtend32(texcoord_x), VRAM_WIDTH - 1),
+                     std::min<u32>(ds.texture_page_y + ZeroExtend32(texcoord_y), VRAM_HEIGHT - 1));
+        }
+        break;
       }
-      break;
     }
 
     if (texture_color.bits == 0)
@@ -538,7 +1868,7 @@ void GPU_SW::ShadePixel(u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 tex
   color.Set(func(bg_color.r.GetValue(), color.r.GetValue()), func(bg_color.g.GetValue(), color.g.GetValue()),          \
             func(bg_color.b.GetValue(), color.b.GetValue()), color.c.GetValue())
 
-      switch (m_draw_mode.GetTransparencyMode())
+      switch (ds.transparency_mode)
       {
         case GPU::TransparencyMode::HalfBackgroundPlusHalfForeground:
           BLEND_RGB(BLEND_AVERAGE);
@@ -569,11 +1899,10 @@ void GPU_SW::ShadePixel(u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 tex
     UNREFERENCED_VARIABLE(transparent);
   }
 
-  const u16 mask_and = m_GPUSTAT.GetMaskAND();
-  if ((bg_color.bits & mask_and) != 0)
+  if ((bg_color.bits & ds.mask_and) != 0)
     return;
 
-  SetPixel(static_cast<u32>(x), static_cast<u32>(y), color.bits | m_GPUSTAT.GetMaskOR());
+  SetPixel(static_cast<u32>(x), static_cast<u32>(y), color.bits | ds.mask_or);
 }
 
 constexpr FixedPointCoord GetLineCoordStep(s32 delta, s32 k)
@@ -598,7 +1927,7 @@ constexpr FixedPointColor GetLineColorStep(s32 delta, s32 k)
 }
 
 template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-void GPU_SW::DrawLine(const SWVertex* p0, const SWVertex* p1)
+void GPU_SW::DrawLine(const DrawState& ds, const SWVertex* p0, const SWVertex* p1)
 {
   // Algorithm based on Mednafen.
   if (p0->x > p1->x)
@@ -645,18 +1974,18 @@ void GPU_SW::DrawLine(const SWVertex* p0, const SWVertex* p1)
 
   for (s32 i = 0; i <= k; i++)
   {
-    const s32 x = m_drawing_offset.x + FixedToIntCoord(current_x);
-    const s32 y = m_drawing_offset.y + FixedToIntCoord(current_y);
+    const s32 x = ds.drawing_offset_x + FixedToIntCoord(current_x);
+    const s32 y = ds.drawing_offset_y + FixedToIntCoord(current_y);
 
     const u8 r = shading_enable ? FixedColorToInt(current_r) : p0->color_r;
     const u8 g = shading_enable ? FixedColorToInt(current_g) : p0->color_g;
     const u8 b = shading_enable ? FixedColorToInt(current_b) : p0->color_b;
 
-    if (x >= static_cast<s32>(m_drawing_area.left) && x <= static_cast<s32>(m_drawing_area.right) &&
-        y >= static_cast<s32>(m_drawing_area.top) && y <= static_cast<s32>(m_drawing_area.bottom))
+    if (x >= ds.drawing_area_left && x <= ds.drawing_area_right &&
+        y >= ds.drawing_area_top && y <= ds.drawing_area_bottom && ds.band.ContainsRow(static_cast<u32>(y)))
     {
-      ShadePixel<false, false, transparency_enable, dithering_enable>(static_cast<u32>(x), static_cast<u32>(y), r, g, b,
-                                                                      0, 0);
+      ShadePixel<false, false, transparency_enable, dithering_enable>(ds, static_cast<u32>(x), static_cast<u32>(y), r,
+                                                                      g, b, 0, 0);
     }
 
     current_x += step_x;
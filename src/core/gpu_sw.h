@@ -1,7 +1,12 @@
 #pragma once
+#include "common/heap_array.h"
 #include "gpu.h"
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 class HostDisplayTexture;
@@ -9,6 +14,12 @@ class HostDisplayTexture;
 class GPU_SW final : public GPU
 {
 public:
+  enum : u32
+  {
+    VRAM_TILE_WIDTH = 16,
+    VRAM_TILE_HEIGHT = 4
+  };
+
   GPU_SW();
   ~GPU_SW() override;
 
@@ -17,11 +28,32 @@ public:
   bool Initialize(HostDisplay* host_display, System* system, DMA* dma, InterruptController* interrupt_controller,
                   Timers* timers) override;
   void Reset() override;
+  bool DoState(StateWrapper& sw, bool use_vram_snapshot = false) override;
+  void UpdateSettings() override;
+
+  /// Returns true if rasterization is being performed on worker threads.
+  bool IsUsingThread() const { return !m_worker_threads.empty(); }
+
+#ifdef WITH_SW_TILED_VRAM
+  /// VRAM is stored as 16x4 pixel tiles, so texture walks in any direction stay within a few cache lines.
+  static constexpr u32 GetPixelOffset(u32 x, u32 y)
+  {
+    return ((y / VRAM_TILE_HEIGHT) * (VRAM_WIDTH / VRAM_TILE_WIDTH) + (x / VRAM_TILE_WIDTH)) *
+             (VRAM_TILE_WIDTH * VRAM_TILE_HEIGHT) +
+           (y % VRAM_TILE_HEIGHT) * VRAM_TILE_WIDTH + (x % VRAM_TILE_WIDTH);
+  }
 
-  u16 GetPixel(u32 x, u32 y) const { return m_vram[VRAM_WIDTH * y + x]; }
-  const u16* GetPixelPtr(u32 x, u32 y) const { return &m_vram[VRAM_WIDTH * y + x]; }
-  u16* GetPixelPtr(u32 x, u32 y) { return &m_vram[VRAM_WIDTH * y + x]; }
-  void SetPixel(u32 x, u32 y, u16 value) { m_vram[VRAM_WIDTH * y + x] = value; }
+  /// Returns the number of pixels from x which are adjacent in memory.
+  static constexpr u32 GetContiguousPixels(u32 x) { return VRAM_TILE_WIDTH - (x % VRAM_TILE_WIDTH); }
+#else
+  static constexpr u32 GetPixelOffset(u32 x, u32 y) { return VRAM_WIDTH * y + x; }
+  static constexpr u32 GetContiguousPixels(u32 x) { return VRAM_WIDTH - x; }
+#endif
+
+  u16 GetPixel(u32 x, u32 y) const { return m_vram[GetPixelOffset(x, y)]; }
+  const u16* GetPixelPtr(u32 x, u32 y) const { return &m_vram[GetPixelOffset(x, y)]; }
+  u16* GetPixelPtr(u32 x, u32 y) { return &m_vram[GetPixelOffset(x, y)]; }
+  void SetPixel(u32 x, u32 y, u16 value) { m_vram[GetPixelOffset(x, y)] = value; }
 
 protected:
   struct SWVertex
@@ -40,6 +72,43 @@ protected:
     ALWAYS_INLINE void SetTexcoord(u16 value) { std::tie(texcoord_x, texcoord_y) = UnpackTexcoord(value); }
   };
 
+  /// Set of interleaved VRAM rows which a worker thread is responsible for.
+  struct Band
+  {
+    u32 index;
+    u32 count;
+
+    ALWAYS_INLINE bool ContainsRow(u32 y) const { return count == 1 || ((y / BAND_HEIGHT) % count) == index; }
+  };
+
+  struct TexturePage;
+
+  /// GPU state which affects rasterization. Captured when a command is queued, so the worker never reads registers.
+  struct DrawState
+  {
+    s32 drawing_area_left;
+    s32 drawing_area_top;
+    s32 drawing_area_right;
+    s32 drawing_area_bottom;
+    s32 drawing_offset_x;
+    s32 drawing_offset_y;
+    u32 texture_page_x;
+    u32 texture_page_y;
+    u32 texture_palette_x;
+    u32 texture_palette_y;
+    u8 texture_window_and_x;
+    u8 texture_window_and_y;
+    u8 texture_window_or_x;
+    u8 texture_window_or_y;
+    TextureMode texture_mode;
+    TransparencyMode transparency_mode;
+    u16 mask_and;
+    u16 mask_or;
+    Band band;
+    bool use_texture_page_cache;
+    TexturePage* texture_page; // looked up by the worker when the texture page cache is used
+  };
+
   //////////////////////////////////////////////////////////////////////////
   // Scanout
   //////////////////////////////////////////////////////////////////////////
@@ -47,44 +116,274 @@ protected:
 
   static void CopyOut24Bit(const u16* src_ptr, u32 src_stride, u32* dst_ptr, u32 dst_stride, u32 width, u32 height);
 
+  /// Converts and uploads the rows of the display area which have changed since it was last scanned out.
+  void UpdateDisplayTexture(u32 x, u32 y, u32 width, u32 height, bool color_24bit);
+
   void UpdateDisplay() override;
 
+  //////////////////////////////////////////////////////////////////////////
+  // VRAM Transfers
+  //////////////////////////////////////////////////////////////////////////
+  void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
+#ifdef WITH_SW_TILED_VRAM
+  /// Copies the specified area from the tiled VRAM to the linear shadow, handling wrap-around.
+  void UpdateVRAMShadow(u32 x, u32 y, u32 width, u32 height);
+#endif
+  void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
+  void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data) override;
+  void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
+
+  void FillVRAMImpl(const Band& band, u32 x, u32 y, u32 width, u32 height, u16 color);
+  void UpdateVRAMImpl(const Band& band, u32 x, u32 y, u32 width, u32 height, const void* data, u16 mask_and,
+                      u16 mask_or);
+  void CopyVRAMImpl(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height, u16 mask_and, u16 mask_or);
+
   //////////////////////////////////////////////////////////////////////////
   // Rasterization
   //////////////////////////////////////////////////////////////////////////
 
   void DispatchRenderCommand(RenderCommand rc, u32 num_vertices, const u32* command_ptr) override;
 
+  /// Captures the current drawing area/offset, texture and mask state.
+  DrawState GetDrawState() const;
+
+  /// Flags the rows between the specified vertex coordinates for scanout, clipped to the drawing area.
+  void MarkDrawnRowsDirty(s32 min_y, s32 max_y);
+
   static bool IsClockwiseWinding(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2);
 
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
-  void ShadePixel(u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y);
+  void ShadePixel(const DrawState& ds, u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x,
+                  u8 texcoord_y);
+
+  /// Shades a horizontal run of untextured pixels, several at a time where the host supports SIMD.
+  template<bool transparency_enable, bool dithering_enable>
+  void ShadeSpan(const DrawState& ds, u32 x, u32 y, u32 count, const u8* color_r, const u8* color_g,
+                 const u8* color_b);
 
   template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
            bool dithering_enable>
-  void DrawTriangle(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2);
+  void DrawTriangle(const DrawState& ds, const SWVertex* v0, const SWVertex* v1, const SWVertex* v2);
 
-  using DrawTriangleFunction = void (GPU_SW::*)(const SWVertex* v0, const SWVertex* v1, const SWVertex* v2);
+  using DrawTriangleFunction = void (GPU_SW::*)(const DrawState& ds, const SWVertex* v0, const SWVertex* v1,
+                                                const SWVertex* v2);
   DrawTriangleFunction GetDrawTriangleFunction(bool shading_enable, bool texture_enable, bool raw_texture_enable,
                                                bool transparency_enable, bool dithering_enable);
 
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-  void DrawRectangle(s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b, u8 origin_texcoord_x,
-                     u8 origin_texcoord_y);
+  void DrawRectangle(const DrawState& ds, s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b,
+                     u8 origin_texcoord_x, u8 origin_texcoord_y);
 
-  using DrawRectangleFunction = void (GPU_SW::*)(s32 origin_x, s32 origin_y, u32 width, u32 height, u8 r, u8 g, u8 b,
-                                                 u8 origin_texcoord_x, u8 origin_texcoord_y);
+  using DrawRectangleFunction = void (GPU_SW::*)(const DrawState& ds, s32 origin_x, s32 origin_y, u32 width,
+                                                 u32 height, u8 r, u8 g, u8 b, u8 origin_texcoord_x,
+                                                 u8 origin_texcoord_y);
   DrawRectangleFunction GetDrawRectangleFunction(bool texture_enable, bool raw_texture_enable,
                                                  bool transparency_enable);
 
   template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-  void DrawLine(const SWVertex* p0, const SWVertex* p1);
+  void DrawLine(const DrawState& ds, const SWVertex* p0, const SWVertex* p1);
 
-  using DrawLineFunction = void (GPU_SW::*)(const SWVertex* p0, const SWVertex* p1);
+  using DrawLineFunction = void (GPU_SW::*)(const DrawState& ds, const SWVertex* p0, const SWVertex* p1);
   DrawLineFunction GetDrawLineFunction(bool shading_enable, bool transparency_enable, bool dithering_enable);
 
+  //////////////////////////////////////////////////////////////////////////
+  // Command FIFO
+  //////////////////////////////////////////////////////////////////////////
+  enum : u32
+  {
+    COMMAND_FIFO_SIZE = 4 * 1024 * 1024,
+    COMMAND_ALIGNMENT = 8,
+    MAX_LINE_VERTICES_PER_COMMAND = 256,
+    MAX_WORKER_THREADS = 8,
+    BAND_HEIGHT = 8,
+    NUM_ROW_BLOCKS = VRAM_HEIGHT / BAND_HEIGHT,
+    HAZARD_BLOCK_WIDTH = 64,
+    NUM_COLUMN_BLOCKS = VRAM_WIDTH / HAZARD_BLOCK_WIDTH
+  };
+
+  enum class CommandType : u8
+  {
+    Wraparound,
+    Barrier,
+    FillVRAM,
+    UpdateVRAM,
+    CopyVRAM,
+    DrawPolygon,
+    DrawRectangle,
+    DrawLine
+  };
+
+  struct Command
+  {
+    CommandType type;
+    bool serial; // executed by the first worker alone, covering every row
+    u32 size;
+  };
+
+  struct FillVRAMCommand : Command
+  {
+    u16 x, y, width, height;
+    u16 color;
+  };
+
+  // Followed by width * height pixels.
+  struct UpdateVRAMCommand : Command
+  {
+    u16 x, y, width, height;
+    u16 mask_and, mask_or;
+  };
+
+  struct CopyVRAMCommand : Command
+  {
+    u16 src_x, src_y, dst_x, dst_y, width, height;
+    u16 mask_and, mask_or;
+  };
+
+  struct DrawPolygonCommand : Command
+  {
+    DrawState draw_state;
+    DrawTriangleFunction draw_function;
+    u32 num_vertices;
+    std::array<SWVertex, 4> vertices;
+  };
+
+  struct DrawRectangleCommand : Command
+  {
+    DrawState draw_state;
+    DrawRectangleFunction draw_function;
+    s32 x, y;
+    u32 width, height;
+    u8 r, g, b;
+    u8 texcoord_x, texcoord_y;
+  };
+
+  // Followed by num_vertices vertices.
+  struct DrawLineCommand : Command
+  {
+    DrawState draw_state;
+    DrawLineFunction draw_function;
+    u32 num_vertices;
+  };
+
+  /// Reserves space for a command. When the worker thread is not running, the start of the FIFO is used as scratch.
+  template<typename T>
+  T* AllocateCommand(CommandType type, u32 size = sizeof(T));
+  void* AllocateFIFOSpace(u32 size);
+
+  /// Executes the command immediately, or hands it to the worker thread.
+  void PushCommand(Command* cmd);
+
+  void ExecuteCommand(const Command* cmd, const Band& worker_band);
+
+  /// Returns a mask of the 8-line row blocks touched by the specified rows, handling wrap-around.
+  static u64 GetRowBlockMask(u32 y, u32 height);
+
+  /// Set of 64x8 VRAM blocks, stored as a row block mask for each column of blocks.
+  using BlockMask = std::array<u64, NUM_COLUMN_BLOCKS>;
+
+  /// Adds the blocks touched by the specified rectangle to the mask, handling wrap-around.
+  static void AddRectToBlockMask(BlockMask& mask, u32 x, u32 y, u32 width, u32 height);
+  static bool BlockMasksOverlap(const BlockMask& lhs, const BlockMask& rhs);
+
+  /// Queues a barrier if another band could still be writing the blocks which are about to be read, or still be
+  /// reading the blocks which are about to be written. The accesses are then recorded.
+  void CheckForBandHazard(const BlockMask& read_blocks, const BlockMask& write_blocks);
+
+  /// Queues a barrier, after which nothing is pending.
+  void PushBarrier();
+
+  /// Returns the read pointer of the worker which is furthest behind.
+  u32 GetSlowestWorkerReadPtr() const;
+  bool AreWorkersIdle() const;
+
+  void StartWorkerThreads();
+  void StopWorkerThreads();
+  void WorkerThreadEntryPoint(u32 index);
+  void WaitForBarrier();
+
+  /// Blocks until the worker threads have executed all queued commands.
+  void SyncWorkerThreads();
+
+  //////////////////////////////////////////////////////////////////////////
+  // Texture Page Cache
+  //////////////////////////////////////////////////////////////////////////
+  enum : u32
+  {
+    TEXTURE_PAGE_CACHE_SIZE = 16,
+    TEXTURE_PAGE_TILE_SIZE = 16,
+    TEXTURE_PAGE_TILES_PER_ROW = TEXTURE_PAGE_WIDTH / TEXTURE_PAGE_TILE_SIZE,
+    NUM_TEXTURE_PAGE_TILES = TEXTURE_PAGE_TILES_PER_ROW * (TEXTURE_PAGE_HEIGHT / TEXTURE_PAGE_TILE_SIZE),
+    INVALID_TEXTURE_PAGE_KEY = 0xFFFFFFFFu
+  };
+
+  /// Palette texture page decoded to 16-bit texels, which are filled in a tile at a time as they are sampled.
+  struct TexturePage
+  {
+    u32 key;
+    u32 last_used;
+    u32 page_x, page_y;
+    u32 palette_x, palette_y;
+    TextureMode mode;
+    BlockMask source_blocks;
+    std::array<u64, NUM_TEXTURE_PAGE_TILES / 64> valid_tiles;
+    std::array<u16, TEXTURE_PAGE_WIDTH * TEXTURE_PAGE_HEIGHT> texels;
+  };
+
+  /// Each worker sees every command, so it keeps a cache of its own which is invalidated in step with VRAM writes.
+  struct TexturePageCache
+  {
+    std::vector<std::unique_ptr<TexturePage>> pages;
+    u32 counter = 0;
+  };
+
+  /// Returns the decoded page for the draw's texture page, palette and mode, replacing the least recently used.
+  TexturePage* LookupTexturePage(TexturePageCache& cache, const DrawState& ds);
+
+  /// Drops any cached pages whose texels or palette could be modified by the command.
+  void InvalidateTexturePages(TexturePageCache& cache, const Command* cmd);
+  void InvalidateTexturePages(TexturePageCache& cache, const BlockMask& write_blocks);
+  void InvalidateAllTexturePages();
+
+  void DecodeTexturePageTile(TexturePage* page, u32 tile);
+  u16 GetCachedTexel(TexturePage* page, u8 texcoord_x, u8 texcoord_y);
+
   std::vector<u32> m_display_texture_buffer;
   std::unique_ptr<HostDisplayTexture> m_display_texture;
 
+  // Area of VRAM which the display texture currently holds, and the row blocks written since it was scanned out.
+  u32 m_scanout_x = 0;
+  u32 m_scanout_y = 0;
+  u32 m_scanout_width = 0;
+  u32 m_scanout_height = 0;
+  bool m_scanout_24bit = false;
+  u64 m_scanout_dirty_row_blocks = ~UINT64_C(0);
+
   std::array<u16, VRAM_WIDTH * VRAM_HEIGHT> m_vram;
+
+#ifdef WITH_SW_TILED_VRAM
+  // Linear copy of VRAM for GPUREAD, save states and scanout, refreshed by ReadVRAM().
+  HeapArray<u16, VRAM_WIDTH * VRAM_HEIGHT> m_vram_shadow;
+#endif
+
+  HeapArray<u8, COMMAND_FIFO_SIZE> m_command_fifo;
+  std::array<std::atomic<u32>, MAX_WORKER_THREADS> m_command_fifo_read_ptrs = {};
+  std::atomic<u32> m_command_fifo_write_ptr{0};
+
+  // Each worker rasterizes its own band of rows, the whole FIFO is seen by every worker.
+  std::vector<std::thread> m_worker_threads;
+  u32 m_num_workers = 0;
+  std::mutex m_worker_mutex;
+  std::condition_variable m_worker_wake_cv;
+  std::condition_variable m_worker_idle_cv;
+  std::atomic<u32> m_workers_sleeping{0};
+  std::atomic_bool m_worker_shutdown_flag{false};
+  std::atomic<u32> m_barrier_arrived{0};
+  std::atomic<u32> m_barrier_generation{0};
+
+  // Blocks which have been read or written by commands queued since the last barrier.
+  BlockMask m_pending_read_blocks = {};
+  BlockMask m_pending_write_blocks = {};
+
+  // Indexed by worker, the first is also used when rasterizing on the CPU thread.
+  std::array<TexturePageCache, MAX_WORKER_THREADS> m_texture_page_caches;
 };
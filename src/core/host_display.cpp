@@ -18,6 +18,24 @@ void HostDisplay::WindowResized(s32 new_window_width, s32 new_window_height)
   m_window_height = new_window_height;
 }
 
+bool HostDisplay::MakeRenderContextCurrent()
+{
+  return false;
+}
+
+bool HostDisplay::DoneRenderContextCurrent()
+{
+  return false;
+}
+
+bool HostDisplay::SetThreadedPresentation(bool enabled)
+{
+  if (enabled)
+    Log_WarningPrintf("Threaded presentation is not supported by this display");
+
+  return !enabled;
+}
+
 std::tuple<s32, s32, s32, s32> HostDisplay::CalculateDrawRect() const
 {
   const s32 window_width = m_window_width;
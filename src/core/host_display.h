@@ -53,6 +53,19 @@ public:
 
   virtual void SetVSync(bool enabled) = 0;
 
+  /// Makes the rendering context current on the calling thread, for renderers which submit from a thread of their own.
+  /// Returns false if the context can't be moved between threads.
+  virtual bool MakeRenderContextCurrent();
+
+  /// Releases the rendering context from the calling thread, so another thread can make it current.
+  virtual bool DoneRenderContextCurrent();
+
+  /// Moves presentation to a thread of its own, so waiting for vsync doesn't block the caller of Render().
+  /// Returns false if the display can't present from another thread.
+  virtual bool SetThreadedPresentation(bool enabled);
+
+  bool IsUsingThreadedPresentation() const { return m_threaded_presentation; }
+
   const s32 GetDisplayTopMargin() const { return m_display_top_margin; }
 
   void ClearDisplayTexture()
@@ -124,4 +137,5 @@ protected:
 
   bool m_display_linear_filtering = false;
   bool m_display_changed = false;
+  bool m_threaded_presentation = false;
 };
@@ -6,18 +6,24 @@
 #include "common/file_system.h"
 #include "common/log.h"
 #include "common/string_util.h"
+#include "common/trace.h"
 #include "dma.h"
 #include "game_list.h"
 #include "gpu.h"
 #include "host_display.h"
 #include "mdec.h"
+#include "save_state_version.h"
 #include "spu.h"
 #include "system.h"
 #include "timers.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
 #include <imgui.h>
 #include <stdlib.h>
+#include <zlib.h>
 Log_SetChannel(HostInterface);
 
 #ifdef WIN32
@@ -49,6 +55,74 @@ static std::string GetRelativePath(const std::string& path, const char* new_file
 
 #endif
 
+struct HostInterface::RewindData
+{
+  RewindData() { compress_thread = std::thread(&RewindData::CompressThreadEntryPoint, this); }
+
+  ~RewindData()
+  {
+    {
+      std::unique_lock<std::mutex> lock(compress_mutex);
+      compress_shutdown = true;
+      compress_wake_cv.notify_one();
+    }
+
+    compress_thread.join();
+  }
+
+  /// Hands the delta between current_state and new_state to the worker.
+  void StartCompression();
+
+  /// Blocks until the worker has finished the last delta. Returns false if it couldn't be compressed.
+  bool WaitForCompression();
+
+  void CompressThreadEntryPoint();
+  bool CompressDelta();
+
+  struct Entry
+  {
+    // State N XOR state N-1, deflated. Applying it to state N gives back state N-1.
+    std::vector<u8> compressed_delta;
+    u32 state_size;
+  };
+
+  std::deque<Entry> entries;
+  System::MemorySaveState current_state;
+  System::MemorySaveState new_state;
+  std::vector<u8> delta_buffer;
+  std::vector<u8> compress_buffer;
+  u64 total_size = 0;
+  u64 max_size = 0;
+  u32 save_frequency = 0;
+  u32 frames_since_save = 0;
+  bool has_current_state = false;
+
+  // Builds the delta between the two states. Everything above is owned by it while compress_pending is set.
+  std::mutex compress_mutex;
+  std::condition_variable compress_wake_cv;
+  std::condition_variable compress_done_cv;
+  bool compress_pending = false;
+  bool compress_failed = false;
+  bool compress_shutdown = false;
+  std::thread compress_thread;
+};
+
+static void XORStateBuffer(u8* dst, const u8* src, u32 size)
+{
+  u32 i = 0;
+  for (; (i + sizeof(u64)) <= size; i += sizeof(u64))
+  {
+    u64 dst_word, src_word;
+    std::memcpy(&dst_word, dst + i, sizeof(dst_word));
+    std::memcpy(&src_word, src + i, sizeof(src_word));
+    dst_word ^= src_word;
+    std::memcpy(dst + i, &dst_word, sizeof(dst_word));
+  }
+
+  for (; i < size; i++)
+    dst[i] ^= src[i];
+}
+
 HostInterface::HostInterface()
 {
   SetUserDirectory();
@@ -62,6 +136,7 @@ HostInterface::~HostInterface()
 {
   // system should be shut down prior to the destructor
   Assert(!m_system && !m_audio_stream && !m_display);
+  WaitForSaveStateWrite();
 }
 
 void HostInterface::CreateAudioStream()
@@ -79,6 +154,9 @@ void HostInterface::CreateAudioStream()
 
 bool HostInterface::BootSystem(const SystemBootParameters& parameters)
 {
+  // The system always runs on the thread which boots it.
+  Trace::SetThreadName("Emulation");
+
   if (!AcquireHostDisplay())
   {
     ReportFormattedError("Failed to acquire host display");
@@ -87,6 +165,7 @@ bool HostInterface::BootSystem(const SystemBootParameters& parameters)
 
   // set host display settings
   m_display->SetDisplayLinearFiltering(m_settings.display_linear_filtering);
+  m_display->SetThreadedPresentation(m_settings.display_threaded_presentation);
 
   // create the audio stream. this will never fail, since we'll just fall back to null
   CreateAudioStream();
@@ -100,6 +179,7 @@ bool HostInterface::BootSystem(const SystemBootParameters& parameters)
   }
 
   OnSystemCreated();
+  UpdateRewindSettings();
 
   m_paused = m_settings.start_paused;
   m_audio_stream->PauseOutput(m_paused);
@@ -114,6 +194,34 @@ bool HostInterface::BootSystem(const SystemBootParameters& parameters)
   return true;
 }
 
+bool HostInterface::BootSystemForGPUDumpReplay()
+{
+  Trace::SetThreadName("Emulation");
+
+  if (!AcquireHostDisplay())
+  {
+    ReportFormattedError("Failed to acquire host display");
+    return false;
+  }
+
+  m_display->SetDisplayLinearFiltering(m_settings.display_linear_filtering);
+  m_display->SetThreadedPresentation(m_settings.display_threaded_presentation);
+  CreateAudioStream();
+
+  m_system = System::Create(this);
+  if (!m_system)
+  {
+    ReportFormattedError("Failed to create system for GPU dump replay.");
+    m_audio_stream.reset();
+    ReleaseHostDisplay();
+    return false;
+  }
+
+  m_system->BootForGPUDumpReplay();
+  OnSystemCreated();
+  return true;
+}
+
 void HostInterface::PauseSystem(bool paused)
 {
   if (paused == m_paused || !m_system)
@@ -131,6 +239,7 @@ void HostInterface::PauseSystem(bool paused)
 void HostInterface::ResetSystem()
 {
   m_system->Reset();
+  ClearRewindStates();
   m_system->ResetPerformanceCounters();
   AddOSDMessage("System reset.");
 }
@@ -152,8 +261,12 @@ void HostInterface::DestroySystem()
     return;
 
   SetTimerResolutionIncreased(false);
+  WaitForSaveStateWrite();
 
   m_paused = false;
+  m_rewinding = false;
+  WaitForRewindCompression();
+  m_rewind_data.reset();
   m_system.reset();
   m_audio_stream.reset();
   ReleaseHostDisplay();
@@ -218,20 +331,97 @@ void HostInterface::DrawImGuiWindows()
   DrawOSDMessages();
 }
 
+static void DrawFrameTimesGraph(const FrameTimings& frame_timings, float scale)
+{
+  static constexpr std::array<ImU32, FrameTimings::NUM_CATEGORIES> category_colors = {{
+    IM_COL32(0, 0, 0, 0),         // None
+    IM_COL32(160, 160, 160, 255), // System
+    IM_COL32(255, 100, 100, 255), // CPU
+    IM_COL32(255, 180, 80, 255),  // Events
+    IM_COL32(100, 220, 100, 255), // GPU
+    IM_COL32(100, 160, 255, 255), // SPU
+    IM_COL32(220, 120, 255, 255), // CDROM
+    IM_COL32(255, 255, 120, 255), // Presentation
+  }};
+
+  const u32 count = frame_timings.GetHistoryCount();
+  const float bar_width = 2.0f * scale;
+  const float graph_width = bar_width * static_cast<float>(FrameTimings::HISTORY_SIZE);
+  const float graph_height = 64.0f * scale;
+
+  // Scale to the slowest frame, but never below a 60hz frame, so fast frames don't fill the graph.
+  FrameTimings::FrameTimes average_times = {};
+  float max_time = 1000.0f / 60.0f;
+  for (u32 i = 0; i < count; i++)
+  {
+    const FrameTimings::FrameTimes& frame = frame_timings.GetHistoryFrame(i);
+    float frame_time = 0.0f;
+    for (u32 category = 1; category < FrameTimings::NUM_CATEGORIES; category++)
+    {
+      frame_time += frame[category];
+      average_times[category] += frame[category];
+    }
+    max_time = std::max(max_time, frame_time);
+  }
+
+  ImDrawList* dl = ImGui::GetWindowDrawList();
+  const ImVec2 pos = ImGui::GetCursorScreenPos();
+  const float y_scale = graph_height / max_time;
+  dl->AddRectFilled(pos, ImVec2(pos.x + graph_width, pos.y + graph_height), IM_COL32(0, 0, 0, 128));
+
+  for (u32 i = 0; i < count; i++)
+  {
+    const FrameTimings::FrameTimes& frame = frame_timings.GetHistoryFrame(i);
+    const float x = pos.x + graph_width - static_cast<float>(count - i) * bar_width;
+    float y = pos.y + graph_height;
+    for (u32 category = 1; category < FrameTimings::NUM_CATEGORIES; category++)
+    {
+      const float height = frame[category] * y_scale;
+      if (height <= 0.0f)
+        continue;
+
+      dl->AddRectFilled(ImVec2(x, y - height), ImVec2(x + bar_width, y), category_colors[category]);
+      y -= height;
+    }
+  }
+
+  ImGui::Text("%.2f ms", max_time);
+  ImGui::SetCursorScreenPos(pos);
+  ImGui::Dummy(ImVec2(graph_width, graph_height));
+
+  for (u32 category = 1; category < FrameTimings::NUM_CATEGORIES; category++)
+  {
+    const float average_time = (count > 0) ? (average_times[category] / static_cast<float>(count)) : 0.0f;
+    ImGui::TextColored(ImColor(category_colors[category]), "%s: %.2f ms",
+                       FrameTimings::GetCategoryName(static_cast<FrameTimingCategory>(category)), average_time);
+  }
+}
+
 void HostInterface::DrawFPSWindow()
 {
-  if (!(m_settings.display_show_fps | m_settings.display_show_vps | m_settings.display_show_speed))
+  const bool show_frame_times = m_settings.display_show_frame_times && m_system->GetFrameTimings().IsEnabled();
+  if (!(m_settings.display_show_fps | m_settings.display_show_vps | m_settings.display_show_speed | show_frame_times))
     return;
 
-  const ImVec2 window_size =
-    ImVec2(175.0f * ImGui::GetIO().DisplayFramebufferScale.x, 16.0f * ImGui::GetIO().DisplayFramebufferScale.y);
-  ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - window_size.x, 0.0f), ImGuiCond_Always);
-  ImGui::SetNextWindowSize(window_size);
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoScrollbar |
+                                  ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoBackground |
+                                  ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMouseInputs |
+                                  ImGuiWindowFlags_NoBringToFrontOnFocus;
+  if (show_frame_times)
+  {
+    // Sized to fit the graph and legend, anchored to the top-right corner.
+    ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x, 0.0f), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+    window_flags |= ImGuiWindowFlags_AlwaysAutoResize;
+  }
+  else
+  {
+    const ImVec2 window_size =
+      ImVec2(175.0f * ImGui::GetIO().DisplayFramebufferScale.x, 16.0f * ImGui::GetIO().DisplayFramebufferScale.y);
+    ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - window_size.x, 0.0f), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(window_size);
+  }
 
-  if (!ImGui::Begin("FPSWindow", nullptr,
-                    ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoCollapse |
-                      ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMouseInputs |
-                      ImGuiWindowFlags_NoBringToFrontOnFocus))
+  if (!ImGui::Begin("FPSWindow", nullptr, window_flags))
   {
     ImGui::End();
     return;
@@ -281,6 +471,9 @@ void HostInterface::DrawFPSWindow()
       ImGui::TextColored(ImVec4(0.4f, 1.0f, 0.4f, 1.0f), "%u%%", rounded_speed);
   }
 
+  if (show_frame_times)
+    DrawFrameTimesGraph(m_system->GetFrameTimings(), ImGui::GetIO().DisplayFramebufferScale.x);
+
   ImGui::End();
 }
 
@@ -431,12 +624,91 @@ std::optional<std::vector<u8>> HostInterface::GetBIOSImage(ConsoleRegion region)
   return BIOS::LoadImageFromFile(m_settings.bios_path);
 }
 
+static std::unique_ptr<ByteStream> OpenSaveStateStream(std::unique_ptr<ByteStream> file_stream)
+{
+  SaveStateFileHeader header;
+  if (!file_stream->Read2(&header, sizeof(header)) || header.magic != SAVE_STATE_FILE_MAGIC)
+  {
+    // No header, assume an uncompressed state from an older version.
+    if (!file_stream->SeekAbsolute(0))
+      return {};
+
+    return file_stream;
+  }
+
+  if (header.version != SAVE_STATE_FILE_VERSION)
+  {
+    Log_ErrorPrintf("Unsupported save state file version %u", header.version);
+    return {};
+  }
+
+  // Both sizes are used for allocations, so don't trust them.
+  const u64 remaining_size = file_stream->GetSize() - file_stream->GetPosition();
+  if (header.data_size > remaining_size || header.uncompressed_size > SAVE_STATE_FILE_MAX_UNCOMPRESSED_SIZE)
+  {
+    Log_ErrorPrintf("Invalid save state header: %u bytes of data, %u bytes uncompressed", header.data_size,
+                    header.uncompressed_size);
+    return {};
+  }
+
+  std::vector<u8> data(header.data_size);
+  if (!file_stream->Read2(data.data(), header.data_size))
+  {
+    Log_ErrorPrintf("Failed to read %u bytes of save state data", header.data_size);
+    return {};
+  }
+
+  std::unique_ptr<GrowableMemoryByteStream> state_stream =
+    ByteStream_CreateGrowableMemoryStream(nullptr, header.uncompressed_size);
+  state_stream->Resize(header.uncompressed_size);
+
+  switch (header.compression)
+  {
+    case SaveStateCompression::None:
+    {
+      if (header.data_size != header.uncompressed_size)
+        return {};
+
+      std::memcpy(state_stream->GetMemoryPointer(), data.data(), header.data_size);
+    }
+    break;
+
+    case SaveStateCompression::Deflate:
+    {
+      uLongf uncompressed_size = header.uncompressed_size;
+      if (uncompress(state_stream->GetMemoryPointer(), &uncompressed_size, data.data(), header.data_size) != Z_OK ||
+          uncompressed_size != header.uncompressed_size)
+      {
+        Log_ErrorPrintf("Failed to decompress save state");
+        return {};
+      }
+    }
+    break;
+
+    default:
+      Log_ErrorPrintf("Unknown save state compression type %u", static_cast<u32>(header.compression));
+      return {};
+  }
+
+  return state_stream;
+}
+
 bool HostInterface::LoadState(const char* filename)
 {
+  // Make sure we're not reading a state which is still being written.
+  WaitForSaveStateWrite();
+
   std::unique_ptr<ByteStream> stream = FileSystem::OpenFile(filename, BYTESTREAM_OPEN_READ | BYTESTREAM_OPEN_STREAMED);
   if (!stream)
     return false;
 
+  stream = OpenSaveStateStream(std::move(stream));
+  if (!stream)
+  {
+    ReportFormattedError("Save state '%s' is corrupted or from an unsupported version.", filename);
+    return false;
+  }
+
   AddFormattedOSDMessage(2.0f, "Loading state from '%s'...", filename);
 
   if (m_system)
@@ -465,6 +737,7 @@ bool HostInterface::LoadState(const char* filename)
     }
   }
 
+  ClearRewindStates();
   m_system->ResetPerformanceCounters();
   return true;
 }
@@ -482,27 +755,86 @@ bool HostInterface::LoadState(bool global, s32 slot)
   return LoadState(save_path.c_str());
 }
 
-bool HostInterface::SaveState(const char* filename)
+bool HostInterface::SaveState(const char* filename, bool global, s32 slot)
 {
-  std::unique_ptr<ByteStream> stream =
-    FileSystem::OpenFile(filename, BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
-                                     BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
-  if (!stream)
+  // Serializing to memory is quick, compressing and writing to disk is not, so that happens on a worker thread.
+  std::unique_ptr<GrowableMemoryByteStream> state_stream = ByteStream_CreateGrowableMemoryStream(nullptr, 8 * 1024);
+  if (!m_system->SaveState(state_stream.get()))
+  {
+    ReportFormattedError("Saving state to '%s' failed.", filename);
     return false;
+  }
 
-  const bool result = m_system->SaveState(stream.get());
-  if (!result)
+  WaitForSaveStateWrite();
+  m_save_state_filename = filename;
+  m_save_state_global = global;
+  m_save_state_slot = slot;
+  m_save_state_write_result = false;
+  m_save_state_write_finished.store(false);
+  m_save_state_thread = std::thread(&HostInterface::SaveStateThreadEntryPoint, this, std::move(state_stream));
+  return true;
+}
+
+void HostInterface::SaveStateThreadEntryPoint(std::unique_ptr<GrowableMemoryByteStream> state)
+{
+  m_save_state_write_result = WriteSaveStateFile(m_save_state_filename, state.get());
+  m_save_state_write_finished.store(true);
+}
+
+bool HostInterface::WriteSaveStateFile(const std::string& filename, const GrowableMemoryByteStream* state)
+{
+  Common::Timer timer;
+
+  const u32 uncompressed_size = state->GetMemorySize();
+  uLongf compressed_size = compressBound(uncompressed_size);
+  std::vector<u8> compressed_data(compressed_size);
+  if (compress2(compressed_data.data(), &compressed_size, state->GetMemoryPointer(), uncompressed_size,
+                Z_DEFAULT_COMPRESSION) != Z_OK)
   {
-    ReportFormattedError("Saving state to '%s' failed.", filename);
-    stream->Discard();
+    Log_ErrorPrintf("Failed to compress save state for '%s'", filename.c_str());
+    return false;
   }
-  else
+
+  SaveStateFileHeader header = {};
+  header.magic = SAVE_STATE_FILE_MAGIC;
+  header.version = SAVE_STATE_FILE_VERSION;
+  header.compression = SaveStateCompression::Deflate;
+  header.data_size = static_cast<u32>(compressed_size);
+  header.uncompressed_size = uncompressed_size;
+
+  std::unique_ptr<ByteStream> stream = FileSystem::OpenFile(
+    filename.c_str(), BYTESTREAM_OPEN_CREATE | BYTESTREAM_OPEN_WRITE | BYTESTREAM_OPEN_TRUNCATE |
+                        BYTESTREAM_OPEN_ATOMIC_UPDATE | BYTESTREAM_OPEN_STREAMED);
+  if (!stream || !stream->Write2(&header, sizeof(header)) ||
+      !stream->Write2(compressed_data.data(), header.data_size) || !stream->Commit())
   {
-    AddFormattedOSDMessage(2.0f, "State saved to '%s'.", filename);
-    stream->Commit();
+    Log_ErrorPrintf("Failed to write save state to '%s'", filename.c_str());
+    if (stream)
+      stream->Discard();
+
+    return false;
   }
 
-  return result;
+  Log_DevPrintf("Save state compressed from %u to %u bytes in %.2f ms", uncompressed_size, header.data_size,
+                timer.GetTimeMilliseconds());
+  AddFormattedOSDMessage(2.0f, "State saved to '%s'.", filename.c_str());
+  return true;
+}
+
+void HostInterface::WaitForSaveStateWrite()
+{
+  if (!m_save_state_thread.joinable())
+    return;
+
+  m_save_state_thread.join();
+  if (!m_save_state_write_result)
+  {
+    ReportFormattedError("Saving state to '%s' failed.", m_save_state_filename.c_str());
+    return;
+  }
+
+  if (m_system)
+    OnSystemStateSaved(m_save_state_global, m_save_state_slot);
 }
 
 bool HostInterface::SaveState(bool global, s32 slot)
@@ -515,11 +847,7 @@ bool HostInterface::SaveState(bool global, s32 slot)
   }
 
   std::string save_path = global ? GetGlobalSaveStateFileName(slot) : GetGameSaveStateFileName(code.c_str(), slot);
-  if (!SaveState(save_path.c_str()))
-    return false;
-
-  OnSystemStateSaved(global, slot);
-  return true;
+  return SaveState(save_path.c_str(), global, slot);
 }
 
 bool HostInterface::ResumeSystemFromState(const char* filename, bool boot_on_failure)
@@ -581,8 +909,12 @@ void HostInterface::UpdateSpeedLimiterState()
   const bool is_non_standard_speed = (std::abs(m_settings.emulation_speed - 1.0f) > 0.05f);
   const bool audio_sync_enabled =
     !m_system || m_paused || (m_speed_limiter_enabled && m_settings.audio_sync_enabled && !is_non_standard_speed);
+  // Waiting for vsync on the presentation thread doesn't hold back emulation, so it doesn't depend on the speed.
   const bool video_sync_enabled =
-    !m_system || m_paused || (m_speed_limiter_enabled && m_settings.video_sync_enabled && !is_non_standard_speed);
+    !m_system || m_paused ||
+    (m_display->IsUsingThreadedPresentation() ?
+       m_settings.video_sync_enabled :
+       (m_speed_limiter_enabled && m_settings.video_sync_enabled && !is_non_standard_speed));
   Log_InfoPrintf("Syncing to %s%s", audio_sync_enabled ? "audio" : "",
                  (audio_sync_enabled && video_sync_enabled) ? " and video" : (video_sync_enabled ? "video" : ""));
 
@@ -590,7 +922,12 @@ void HostInterface::UpdateSpeedLimiterState()
   if (audio_sync_enabled)
     m_audio_stream->EmptyBuffers();
 
+  // The GPU's render thread could own the context.
+  if (m_system)
+    m_system->GetGPU()->ResetGraphicsAPIState();
   m_display->SetVSync(video_sync_enabled);
+  if (m_system)
+    m_system->GetGPU()->RestoreGraphicsAPIState();
 
   if (m_settings.increase_timer_resolution)
     SetTimerResolutionIncreased(m_speed_limiter_enabled);
@@ -598,6 +935,232 @@ void HostInterface::UpdateSpeedLimiterState()
   m_system->ResetPerformanceCounters();
 }
 
+void HostInterface::RunFrame()
+{
+  if (m_rewinding && m_rewind_data)
+  {
+    DoRewind();
+    return;
+  }
+
+  m_system->RunFrame();
+
+  // Report the result of a save state write once it's done, rather than when the next one starts.
+  if (m_save_state_write_finished.load())
+    WaitForSaveStateWrite();
+
+  if (m_rewind_data && ++m_rewind_data->frames_since_save >= m_rewind_data->save_frequency)
+    SaveRewindState();
+}
+
+bool HostInterface::IsFrameSkipped() const
+{
+  // Rewinding doesn't run frames, it shows the snapshots.
+  return (m_system && !m_rewinding && m_system->IsFrameSkipped());
+}
+
+void HostInterface::SetRewinding(bool rewinding)
+{
+  if (m_rewinding == rewinding)
+    return;
+
+  if (rewinding && !m_rewind_data)
+  {
+    if (m_system)
+      AddOSDMessage("Rewind is not enabled.");
+
+    return;
+  }
+
+  m_rewinding = rewinding;
+  if (!rewinding && m_system)
+    m_system->ResetPerformanceCounters();
+}
+
+void HostInterface::UpdateRewindSettings()
+{
+  if (!m_system || !m_settings.rewind_enable)
+  {
+    m_rewinding = false;
+    WaitForRewindCompression();
+    m_rewind_data.reset();
+    return;
+  }
+
+  if (!m_rewind_data)
+    m_rewind_data = std::make_unique<RewindData>();
+
+  ClearRewindStates();
+  m_rewind_data->save_frequency = m_settings.rewind_save_frequency;
+  m_rewind_data->max_size = static_cast<u64>(m_settings.rewind_max_memory) * 1024 * 1024;
+
+  Log_InfoPrintf("Rewind enabled: saving every %u frames, up to %u MB", m_settings.rewind_save_frequency,
+                 m_settings.rewind_max_memory);
+}
+
+void HostInterface::ClearRewindStates()
+{
+  if (!m_rewind_data)
+    return;
+
+  WaitForRewindCompression();
+  m_rewind_data->entries.clear();
+  m_rewind_data->total_size = 0;
+  m_rewind_data->frames_since_save = 0;
+  m_rewind_data->has_current_state = false;
+}
+
+void HostInterface::SaveRewindState()
+{
+  RewindData& rd = *m_rewind_data;
+  rd.frames_since_save = 0;
+
+  // The previous delta has normally been finished for several frames by now.
+  WaitForRewindCompression();
+
+  if (!m_system->SaveMemoryState(&rd.new_state))
+  {
+    Log_ErrorPrintf("Failed to save rewind state");
+    return;
+  }
+
+  std::swap(rd.current_state.state_stream, rd.new_state.state_stream);
+  if (rd.has_current_state)
+  {
+    // new_state now holds the previous snapshot, which isn't needed once the delta to it has been compressed.
+    rd.StartCompression();
+  }
+
+  rd.has_current_state = true;
+}
+
+void HostInterface::RewindData::StartCompression()
+{
+  std::unique_lock<std::mutex> lock(compress_mutex);
+  compress_pending = true;
+  compress_wake_cv.notify_one();
+}
+
+bool HostInterface::RewindData::WaitForCompression()
+{
+  std::unique_lock<std::mutex> lock(compress_mutex);
+  compress_done_cv.wait(lock, [this]() { return !compress_pending; });
+
+  const bool result = !compress_failed;
+  compress_failed = false;
+  return result;
+}
+
+void HostInterface::RewindData::CompressThreadEntryPoint()
+{
+  Trace::SetThreadName("Rewind Compression");
+
+  std::unique_lock<std::mutex> lock(compress_mutex);
+  for (;;)
+  {
+    compress_wake_cv.wait(lock, [this]() { return compress_pending || compress_shutdown; });
+    if (!compress_pending)
+      break;
+
+    lock.unlock();
+    const bool result = CompressDelta();
+    lock.lock();
+
+    compress_failed = !result;
+    compress_pending = false;
+    compress_done_cv.notify_one();
+  }
+}
+
+bool HostInterface::RewindData::CompressDelta()
+{
+  // Most of RAM/VRAM/SPU RAM doesn't change between snapshots, so the XOR is mostly zeros and deflates very well.
+  const u32 old_size = new_state.state_stream->GetMemorySize();
+  const u32 new_size = current_state.state_stream->GetMemorySize();
+  const u32 delta_size = std::max(old_size, new_size);
+  delta_buffer.resize(delta_size);
+  std::memcpy(delta_buffer.data(), current_state.state_stream->GetMemoryPointer(), new_size);
+  std::memset(delta_buffer.data() + new_size, 0, delta_size - new_size);
+  XORStateBuffer(delta_buffer.data(), new_state.state_stream->GetMemoryPointer(), old_size);
+
+  uLongf compressed_size = compressBound(delta_size);
+  compress_buffer.resize(compressed_size);
+  if (compress2(compress_buffer.data(), &compressed_size, delta_buffer.data(), delta_size, Z_BEST_SPEED) != Z_OK)
+    return false;
+
+  Entry entry;
+  entry.compressed_delta.assign(compress_buffer.begin(), compress_buffer.begin() + compressed_size);
+  entry.state_size = old_size;
+  entries.push_back(std::move(entry));
+  total_size += compressed_size;
+
+  while (total_size > max_size && !entries.empty())
+  {
+    total_size -= entries.front().compressed_delta.size();
+    entries.pop_front();
+  }
+
+  return true;
+}
+
+void HostInterface::WaitForRewindCompression()
+{
+  if (!m_rewind_data || m_rewind_data->WaitForCompression())
+    return;
+
+  Log_ErrorPrintf("Failed to compress rewind state");
+  ClearRewindStates();
+}
+
+void HostInterface::DoRewind()
+{
+  RewindData& rd = *m_rewind_data;
+  WaitForRewindCompression();
+  if (!rd.has_current_state)
+    return;
+
+  // If we've run frames since the last snapshot, go back to it first. Otherwise step back to the one before it.
+  if (rd.frames_since_save == 0)
+  {
+    if (rd.entries.empty())
+      return;
+
+    const RewindData::Entry& entry = rd.entries.back();
+    GrowableMemoryByteStream* stream = rd.current_state.state_stream.get();
+    const u32 current_size = stream->GetMemorySize();
+    const u32 delta_size = std::max(current_size, entry.state_size);
+
+    rd.delta_buffer.resize(delta_size);
+    uLongf decompressed_size = delta_size;
+    if (uncompress(rd.delta_buffer.data(), &decompressed_size, entry.compressed_delta.data(),
+                   static_cast<uLong>(entry.compressed_delta.size())) != Z_OK ||
+        decompressed_size != delta_size)
+    {
+      Log_ErrorPrintf("Failed to decompress rewind state");
+      ClearRewindStates();
+      return;
+    }
+
+    stream->Resize(delta_size);
+    std::memset(stream->GetMemoryPointer() + current_size, 0, delta_size - current_size);
+    XORStateBuffer(stream->GetMemoryPointer(), rd.delta_buffer.data(), delta_size);
+    stream->Resize(entry.state_size);
+
+    rd.total_size -= entry.compressed_delta.size();
+    rd.entries.pop_back();
+  }
+
+  if (!m_system->LoadMemoryState(rd.current_state))
+  {
+    ReportError("Failed to load rewind state. Resetting.");
+    m_system->Reset();
+    ClearRewindStates();
+    return;
+  }
+
+  rd.frames_since_save = 0;
+}
+
 void HostInterface::OnSystemCreated() {}
 
 void HostInterface::OnSystemPaused(bool paused)
@@ -686,6 +1249,8 @@ void HostInterface::CreateUserDirectorySubdirectories()
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("cache").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("dump").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("dump/audio").c_str(), false);
+  result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("dump/gpu").c_str(), false);
+  result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("dump/traces").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("savestates").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("screenshots").c_str(), false);
   result &= FileSystem::CreateDirectory(GetUserDirectoryRelativePath("memcards").c_str(), false);
@@ -802,6 +1367,8 @@ std::optional<HostInterface::SaveStateInfo> HostInterface::GetSaveStateInfo(cons
 
 void HostInterface::DeleteSaveStates(const char* game_code, bool resume)
 {
+  WaitForSaveStateWrite();
+
   const std::vector<SaveStateInfo> states(GetAvailableSaveStates(game_code));
   for (const SaveStateInfo& si : states)
   {
@@ -858,6 +1425,10 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetBoolValue("Main", "StartPaused", false);
   si.SetBoolValue("Main", "SaveStateOnExit", true);
   si.SetBoolValue("Main", "ConfirmPowerOff", true);
+  si.SetBoolValue("Main", "RewindEnable", false);
+  si.SetIntValue("Main", "RewindSaveFrequency", 10);
+  si.SetIntValue("Main", "RewindMaxMemory", 64);
+  si.SetIntValue("Main", "RunaheadFrameCount", 0);
 
   si.SetStringValue("CPU", "ExecutionMode", Settings::GetCPUExecutionModeName(CPUExecutionMode::Interpreter));
 
@@ -867,6 +1438,7 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetBoolValue("GPU", "ScaledDithering", false);
   si.SetBoolValue("GPU", "TextureFiltering", false);
   si.SetBoolValue("GPU", "UseDebugDevice", false);
+  si.SetBoolValue("GPU", "UseThread", true);
 
   si.SetStringValue("Display", "CropMode", "Overscan");
   si.SetBoolValue("Display", "ForceProgressiveScan", true);
@@ -875,6 +1447,8 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetBoolValue("Display", "ShowFPS", false);
   si.SetBoolValue("Display", "ShowVPS", false);
   si.SetBoolValue("Display", "ShowSpeed", false);
+  si.SetBoolValue("Display", "ShowFrameTimes", false);
+  si.SetBoolValue("Display", "ThreadedPresentation", false);
   si.SetBoolValue("Display", "Fullscreen", false);
   si.SetBoolValue("Display", "VSync", true);
 
@@ -917,12 +1491,18 @@ void HostInterface::UpdateSettings(const std::function<void()>& apply_callback)
   const bool old_gpu_texture_filtering = m_settings.gpu_texture_filtering;
   const bool old_display_force_progressive_scan = m_settings.display_force_progressive_scan;
   const bool old_gpu_debug_device = m_settings.gpu_use_debug_device;
+  const bool old_gpu_use_thread = m_settings.gpu_use_thread;
   const bool old_vsync_enabled = m_settings.video_sync_enabled;
   const bool old_audio_sync_enabled = m_settings.audio_sync_enabled;
   const bool old_speed_limiter_enabled = m_settings.speed_limiter_enabled;
   const DisplayCropMode old_display_crop_mode = m_settings.display_crop_mode;
   const bool old_display_linear_filtering = m_settings.display_linear_filtering;
   const bool old_cdrom_read_thread = m_settings.cdrom_read_thread;
+  const bool old_rewind_enable = m_settings.rewind_enable;
+  const u32 old_rewind_save_frequency = m_settings.rewind_save_frequency;
+  const u32 old_rewind_max_memory = m_settings.rewind_max_memory;
+  const bool old_display_show_frame_times = m_settings.display_show_frame_times;
+  const bool old_display_threaded_presentation = m_settings.display_threaded_presentation;
   std::array<ControllerType, NUM_CONTROLLER_AND_CARD_PORTS> old_controller_types = m_settings.controller_types;
 
   apply_callback();
@@ -968,6 +1548,7 @@ void HostInterface::UpdateSettings(const std::function<void()>& apply_callback)
         m_settings.gpu_true_color != old_gpu_true_color ||
         m_settings.gpu_scaled_dithering != old_gpu_scaled_dithering ||
         m_settings.gpu_texture_filtering != old_gpu_texture_filtering ||
+        m_settings.gpu_use_thread != old_gpu_use_thread ||
         m_settings.display_force_progressive_scan != old_display_force_progressive_scan ||
         m_settings.display_crop_mode != old_display_crop_mode)
     {
@@ -976,6 +1557,24 @@ void HostInterface::UpdateSettings(const std::function<void()>& apply_callback)
 
     if (m_settings.cdrom_read_thread != old_cdrom_read_thread)
       m_system->GetCDROM()->SetUseReadThread(m_settings.cdrom_read_thread);
+
+    if (m_settings.display_show_frame_times != old_display_show_frame_times)
+      m_system->GetFrameTimings().SetEnabled(m_settings.display_show_frame_times);
+
+    if (m_settings.display_threaded_presentation != old_display_threaded_presentation)
+    {
+      m_system->GetGPU()->ResetGraphicsAPIState();
+      m_display->SetThreadedPresentation(m_settings.display_threaded_presentation);
+      m_system->GetGPU()->RestoreGraphicsAPIState();
+      UpdateSpeedLimiterState();
+    }
+
+    if (m_settings.rewind_enable != old_rewind_enable ||
+        m_settings.rewind_save_frequency != old_rewind_save_frequency ||
+        m_settings.rewind_max_memory != old_rewind_max_memory)
+    {
+      UpdateRewindSettings();
+    }
   }
 
   bool controllers_updated = false;
@@ -1165,6 +1764,103 @@ void HostInterface::StopDumpingAudio()
   AddOSDMessage("Stopped dumping audio.", 5.0f);
 }
 
+bool HostInterface::IsDumpingGPU() const
+{
+  return m_system ? m_system->GetGPU()->IsDumping() : false;
+}
+
+bool HostInterface::StartDumpingGPU(const char* filename)
+{
+  if (!m_system)
+    return false;
+
+  std::string auto_filename;
+  if (!filename)
+  {
+    const auto& code = m_system->GetRunningCode();
+    if (code.empty())
+    {
+      auto_filename =
+        GetUserDirectoryRelativePath("dump/gpu/%s.gpudump", GetTimestampStringForFileName().GetCharArray());
+    }
+    else
+    {
+      auto_filename = GetUserDirectoryRelativePath("dump/gpu/%s_%s.gpudump", code.c_str(),
+                                                   GetTimestampStringForFileName().GetCharArray());
+    }
+
+    filename = auto_filename.c_str();
+  }
+
+  if (m_system->GetGPU()->StartDumping(filename))
+  {
+    AddFormattedOSDMessage(5.0f, "Started dumping GPU commands to '%s'.", filename);
+    return true;
+  }
+  else
+  {
+    AddFormattedOSDMessage(10.0f, "Failed to start dumping GPU commands to '%s'.", filename);
+    return false;
+  }
+}
+
+void HostInterface::StopDumpingGPU()
+{
+  if (!m_system || !m_system->GetGPU()->StopDumping())
+    return;
+
+  AddOSDMessage("Stopped dumping GPU commands.", 5.0f);
+}
+
+bool HostInterface::IsRecordingTrace() const
+{
+  return Trace::IsRecording();
+}
+
+void HostInterface::StartRecordingTrace()
+{
+  if (Trace::IsRecording())
+    return;
+
+  Trace::StartRecording();
+  AddOSDMessage("Started recording trace.", 5.0f);
+}
+
+bool HostInterface::StopRecordingTrace(const char* filename /* = nullptr */)
+{
+  if (!Trace::IsRecording())
+    return false;
+
+  Trace::StopRecording();
+
+  std::string auto_filename;
+  if (!filename)
+  {
+    const std::string code = m_system ? m_system->GetRunningCode() : std::string();
+    if (code.empty())
+    {
+      auto_filename =
+        GetUserDirectoryRelativePath("dump/traces/%s.json", GetTimestampStringForFileName().GetCharArray());
+    }
+    else
+    {
+      auto_filename = GetUserDirectoryRelativePath("dump/traces/%s_%s.json", code.c_str(),
+                                                   GetTimestampStringForFileName().GetCharArray());
+    }
+
+    filename = auto_filename.c_str();
+  }
+
+  if (!Trace::WriteJSON(filename))
+  {
+    AddFormattedOSDMessage(10.0f, "Failed to write trace to '%s'.", filename);
+    return false;
+  }
+
+  AddFormattedOSDMessage(5.0f, "Trace written to '%s'.", filename);
+  return true;
+}
+
 bool HostInterface::SaveScreenshot(const char* filename /* = nullptr */, bool full_resolution /* = true */,
                                    bool apply_aspect_ratio /* = true */)
 {
@@ -1190,7 +1886,10 @@ bool HostInterface::SaveScreenshot(const char* filename /* = nullptr */, bool fu
     filename = auto_filename.c_str();
   }
 
-  if (!m_display->WriteDisplayTextureToFile(filename, full_resolution, apply_aspect_ratio))
+  m_system->GetGPU()->ResetGraphicsAPIState();
+  const bool screenshot_saved = m_display->WriteDisplayTextureToFile(filename, full_resolution, apply_aspect_ratio);
+  m_system->GetGPU()->RestoreGraphicsAPIState();
+  if (!screenshot_saved)
   {
     AddFormattedOSDMessage(10.0f, "Failed to save screenshot to '%s'", filename);
     return false;
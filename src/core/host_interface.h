@@ -3,6 +3,7 @@
 #include "common/timer.h"
 #include "settings.h"
 #include "types.h"
+#include <atomic>
 #include <chrono>
 #include <deque>
 #include <functional>
@@ -10,10 +11,12 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 class AudioStream;
 class ByteStream;
+class GrowableMemoryByteStream;
 class CDImage;
 class HostDisplay;
 class GameList;
@@ -45,11 +48,21 @@ public:
   ALWAYS_INLINE System* GetSystem() const { return m_system.get(); }
 
   bool BootSystem(const SystemBootParameters& parameters);
+
+  /// Creates the system without a BIOS or media, for replaying GPU dumps. Only the GPU can be used.
+  bool BootSystemForGPUDumpReplay();
+
   void PauseSystem(bool paused);
   void ResetSystem();
   void PowerOffSystem();
   void DestroySystem();
 
+  /// Returns true if the rewind hotkey is being held.
+  ALWAYS_INLINE bool IsRewinding() const { return m_rewinding; }
+
+  /// Starts or stops rewinding. While rewinding, each frame steps back to the previous rewind snapshot.
+  void SetRewinding(bool rewinding);
+
   /// Loads state from the specified filename.
   bool LoadState(const char* filename);
 
@@ -78,6 +91,25 @@ public:
   /// Stops dumping audio to file if it has been started.
   void StopDumpingAudio();
 
+  /// Returns true if currently dumping GPU commands.
+  bool IsDumpingGPU() const;
+
+  /// Starts dumping GPU commands to a file, for replaying later. If no file name is provided, one will be generated
+  /// automatically.
+  bool StartDumpingGPU(const char* filename = nullptr);
+
+  /// Stops dumping GPU commands to file if it has been started.
+  void StopDumpingGPU();
+
+  /// Returns true if a performance trace is being recorded.
+  bool IsRecordingTrace() const;
+
+  /// Starts recording a performance trace, which can be viewed in chrome://tracing or Perfetto.
+  void StartRecordingTrace();
+
+  /// Stops recording and writes the trace to a file. If no file name is provided, one will be generated automatically.
+  bool StopRecordingTrace(const char* filename = nullptr);
+
   /// Saves a screenshot to the specified file. IF no file name is provided, one will be generated automatically.
   bool SaveScreenshot(const char* filename = nullptr, bool full_resolution = true, bool apply_aspect_ratio = true);
 
@@ -211,6 +243,12 @@ protected:
 
   void UpdateSpeedLimiterState();
 
+  /// Executes a single frame of the emulated system, handling rewind. Call this rather than System::RunFrame().
+  void RunFrame();
+
+  /// Returns true if the frame which was just run was dropped by frame skipping, and shouldn't be presented.
+  bool IsFrameSkipped() const;
+
   void DrawFPSWindow();
   void DrawOSDMessages();
   void DrawDebugWindows();
@@ -226,11 +264,40 @@ protected:
   bool m_speed_limiter_temp_disabled = false;
   bool m_speed_limiter_enabled = false;
   bool m_timer_resolution_increased = false;
+  bool m_rewinding = false;
 
   std::deque<OSDMessage> m_osd_messages;
   std::mutex m_osd_messages_lock;
 
 private:
+  // Delta-compressed ring of save states, defined in the source file.
+  struct RewindData;
+
   void CreateAudioStream();
-  bool SaveState(const char* filename);
+  bool SaveState(const char* filename, bool global, s32 slot);
+
+  /// Compresses and writes a serialized state to disk. Runs on the save state thread.
+  void SaveStateThreadEntryPoint(std::unique_ptr<GrowableMemoryByteStream> state);
+  bool WriteSaveStateFile(const std::string& filename, const GrowableMemoryByteStream* state);
+
+  /// Blocks until any in-progress save state write has finished, then reports whether it succeeded.
+  void WaitForSaveStateWrite();
+
+  void UpdateRewindSettings();
+  void ClearRewindStates();
+  void SaveRewindState();
+  void DoRewind();
+
+  /// Blocks until the delta for the last rewind state has been added.
+  void WaitForRewindCompression();
+
+  std::unique_ptr<RewindData> m_rewind_data;
+
+  // The save state thread only writes m_save_state_write_result. The rest isn't changed until it has been joined.
+  std::thread m_save_state_thread;
+  std::string m_save_state_filename;
+  s32 m_save_state_slot = 0;
+  bool m_save_state_global = false;
+  bool m_save_state_write_result = false;
+  std::atomic_bool m_save_state_write_finished{false};
 };
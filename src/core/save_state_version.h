@@ -3,3 +3,26 @@
 
 static constexpr u32 SAVE_STATE_MAGIC = 0x43435544;
 static constexpr u32 SAVE_STATE_VERSION = 8;
+
+// Save state files written by the host interface start with this header, followed by the (possibly compressed) state.
+// Files without it are treated as a raw uncompressed state from older versions.
+static constexpr u32 SAVE_STATE_FILE_MAGIC = 0x5A535344; // 'DSSZ'
+static constexpr u32 SAVE_STATE_FILE_VERSION = 1;
+
+// States are a few megabytes, anything much larger than this comes from a corrupted header.
+static constexpr u32 SAVE_STATE_FILE_MAX_UNCOMPRESSED_SIZE = 64 * 1024 * 1024;
+
+enum class SaveStateCompression : u32
+{
+  None = 0,
+  Deflate = 1
+};
+
+struct SaveStateFileHeader
+{
+  u32 magic;
+  u32 version;
+  SaveStateCompression compression;
+  u32 data_size;
+  u32 uncompressed_size;
+};
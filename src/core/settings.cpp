@@ -1,5 +1,6 @@
 #include "settings.h"
 #include "common/string_util.h"
+#include <algorithm>
 #include <array>
 
 Settings::Settings() = default;
@@ -16,6 +17,10 @@ void Settings::Load(SettingsInterface& si)
   start_fullscreen = si.GetBoolValue("Main", "StartFullscreen", false);
   save_state_on_exit = si.GetBoolValue("Main", "SaveStateOnExit", true);
   confim_power_off = si.GetBoolValue("Main", "ConfirmPowerOff", true);
+  rewind_enable = si.GetBoolValue("Main", "RewindEnable", false);
+  rewind_save_frequency = static_cast<u32>(std::max(si.GetIntValue("Main", "RewindSaveFrequency", 10), 1));
+  rewind_max_memory = static_cast<u32>(std::max(si.GetIntValue("Main", "RewindMaxMemory", 64), 1));
+  runahead_frames = static_cast<u32>(std::clamp(si.GetIntValue("Main", "RunaheadFrameCount", 0), 0, 10));
 
   cpu_execution_mode = ParseCPUExecutionMode(si.GetStringValue("CPU", "ExecutionMode", "Interpreter").c_str())
                          .value_or(CPUExecutionMode::Interpreter);
@@ -27,16 +32,21 @@ void Settings::Load(SettingsInterface& si)
   gpu_scaled_dithering = si.GetBoolValue("GPU", "ScaledDithering", false);
   gpu_texture_filtering = si.GetBoolValue("GPU", "TextureFiltering", false);
   gpu_use_debug_device = si.GetBoolValue("GPU", "UseDebugDevice", false);
+  gpu_use_thread = si.GetBoolValue("GPU", "UseThread", true);
 
   display_crop_mode = ParseDisplayCropMode(
                         si.GetStringValue("Display", "CropMode", GetDisplayCropModeName(DisplayCropMode::None)).c_str())
                         .value_or(DisplayCropMode::None);
+  display_frame_skip = static_cast<u32>(std::clamp(si.GetIntValue("Display", "FrameSkip", 0), 0, 10));
+  display_auto_frame_skip = si.GetBoolValue("Display", "AutoFrameSkip", false);
   display_force_progressive_scan = si.GetBoolValue("Display", "ForceProgressiveScan", true);
   display_linear_filtering = si.GetBoolValue("Display", "LinearFiltering", true);
   display_show_osd_messages = si.GetBoolValue("Display", "ShowOSDMessages", true);
   display_show_fps = si.GetBoolValue("Display", "ShowFPS", false);
   display_show_vps = si.GetBoolValue("Display", "ShowVPS", false);
   display_show_speed = si.GetBoolValue("Display", "ShowSpeed", false);
+  display_show_frame_times = si.GetBoolValue("Display", "ShowFrameTimes", false);
+  display_threaded_presentation = si.GetBoolValue("Display", "ThreadedPresentation", false);
   video_sync_enabled = si.GetBoolValue("Display", "VSync", true);
 
   cdrom_read_thread = si.GetBoolValue("CDROM", "ReadThread", true);
@@ -79,6 +89,10 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("Main", "StartFullscreen", start_fullscreen);
   si.SetBoolValue("Main", "SaveStateOnExit", save_state_on_exit);
   si.SetBoolValue("Main", "ConfirmPowerOff", confim_power_off);
+  si.SetBoolValue("Main", "RewindEnable", rewind_enable);
+  si.SetIntValue("Main", "RewindSaveFrequency", static_cast<int>(rewind_save_frequency));
+  si.SetIntValue("Main", "RewindMaxMemory", static_cast<int>(rewind_max_memory));
+  si.SetIntValue("Main", "RunaheadFrameCount", static_cast<int>(runahead_frames));
 
   si.SetStringValue("CPU", "ExecutionMode", GetCPUExecutionModeName(cpu_execution_mode));
 
@@ -88,13 +102,18 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("GPU", "ScaledDithering", gpu_scaled_dithering);
   si.SetBoolValue("GPU", "TextureFiltering", gpu_texture_filtering);
   si.SetBoolValue("GPU", "UseDebugDevice", gpu_use_debug_device);
+  si.SetBoolValue("GPU", "UseThread", gpu_use_thread);
 
+  si.SetIntValue("Display", "FrameSkip", static_cast<int>(display_frame_skip));
+  si.SetBoolValue("Display", "AutoFrameSkip", display_auto_frame_skip);
   si.SetBoolValue("Display", "ForceProgressiveScan", display_force_progressive_scan);
   si.SetBoolValue("Display", "LinearFiltering", display_linear_filtering);
   si.SetBoolValue("Display", "ShowOSDMessages", display_show_osd_messages);
   si.SetBoolValue("Display", "ShowFPS", display_show_fps);
   si.SetBoolValue("Display", "ShowVPS", display_show_vps);
   si.SetBoolValue("Display", "ShowSpeed", display_show_speed);
+  si.SetBoolValue("Display", "ShowFrameTimes", display_show_frame_times);
+  si.SetBoolValue("Display", "ThreadedPresentation", display_threaded_presentation);
   si.SetBoolValue("Display", "VSync", video_sync_enabled);
 
   si.SetBoolValue("CDROM", "ReadThread", cdrom_read_thread);
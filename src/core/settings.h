@@ -45,19 +45,29 @@ struct Settings
   bool save_state_on_exit = true;
   bool confim_power_off = true;
 
+  bool rewind_enable = false;
+  u32 rewind_save_frequency = 10; // in frames
+  u32 rewind_max_memory = 64;     // in megabytes
+  u32 runahead_frames = 0;
+
   GPURenderer gpu_renderer = GPURenderer::Software;
   u32 gpu_resolution_scale = 1;
   bool gpu_true_color = true;
   bool gpu_scaled_dithering = false;
   bool gpu_texture_filtering = false;
   bool gpu_use_debug_device = false;
+  bool gpu_use_thread = true;
   DisplayCropMode display_crop_mode = DisplayCropMode::None;
+  u32 display_frame_skip = 0; // frames dropped after each shown frame, or the most in a row when automatic
+  bool display_auto_frame_skip = false;
   bool display_force_progressive_scan = false;
   bool display_linear_filtering = true;
   bool display_show_osd_messages = false;
   bool display_show_fps = false;
   bool display_show_vps = false;
   bool display_show_speed = false;
+  bool display_show_frame_times = false;
+  bool display_threaded_presentation = false;
   bool video_sync_enabled = true;
 
   bool cdrom_read_thread = true;
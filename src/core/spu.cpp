@@ -27,6 +27,7 @@ void SPU::Initialize(System* system, DMA* dma, InterruptController* interrupt_co
   m_interrupt_controller = interrupt_controller;
   m_tick_event = m_system->CreateTimingEvent("SPU Sample", SYSCLK_TICKS_PER_SPU_TICK, SYSCLK_TICKS_PER_SPU_TICK,
                                              std::bind(&SPU::Execute, this, std::placeholders::_1), false);
+  m_tick_event->SetFrameTimingCategory(FrameTimingCategory::SPU);
 }
 
 void SPU::Reset()
@@ -132,7 +133,8 @@ bool SPU::DoState(StateWrapper& sw)
 
   if (sw.IsReading())
   {
-    m_system->GetHostInterface()->GetAudioStream()->EmptyBuffers();
+    if (!m_audio_output_muted)
+      m_system->GetHostInterface()->GetAudioStream()->EmptyBuffers();
     UpdateEventInterval();
   }
 
@@ -687,12 +689,23 @@ void SPU::Execute(TickCount ticks)
   u32 remaining_frames = static_cast<u32>((ticks + m_ticks_carry) / SYSCLK_TICKS_PER_SPU_TICK);
   m_ticks_carry = (ticks + m_ticks_carry) % SYSCLK_TICKS_PER_SPU_TICK;
 
+  std::array<s16, MUTED_OUTPUT_BUFFER_FRAMES * 2> muted_output_buffer;
+
   while (remaining_frames > 0)
   {
     AudioStream* const output_stream = m_system->GetHostInterface()->GetAudioStream();
     s16* output_frame_start;
     u32 output_frame_space;
-    output_stream->BeginWrite(&output_frame_start, &output_frame_space);
+    if (!m_audio_output_muted)
+    {
+      output_stream->BeginWrite(&output_frame_start, &output_frame_space);
+    }
+    else
+    {
+      // Still need to run the mixer for the side effects (capture buffers, reverb, IRQs).
+      output_frame_start = muted_output_buffer.data();
+      output_frame_space = MUTED_OUTPUT_BUFFER_FRAMES;
+    }
 
     s16* output_frame = output_frame_start;
     const u32 frames_in_this_batch = std::min(remaining_frames, output_frame_space);
@@ -783,10 +796,14 @@ void SPU::Execute(TickCount ticks)
       IncrementCaptureBufferPosition();
     }
 
-    if (m_dump_writer)
-      m_dump_writer->WriteFrames(output_frame_start, frames_in_this_batch);
+    if (!m_audio_output_muted)
+    {
+      if (m_dump_writer)
+        m_dump_writer->WriteFrames(output_frame_start, frames_in_this_batch);
+
+      output_stream->EndWrite(frames_in_this_batch);
+    }
 
-    output_stream->EndWrite(frames_in_this_batch);
     remaining_frames -= frames_in_this_batch;
   }
 
@@ -46,6 +46,10 @@ public:
   // Executes the SPU, generating any pending samples.
   void GeneratePendingSamples();
 
+  /// Discards generated samples instead of sending them to the host, e.g. for runahead frames.
+  ALWAYS_INLINE bool IsAudioOutputMuted() const { return m_audio_output_muted; }
+  ALWAYS_INLINE void SetAudioOutputMuted(bool muted) { m_audio_output_muted = muted; }
+
   /// Returns true if currently dumping audio.
   ALWAYS_INLINE bool IsDumpingAudio() const { return static_cast<bool>(m_dump_writer); }
 
@@ -68,6 +72,7 @@ private:
   static constexpr s16 ADSR_MIN_VOLUME = 0;
   static constexpr s16 ADSR_MAX_VOLUME = 0x7FFF;
   static constexpr u32 CD_AUDIO_SAMPLE_BUFFER_SIZE = 44100 * 2;
+  static constexpr u32 MUTED_OUTPUT_BUFFER_FRAMES = 1024;
   static constexpr u32 CAPTURE_BUFFER_SIZE_PER_CHANNEL = 0x400;
   static constexpr u32 MINIMUM_TICKS_BETWEEN_KEY_ON_OFF = 2;
   static constexpr u32 NUM_REVERB_REGS = 16;
@@ -355,6 +360,7 @@ private:
   std::unique_ptr<Common::WAVWriter> m_dump_writer;
   u32 m_tick_counter = 0;
   TickCount m_ticks_carry = 0;
+  bool m_audio_output_muted = false;
 
   SPUCNT m_SPUCNT = {};
   SPUSTAT m_SPUSTAT = {};
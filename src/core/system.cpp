@@ -2,8 +2,10 @@
 #include "bios.h"
 #include "bus.h"
 #include "cdrom.h"
+#include "common/byte_stream.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
+#include "common/trace.h"
 #include "controller.h"
 #include "cpu_code_cache.h"
 #include "cpu_core.h"
@@ -36,6 +38,10 @@ SystemBootParameters::SystemBootParameters(std::string filename_) : filename(fil
 
 SystemBootParameters::~SystemBootParameters() = default;
 
+System::MemorySaveState::MemorySaveState() = default;
+
+System::MemorySaveState::~MemorySaveState() = default;
+
 System::System(HostInterface* host_interface) : m_host_interface(host_interface)
 {
   m_cpu = std::make_unique<CPU::Core>();
@@ -51,6 +57,10 @@ System::System(HostInterface* host_interface) : m_host_interface(host_interface)
   m_sio = std::make_unique<SIO>();
   m_region = host_interface->m_settings.region;
   m_cpu_execution_mode = host_interface->m_settings.cpu_execution_mode;
+  m_frame_timings.SetEnabled(host_interface->m_settings.display_show_frame_times);
+
+  // Runahead saves and loads every frame, so VRAM stays on the GPU.
+  m_runahead_state.allow_vram_snapshot = true;
 }
 
 System::~System()
@@ -96,6 +106,7 @@ bool System::RecreateGPU(GPURenderer renderer)
 
   // create new renderer
   m_gpu.reset();
+  m_vram_snapshot_state = nullptr;
   if (!CreateGPU(renderer))
   {
     Panic("Failed to recreate GPU");
@@ -222,6 +233,16 @@ bool System::Boot(const SystemBootParameters& params)
   return true;
 }
 
+void System::BootForGPUDumpReplay()
+{
+  // Only used for the initial video standard, the state at the start of the dump overrides it.
+  if (m_region == ConsoleRegion::Auto)
+    m_region = ConsoleRegion::NTSC_U;
+
+  InitializeComponents();
+  Reset();
+}
+
 void System::InitializeComponents()
 {
   m_cpu->Initialize(m_bus.get());
@@ -299,7 +320,7 @@ bool System::CreateGPU(GPURenderer renderer)
   return true;
 }
 
-bool System::DoState(StateWrapper& sw)
+bool System::DoState(StateWrapper& sw, bool memory_state, bool use_gpu_vram_snapshot)
 {
   u32 magic = SAVE_STATE_MAGIC;
   u32 version = SAVE_STATE_VERSION;
@@ -327,20 +348,30 @@ bool System::DoState(StateWrapper& sw)
 
   if (sw.IsReading())
   {
-    std::unique_ptr<CDImage> media;
-    if (!media_filename.empty())
+    if (media_filename == m_cdrom->GetMediaFileName())
     {
-      media = CDImage::Open(media_filename.c_str());
-      if (!media)
-        Log_ErrorPrintf("Failed to open CD image from save state: '%s'", media_filename.c_str());
+      // Same disc as what's currently inserted, don't bother reopening the image. Memory states are loaded every frame
+      // with runahead, so skip the reset and its read of the first sector there, the CDROM state overwrites it anyway.
+      if (!memory_state)
+        m_cdrom->Reset();
     }
-
-    UpdateRunningGame(media_filename.c_str(), media.get());
-    m_cdrom->Reset();
-    if (media)
-      m_cdrom->InsertMedia(std::move(media));
     else
-      m_cdrom->RemoveMedia();
+    {
+      std::unique_ptr<CDImage> media;
+      if (!media_filename.empty())
+      {
+        media = CDImage::Open(media_filename.c_str());
+        if (!media)
+          Log_ErrorPrintf("Failed to open CD image from save state: '%s'", media_filename.c_str());
+      }
+
+      UpdateRunningGame(media_filename.c_str(), media.get());
+      m_cdrom->Reset();
+      if (media)
+        m_cdrom->InsertMedia(std::move(media));
+      else
+        m_cdrom->RemoveMedia();
+    }
   }
 
   if (!sw.DoMarker("CPU") || !m_cpu->DoState(sw))
@@ -358,7 +389,7 @@ bool System::DoState(StateWrapper& sw)
   if (!sw.DoMarker("InterruptController") || !m_interrupt_controller->DoState(sw))
     return false;
 
-  if (!sw.DoMarker("GPU") || !m_gpu->DoState(sw))
+  if (!sw.DoMarker("GPU") || !m_gpu->DoState(sw, use_gpu_vram_snapshot))
     return false;
 
   if (!sw.DoMarker("CDROM") || !m_cdrom->DoState(sw))
@@ -418,9 +449,88 @@ bool System::SaveState(ByteStream* state)
   return DoState(sw);
 }
 
+bool System::SaveMemoryState(MemorySaveState* mss)
+{
+  // RAM + BIOS + VRAM + SPU RAM, plus a bit for the rest of the state.
+  static constexpr u32 INITIAL_MEMORY_SAVE_STATE_SIZE = 4608 * 1024;
+
+  if (!mss->state_stream)
+    mss->state_stream = ByteStream_CreateGrowableMemoryStream(nullptr, INITIAL_MEMORY_SAVE_STATE_SIZE);
+
+  // Reuse the existing buffer, the size is trimmed afterwards in case the state shrunk.
+  mss->state_stream->SeekAbsolute(0);
+
+  // Saving the snapshot overwrites whichever state held it before, even if this save fails.
+  const bool use_vram_snapshot = mss->allow_vram_snapshot && m_gpu->SupportsVRAMSnapshots();
+  mss->uses_vram_snapshot = false;
+  if (use_vram_snapshot)
+    m_vram_snapshot_state = nullptr;
+
+  StateWrapper sw(mss->state_stream.get(), StateWrapper::Mode::Write);
+  if (!DoState(sw, true, use_vram_snapshot))
+    return false;
+
+  mss->uses_vram_snapshot = use_vram_snapshot;
+  if (use_vram_snapshot)
+    m_vram_snapshot_state = mss;
+
+  mss->state_stream->Resize(static_cast<u32>(mss->state_stream->GetPosition()));
+  return true;
+}
+
+bool System::LoadMemoryState(const MemorySaveState& mss)
+{
+  if (!mss.state_stream)
+    return false;
+
+  // Check the snapshot is still there before loading anything, since a failure part way leaves the system in a mix of
+  // both states. Another state can have replaced it, or the renderer discarded it, e.g. on a resolution change.
+  if (mss.uses_vram_snapshot && (m_vram_snapshot_state != &mss || !m_gpu->HasVRAMSnapshot()))
+    return false;
+
+  mss.state_stream->SeekAbsolute(0);
+
+  StateWrapper sw(mss.state_stream.get(), StateWrapper::Mode::Read);
+  return DoState(sw, true, mss.uses_vram_snapshot);
+}
+
 void System::RunFrame()
 {
+  TRACE_SCOPE("RunFrame");
+  m_frame_timings.CommitFrame();
+  ScopedFrameTiming frame_timing(&m_frame_timings, FrameTimingCategory::System);
+
   m_frame_timer.Reset();
+
+  m_frame_skipped = ShouldSkipFrame();
+
+  const u32 runahead_frames = GetSettings().runahead_frames;
+  if (m_frame_skipped)
+  {
+    // The frame is never shown, so there's no point in scanning it out or running ahead of it.
+    m_gpu->SetDisplayUpdatesSuppressed(true);
+    ExecuteFrame();
+    m_spu->GeneratePendingSamples();
+    m_gpu->SetDisplayUpdatesSuppressed(false);
+  }
+  else if (runahead_frames > 0)
+  {
+    DoRunahead(runahead_frames);
+  }
+  else
+  {
+    ExecuteFrame();
+
+    // Generate any pending samples from the SPU before sleeping, this way we reduce the chances of underruns.
+    m_spu->GeneratePendingSamples();
+  }
+
+  UpdatePerformanceCounters();
+}
+
+void System::ExecuteFrame()
+{
+  ScopedFrameTiming frame_timing(&m_frame_timings, FrameTimingCategory::CPU);
   m_frame_done = false;
 
   // Duplicated to avoid branch in the while loop, as the downcount can be quite low at times.
@@ -442,11 +552,62 @@ void System::RunFrame()
       RunEvents();
     } while (!m_frame_done);
   }
+}
 
-  // Generate any pending samples from the SPU before sleeping, this way we reduce the chances of underruns.
+void System::DoRunahead(u32 frames)
+{
+  // The real frame is the only one which produces audio, but it's never shown. One of the speculative frames is.
+  m_gpu->SetDisplayUpdatesSuppressed(true);
+  ExecuteFrame();
   m_spu->GeneratePendingSamples();
 
-  UpdatePerformanceCounters();
+  if (!SaveMemoryState(&m_runahead_state))
+  {
+    Log_ErrorPrintf("Failed to save runahead state");
+    m_gpu->SetDisplayUpdatesSuppressed(false);
+    return;
+  }
+
+  m_spu->SetAudioOutputMuted(true);
+  for (u32 i = 0; i < frames; i++)
+  {
+    m_gpu->SetDisplayUpdatesSuppressed(i != (frames - 1));
+    ExecuteFrame();
+  }
+
+  // Go back to the real frame, leaving the display as-is. Nothing has been loaded if that fails, so carry on from the
+  // last speculative frame instead. The next frame saves a new state, and runs ahead from there.
+  m_gpu->SetDisplayUpdatesSuppressed(true);
+  if (!LoadMemoryState(m_runahead_state))
+    Log_WarningPrintf("Failed to load runahead state, continuing from the speculative frames");
+
+  m_spu->SetAudioOutputMuted(false);
+  m_gpu->SetDisplayUpdatesSuppressed(false);
+}
+
+bool System::ShouldSkipFrame()
+{
+  const Settings& settings = GetSettings();
+  if (m_frames_skipped >= settings.display_frame_skip)
+  {
+    m_frames_skipped = 0;
+    return false;
+  }
+
+  // Automatic frame skip only drops frames while we're more than a frame behind the throttle schedule. The schedule
+  // doesn't advance without the speed limiter, so fast forward always drops as many frames as allowed.
+  if (settings.display_auto_frame_skip)
+  {
+    const u64 time = static_cast<u64>(m_throttle_timer.GetTimeNanoseconds());
+    if (static_cast<s64>(m_last_throttle_time - time) >= 0)
+    {
+      m_frames_skipped = 0;
+      return false;
+    }
+  }
+
+  m_frames_skipped++;
+  return true;
 }
 
 void System::SetThrottleFrequency(float frequency)
@@ -465,6 +626,9 @@ void System::UpdateThrottlePeriod()
 
 void System::Throttle()
 {
+  TRACE_SCOPE("Throttle");
+  ScopedFrameTiming frame_timing(&m_frame_timings, FrameTimingCategory::None);
+
   // Allow variance of up to 40ms either way.
   constexpr s64 MAX_VARIANCE_TIME = INT64_C(40000000);
 
@@ -790,7 +954,11 @@ void System::RunEvents()
     evt->m_time_since_last_run = 0;
 
     // The cycles_late is only an indicator, it doesn't modify the cycles to execute.
-    evt->m_callback(ticks_to_execute, ticks_late);
+    {
+      ScopedFrameTiming frame_timing(&m_frame_timings, evt->m_frame_timing_category);
+      Trace::ScopedSpan trace_span("TimingEvent", evt->m_trace_name);
+      evt->m_callback(ticks_to_execute, ticks_late);
+    }
 
     // Place it in the appropriate position in the queue.
     if (m_events_need_sorting)
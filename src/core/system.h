@@ -8,6 +8,7 @@
 #include <string>
 
 class ByteStream;
+class GrowableMemoryByteStream;
 class CDImage;
 class StateWrapper;
 
@@ -43,6 +44,20 @@ class System
 public:
   friend TimingEvent;
 
+  /// In-memory save state. The buffer is kept between saves, so repeated snapshots don't allocate.
+  struct MemorySaveState
+  {
+    MemorySaveState();
+    ~MemorySaveState();
+
+    std::unique_ptr<GrowableMemoryByteStream> state_stream;
+
+    /// Leaves VRAM in the renderer instead of the stream when it supports it, so hardware renderers don't have to
+    /// read it back. Only one state can hold the renderer's snapshot at a time.
+    bool allow_vram_snapshot = false;
+    bool uses_vram_snapshot = false;
+  };
+
   ~System();
 
   /// Returns the preferred console type for a disc.
@@ -88,12 +103,22 @@ public:
   float GetAverageFrameTime() const { return m_average_frame_time; }
   float GetWorstFrameTime() const { return m_worst_frame_time; }
 
+  /// Per-subsystem breakdown of frame times. Only collected when enabled.
+  FrameTimings& GetFrameTimings() { return m_frame_timings; }
+
   bool Boot(const SystemBootParameters& params);
   void Reset();
 
+  /// Sets up the components without a BIOS or media, for replaying GPU dumps. The CPU must not be executed.
+  void BootForGPUDumpReplay();
+
   bool LoadState(ByteStream* state);
   bool SaveState(ByteStream* state);
 
+  /// Fast snapshot of the system state to memory, for rewind/runahead. Does not touch the filesystem.
+  bool SaveMemoryState(MemorySaveState* mss);
+  bool LoadMemoryState(const MemorySaveState& mss);
+
   /// Recreates the GPU component, saving/loading the state so it is preserved. Call when the GPU renderer changes.
   bool RecreateGPU(GPURenderer renderer);
 
@@ -105,6 +130,9 @@ public:
 
   void RunFrame();
 
+  /// Returns true if the last frame was dropped by frame skipping, in which case there is nothing new to present.
+  bool IsFrameSkipped() const { return m_frame_skipped; }
+
   /// Adjusts the throttle frequency, i.e. how many times we should sleep per second.
   void SetThrottleFrequency(float frequency);
 
@@ -139,12 +167,23 @@ public:
 private:
   System(HostInterface* host_interface);
 
-  bool DoState(StateWrapper& sw);
+  /// memory_state is set for states which are loaded back into the same session, e.g. runahead and rewind.
+  bool DoState(StateWrapper& sw, bool memory_state = false, bool use_gpu_vram_snapshot = false);
   bool CreateGPU(GPURenderer renderer);
 
   void InitializeComponents();
   void DestroyComponents();
 
+  // Runs the CPU and events until the GPU signals the end of the frame.
+  void ExecuteFrame();
+
+  // Runs a frame, then the specified number of frames speculatively with audio and display suppressed except for the
+  // last frame, before restoring the state after the first frame.
+  void DoRunahead(u32 frames);
+
+  // Decides whether the next frame is dropped, based on the frame skip settings and the throttle schedule.
+  bool ShouldSkipFrame();
+
   // Active event management
   void AddActiveEvent(TimingEvent* event);
   void RemoveActiveEvent(TimingEvent* event);
@@ -208,6 +247,9 @@ private:
   Common::Timer m_throttle_timer;
   Common::Timer m_speed_lost_time_timestamp;
 
+  u32 m_frames_skipped = 0;
+  bool m_frame_skipped = false;
+
   float m_average_frame_time_accumulator = 0.0f;
   float m_worst_frame_time_accumulator = 0.0f;
 
@@ -221,4 +263,8 @@ private:
   u32 m_last_global_tick_counter = 0;
   Common::Timer m_fps_timer;
   Common::Timer m_frame_timer;
+  FrameTimings m_frame_timings;
+
+  MemorySaveState m_runahead_state;
+  const MemorySaveState* m_vram_snapshot_state = nullptr; // state which holds the renderer's VRAM snapshot
 };
@@ -1,12 +1,14 @@
 #include "timing_event.h"
 #include "common/assert.h"
+#include "common/trace.h"
 #include "cpu_core.h"
 #include "system.h"
 
 TimingEvent::TimingEvent(System* system, std::string name, TickCount period, TickCount interval,
                          TimingEventCallback callback)
   : m_downcount(interval), m_time_since_last_run(0), m_period(period), m_interval(interval),
-    m_callback(std::move(callback)), m_system(system), m_name(std::move(name)), m_active(false)
+    m_callback(std::move(callback)), m_system(system), m_name(std::move(name)),
+    m_trace_name(Trace::InternString(m_name)), m_active(false)
 {
 }
 
@@ -86,7 +88,12 @@ void TimingEvent::InvokeEarly(bool force /* = false */)
 
   m_downcount = pending_ticks + m_interval;
   m_time_since_last_run -= ticks_to_execute;
-  m_callback(ticks_to_execute, 0);
+
+  {
+    ScopedFrameTiming frame_timing(&m_system->m_frame_timings, m_frame_timing_category);
+    Trace::ScopedSpan trace_span("TimingEvent", m_trace_name);
+    m_callback(ticks_to_execute, 0);
+  }
 
   // Since we've changed the downcount, we need to re-sort the events.
   m_system->SortEvents();
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "frame_timings.h"
 #include "types.h"
 
 class System;
@@ -64,6 +65,10 @@ public:
   void SetInterval(TickCount interval) { m_interval = interval; }
   void SetPeriod(TickCount period) { m_period = period; }
 
+  // Category the callback's time is charged to in the frame timings.
+  FrameTimingCategory GetFrameTimingCategory() const { return m_frame_timing_category; }
+  void SetFrameTimingCategory(FrameTimingCategory category) { m_frame_timing_category = category; }
+
 private:
   TickCount m_downcount;
   TickCount m_time_since_last_run;
@@ -73,5 +78,7 @@ private:
   TimingEventCallback m_callback;
   System* m_system;
   std::string m_name;
+  const char* m_trace_name;
+  FrameTimingCategory m_frame_timing_category = FrameTimingCategory::Events;
   bool m_active;
 };
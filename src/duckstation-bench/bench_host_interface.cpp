@@ -0,0 +1,412 @@
+#include "bench_host_interface.h"
+#include "common/audio_stream.h"
+#include "common/file_system.h"
+#include "common/log.h"
+#include "common/string_util.h"
+#include "common/timer.h"
+#include "core/gpu.h"
+#include "core/gpu_dump.h"
+#include "core/system.h"
+#include "frontend-common/ini_settings_interface.h"
+#include "null_host_display.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#ifdef WITH_EGL
+#include "egl_host_display.h"
+#endif
+Log_SetChannel(BenchHostInterface);
+
+static void GetFrameTimeStats(const std::vector<float>& frame_times_ms, double total_time_ms, double* average_ms,
+                              double* worst_ms, double* best_ms)
+{
+  if (frame_times_ms.empty())
+  {
+    *average_ms = 0.0;
+    *worst_ms = 0.0;
+    *best_ms = 0.0;
+    return;
+  }
+
+  const auto [best, worst] = std::minmax_element(frame_times_ms.begin(), frame_times_ms.end());
+  *best_ms = *best;
+  *worst_ms = *worst;
+  *average_ms = total_time_ms / static_cast<double>(frame_times_ms.size());
+}
+
+void BenchHostInterface::Options::MakePathsAbsolute()
+{
+  filename = GetAbsolutePath(filename);
+  trace_filename = GetAbsolutePath(trace_filename);
+  gpu_dump_filename = GetAbsolutePath(gpu_dump_filename);
+  frame_dump_directory = GetAbsolutePath(frame_dump_directory);
+}
+
+BenchHostInterface::BenchHostInterface() = default;
+
+BenchHostInterface::~BenchHostInterface()
+{
+  DestroySystem();
+}
+
+std::string BenchHostInterface::GetAbsolutePath(const std::string& path)
+{
+#ifdef WIN32
+  const bool is_absolute = (!path.empty() && (path[0] == '\\' || path[0] == '/')) ||
+                           (path.length() > 1 && std::isalpha(static_cast<unsigned char>(path[0])) && path[1] == ':');
+#else
+  const bool is_absolute = (!path.empty() && path[0] == '/');
+#endif
+  if (path.empty() || is_absolute)
+    return path;
+
+  const std::string working_directory = FileSystem::GetWorkingDirectory();
+  if (working_directory.empty())
+    return path;
+
+  return working_directory + FS_OSPATH_SEPERATOR_CHARACTER + path;
+}
+
+bool BenchHostInterface::Initialize(const Options& options)
+{
+  INISettingsInterface si(GetSettingsFileName().c_str());
+  m_settings.Load(si);
+
+  if (options.gpu_renderer.has_value())
+    m_settings.gpu_renderer = options.gpu_renderer.value();
+  if (options.cpu_execution_mode.has_value())
+    m_settings.cpu_execution_mode = options.cpu_execution_mode.value();
+
+  // Run flat out, with nothing which would touch the disk or depend on the host during the run.
+  m_settings.speed_limiter_enabled = false;
+  m_settings.increase_timer_resolution = false;
+  m_settings.start_paused = false;
+  m_settings.save_state_on_exit = false;
+  m_settings.audio_backend = AudioBackend::Null;
+  m_settings.audio_sync_enabled = false;
+  m_settings.audio_dump_on_boot = false;
+  m_settings.video_sync_enabled = false;
+  m_settings.rewind_enable = false;
+  m_settings.display_show_frame_times = true;
+  m_settings.display_threaded_presentation = false;
+
+  // Anything which changes how much work a frame does is fixed rather than taken from the user's settings, so the
+  // results can be compared between runs and machines.
+  m_settings.runahead_frames = 0;
+  m_settings.display_frame_skip = 0;
+  m_settings.display_auto_frame_skip = false;
+  m_settings.gpu_use_thread = true;
+
+#ifdef WITH_EGL
+  const bool renderer_supported =
+    (m_settings.gpu_renderer == GPURenderer::Software || m_settings.gpu_renderer == GPURenderer::HardwareOpenGL);
+#else
+  const bool renderer_supported = (m_settings.gpu_renderer == GPURenderer::Software);
+#endif
+  if (!renderer_supported)
+  {
+    if (options.gpu_renderer.has_value())
+    {
+      Log_ErrorPrintf("Renderer '%s' requires a display, it can't be used for benchmarking.",
+                      Settings::GetRendererName(m_settings.gpu_renderer));
+      return false;
+    }
+
+    Log_WarningPrintf("Configured renderer '%s' requires a display, using the software renderer instead.",
+                      Settings::GetRendererName(m_settings.gpu_renderer));
+    m_settings.gpu_renderer = GPURenderer::Software;
+  }
+
+  // The null display used by the software renderer throws the frames away.
+  if (!options.frame_dump_directory.empty() && m_settings.gpu_renderer != GPURenderer::HardwareOpenGL)
+  {
+    Log_ErrorPrintf("Frame dumps are only supported with the OpenGL renderer.");
+    return false;
+  }
+
+  if (!options.frame_dump_directory.empty() && !FileSystem::DirectoryExists(options.frame_dump_directory.c_str()) &&
+      !FileSystem::CreateDirectory(options.frame_dump_directory.c_str(), false))
+  {
+    Log_ErrorPrintf("Failed to create frame dump directory '%s'", options.frame_dump_directory.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+bool BenchHostInterface::Run(const Options& options, Results* results)
+{
+  SystemBootParameters boot_params(options.filename);
+  if (!BootSystem(boot_params))
+    return false;
+
+  for (u32 i = 0; i < options.num_warmup_frames; i++)
+  {
+    RunFrame();
+    if (!IsFrameSkipped())
+      RenderDisplay();
+  }
+
+  results->game_code = m_system->GetRunningCode();
+  results->game_title = m_system->GetRunningTitle();
+  results->frame_times_ms.clear();
+  results->frame_times_ms.reserve(options.num_frames);
+
+  const u32 start_frame_number = m_system->GetFrameNumber();
+  const u32 start_internal_frame_number = m_system->GetInternalFrameNumber();
+  const u32 start_tick_counter = m_system->GetGlobalTickCounter();
+
+  FrameTimings& frame_timings = m_system->GetFrameTimings();
+  frame_timings.Reset();
+
+  if (!options.trace_filename.empty())
+    StartRecordingTrace();
+  if (!options.gpu_dump_filename.empty() && !StartDumpingGPU(options.gpu_dump_filename.c_str()))
+    Log_ErrorPrintf("Failed to start dumping GPU commands to '%s'", options.gpu_dump_filename.c_str());
+
+  double dump_time_ms = 0.0;
+  Common::Timer total_timer;
+  Common::Timer frame_timer;
+  for (u32 i = 0; i < options.num_frames; i++)
+  {
+    frame_timer.Reset();
+    RunFrame();
+    if (!IsFrameSkipped())
+    {
+      ScopedFrameTiming frame_timing(&frame_timings, FrameTimingCategory::Presentation);
+      RenderDisplay();
+    }
+    results->frame_times_ms.push_back(static_cast<float>(frame_timer.GetTimeMilliseconds()));
+
+    if (!IsFrameSkipped())
+      dump_time_ms += DumpFrame(options, i);
+  }
+
+  const double total_time_ms = total_timer.GetTimeMilliseconds() - dump_time_ms;
+  frame_timings.CommitFrame();
+  results->average_frame_times_ms = frame_timings.GetAverageTimes();
+
+  if (!options.trace_filename.empty())
+    StopRecordingTrace(options.trace_filename.c_str());
+  StopDumpingGPU();
+
+  const double total_time_seconds = total_time_ms / 1000.0;
+  results->num_frames = m_system->GetFrameNumber() - start_frame_number;
+  results->num_internal_frames = m_system->GetInternalFrameNumber() - start_internal_frame_number;
+  results->total_time_ms = total_time_ms;
+  results->vps = static_cast<double>(results->num_frames) / total_time_seconds;
+  results->fps = static_cast<double>(results->num_internal_frames) / total_time_seconds;
+  results->speed = (static_cast<double>(m_system->GetGlobalTickCounter() - start_tick_counter) /
+                    (static_cast<double>(MASTER_CLOCK) * total_time_seconds)) *
+                   100.0;
+
+  GetFrameTimeStats(results->frame_times_ms, total_time_ms, &results->average_frame_time_ms,
+                    &results->worst_frame_time_ms, &results->best_frame_time_ms);
+
+  DestroySystem();
+  return true;
+}
+
+bool BenchHostInterface::ReplayGPUDump(const Options& options, ReplayResults* results)
+{
+  GPUDump::Reader reader;
+  if (!reader.Open(options.filename.c_str()))
+  {
+    Log_ErrorPrintf("Failed to open GPU dump '%s'", options.filename.c_str());
+    return false;
+  }
+
+  // The CPU never runs, so no BIOS is needed. Everything the GPU touches comes from the dump.
+  if (!BootSystemForGPUDumpReplay())
+    return false;
+
+  GPU* gpu = m_system->GetGPU();
+
+  u32 num_primitives;
+  for (u32 i = 0; i < options.num_warmup_frames; i++)
+  {
+    if (!gpu->ReplayDumpFrame(&reader, &num_primitives))
+    {
+      Log_ErrorPrintf("GPU dump ended during the %u warmup frames", options.num_warmup_frames);
+      DestroySystem();
+      return false;
+    }
+
+    RenderDisplay();
+  }
+
+  results->num_primitives = 0;
+  results->frame_times_ms.clear();
+
+  if (!options.trace_filename.empty())
+    StartRecordingTrace();
+
+  double dump_time_ms = 0.0;
+  Common::Timer total_timer;
+  Common::Timer frame_timer;
+  for (u32 i = 0; i < options.num_frames; i++)
+  {
+    frame_timer.Reset();
+    const bool frame_complete = gpu->ReplayDumpFrame(&reader, &num_primitives);
+    results->num_primitives += num_primitives;
+    if (!frame_complete)
+      break;
+
+    RenderDisplay();
+    results->frame_times_ms.push_back(static_cast<float>(frame_timer.GetTimeMilliseconds()));
+    dump_time_ms += DumpFrame(options, i);
+  }
+
+  const double total_time_ms = total_timer.GetTimeMilliseconds() - dump_time_ms;
+  if (!options.trace_filename.empty())
+    StopRecordingTrace(options.trace_filename.c_str());
+
+  const double total_time_seconds = total_time_ms / 1000.0;
+  results->num_frames = static_cast<u32>(results->frame_times_ms.size());
+  results->total_time_ms = total_time_ms;
+  results->fps = static_cast<double>(results->num_frames) / total_time_seconds;
+  results->primitives_per_second = static_cast<double>(results->num_primitives) / total_time_seconds;
+  GetFrameTimeStats(results->frame_times_ms, total_time_ms, &results->average_frame_time_ms,
+                    &results->worst_frame_time_ms, &results->best_frame_time_ms);
+
+  DestroySystem();
+  return true;
+}
+
+static void WriteJSONString(std::FILE* fp, const std::string& str)
+{
+  std::fputc('"', fp);
+  for (const char ch : str)
+  {
+    if (ch == '"' || ch == '\\')
+      std::fprintf(fp, "\\%c", ch);
+    else if (static_cast<unsigned char>(ch) < 0x20)
+      std::fprintf(fp, "\\u%04x", static_cast<unsigned>(ch));
+    else
+      std::fputc(ch, fp);
+  }
+  std::fputc('"', fp);
+}
+
+static void WriteFrameTimesJSON(std::FILE* fp, const std::vector<float>& frame_times_ms)
+{
+  std::fprintf(fp, "  \"frame_times_ms\": [");
+  for (size_t i = 0; i < frame_times_ms.size(); i++)
+    std::fprintf(fp, "%s%.3f", (i > 0) ? ", " : "", frame_times_ms[i]);
+  std::fprintf(fp, "]\n");
+}
+
+void BenchHostInterface::WriteResultsJSON(std::FILE* fp, const Options& options, const Settings& settings,
+                                          const Results& results)
+{
+  std::fprintf(fp, "{\n");
+  std::fprintf(fp, "  \"filename\": ");
+  WriteJSONString(fp, options.filename);
+  std::fprintf(fp, ",\n  \"game_code\": ");
+  WriteJSONString(fp, results.game_code);
+  std::fprintf(fp, ",\n  \"game_title\": ");
+  WriteJSONString(fp, results.game_title);
+  std::fprintf(fp, ",\n  \"cpu_execution_mode\": \"%s\",\n",
+               Settings::GetCPUExecutionModeName(settings.cpu_execution_mode));
+  std::fprintf(fp, "  \"gpu_renderer\": \"%s\",\n", Settings::GetRendererName(settings.gpu_renderer));
+  std::fprintf(fp, "  \"warmup_frames\": %u,\n", options.num_warmup_frames);
+  std::fprintf(fp, "  \"frames\": %u,\n", results.num_frames);
+  std::fprintf(fp, "  \"internal_frames\": %u,\n", results.num_internal_frames);
+  std::fprintf(fp, "  \"total_time_ms\": %.3f,\n", results.total_time_ms);
+  std::fprintf(fp, "  \"fps\": %.3f,\n", results.fps);
+  std::fprintf(fp, "  \"vps\": %.3f,\n", results.vps);
+  std::fprintf(fp, "  \"speed\": %.3f,\n", results.speed);
+  std::fprintf(fp, "  \"average_frame_time_ms\": %.3f,\n", results.average_frame_time_ms);
+  std::fprintf(fp, "  \"worst_frame_time_ms\": %.3f,\n", results.worst_frame_time_ms);
+  std::fprintf(fp, "  \"best_frame_time_ms\": %.3f,\n", results.best_frame_time_ms);
+  std::fprintf(fp, "  \"average_frame_time_breakdown_ms\": {");
+  for (u32 i = static_cast<u32>(FrameTimingCategory::System); i < FrameTimings::NUM_CATEGORIES; i++)
+  {
+    std::fprintf(fp, "%s\"%s\": %.3f", (i > static_cast<u32>(FrameTimingCategory::System)) ? ", " : "",
+                 FrameTimings::GetCategoryName(static_cast<FrameTimingCategory>(i)),
+                 results.average_frame_times_ms[i]);
+  }
+  std::fprintf(fp, "},\n");
+  WriteFrameTimesJSON(fp, results.frame_times_ms);
+  std::fprintf(fp, "}\n");
+}
+
+void BenchHostInterface::WriteReplayResultsJSON(std::FILE* fp, const Options& options, const Settings& settings,
+                                                const ReplayResults& results)
+{
+  std::fprintf(fp, "{\n");
+  std::fprintf(fp, "  \"filename\": ");
+  WriteJSONString(fp, options.filename);
+  std::fprintf(fp, ",\n  \"gpu_renderer\": \"%s\",\n", Settings::GetRendererName(settings.gpu_renderer));
+  std::fprintf(fp, "  \"warmup_frames\": %u,\n", options.num_warmup_frames);
+  std::fprintf(fp, "  \"frames\": %u,\n", results.num_frames);
+  std::fprintf(fp, "  \"primitives\": %llu,\n", static_cast<unsigned long long>(results.num_primitives));
+  std::fprintf(fp, "  \"total_time_ms\": %.3f,\n", results.total_time_ms);
+  std::fprintf(fp, "  \"fps\": %.3f,\n", results.fps);
+  std::fprintf(fp, "  \"primitives_per_second\": %.3f,\n", results.primitives_per_second);
+  std::fprintf(fp, "  \"average_frame_time_ms\": %.3f,\n", results.average_frame_time_ms);
+  std::fprintf(fp, "  \"worst_frame_time_ms\": %.3f,\n", results.worst_frame_time_ms);
+  std::fprintf(fp, "  \"best_frame_time_ms\": %.3f,\n", results.best_frame_time_ms);
+  WriteFrameTimesJSON(fp, results.frame_times_ms);
+  std::fprintf(fp, "}\n");
+}
+
+void BenchHostInterface::RenderDisplay()
+{
+  // The GPU's render thread could own the context.
+  m_system->GetGPU()->ResetGraphicsAPIState();
+  m_display->Render();
+  m_system->GetGPU()->RestoreGraphicsAPIState();
+}
+
+double BenchHostInterface::DumpFrame(const Options& options, u32 frame_number)
+{
+  if (options.frame_dump_directory.empty() || options.frame_dump_interval == 0 ||
+      (frame_number % options.frame_dump_interval) != 0)
+  {
+    return 0.0;
+  }
+
+  Common::Timer timer;
+  const std::string filename = StringUtil::StdStringFromFormat(
+    "%s%cframe_%05u.png", options.frame_dump_directory.c_str(), FS_OSPATH_SEPERATOR_CHARACTER, frame_number);
+
+  // Unscaled, so dumps from different runs can be compared pixel for pixel.
+  if (!SaveScreenshot(filename.c_str(), true, false))
+    Log_ErrorPrintf("Failed to dump frame %u to '%s'", frame_number, filename.c_str());
+
+  return timer.GetTimeMilliseconds();
+}
+
+bool BenchHostInterface::AcquireHostDisplay()
+{
+#ifdef WITH_EGL
+  if (m_settings.gpu_renderer == GPURenderer::HardwareOpenGL)
+  {
+    m_host_display = EGLHostDisplay::Create();
+    if (!m_host_display)
+    {
+      Log_ErrorPrintf("Failed to create headless OpenGL display");
+      return false;
+    }
+
+    m_display = m_host_display.get();
+    return true;
+  }
+#endif
+
+  m_host_display = std::make_unique<NullHostDisplay>();
+  m_display = m_host_display.get();
+  return true;
+}
+
+void BenchHostInterface::ReleaseHostDisplay()
+{
+  m_display = nullptr;
+  m_host_display.reset();
+}
+
+std::unique_ptr<AudioStream> BenchHostInterface::CreateAudioStream(AudioBackend backend)
+{
+  return AudioStream::CreateNullAudioStream();
+}
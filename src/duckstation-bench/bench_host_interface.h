@@ -0,0 +1,96 @@
+#pragma once
+#include "core/frame_timings.h"
+#include "core/host_interface.h"
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Host interface which runs the system as fast as possible without any window or audio output.
+class BenchHostInterface final : public HostInterface
+{
+public:
+  struct Options
+  {
+    std::string filename;
+    std::string trace_filename;
+    std::string gpu_dump_filename;
+    std::string frame_dump_directory;
+    std::optional<GPURenderer> gpu_renderer;
+    std::optional<CPUExecutionMode> cpu_execution_mode;
+    u32 num_frames = 3600;
+    u32 num_warmup_frames = 60;
+    u32 frame_dump_interval = 60;
+
+    /// Resolves the relative paths against the working directory. The host interface changes to the user
+    /// directory when it's created, so this must be called before then.
+    void MakePathsAbsolute();
+  };
+
+  struct Results
+  {
+    std::string game_code;
+    std::string game_title;
+    u32 num_frames;
+    u32 num_internal_frames;
+    double total_time_ms;
+    double fps;
+    double vps;
+    double speed;
+    double average_frame_time_ms;
+    double worst_frame_time_ms;
+    double best_frame_time_ms;
+    FrameTimings::FrameTimes average_frame_times_ms;
+    std::vector<float> frame_times_ms;
+  };
+
+  struct ReplayResults
+  {
+    u32 num_frames;
+    u64 num_primitives;
+    double total_time_ms;
+    double fps;
+    double primitives_per_second;
+    double average_frame_time_ms;
+    double worst_frame_time_ms;
+    double best_frame_time_ms;
+    std::vector<float> frame_times_ms;
+  };
+
+  BenchHostInterface();
+  ~BenchHostInterface();
+
+  /// Loads settings from the user's configuration, then applies the overrides needed for benchmarking.
+  bool Initialize(const Options& options);
+
+  /// Boots the system, runs the warmup and measured frames, and shuts down.
+  bool Run(const Options& options, Results* results);
+
+  /// Replays a GPU dump into the renderer, without emulating the rest of the system.
+  bool ReplayGPUDump(const Options& options, ReplayResults* results);
+
+  /// Returns the path prefixed with the working directory if it's relative, or unchanged if it's absolute or empty.
+  static std::string GetAbsolutePath(const std::string& path);
+
+  /// Writes the results as JSON.
+  static void WriteResultsJSON(std::FILE* fp, const Options& options, const Settings& settings,
+                               const Results& results);
+  static void WriteReplayResultsJSON(std::FILE* fp, const Options& options, const Settings& settings,
+                                     const ReplayResults& results);
+
+protected:
+  bool AcquireHostDisplay() override;
+  void ReleaseHostDisplay() override;
+  std::unique_ptr<AudioStream> CreateAudioStream(AudioBackend backend) override;
+
+private:
+  /// Presents the frame, which for the OpenGL display waits for the GPU to finish it.
+  void RenderDisplay();
+
+  /// Writes the displayed frame to a PNG in the dump directory, if it's one of the frames to dump.
+  /// Returns the time taken, so it can be left out of the results.
+  double DumpFrame(const Options& options, u32 frame_number);
+
+  std::unique_ptr<HostDisplay> m_host_display;
+};
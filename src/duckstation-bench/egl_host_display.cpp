@@ -0,0 +1,311 @@
+#include "egl_host_display.h"
+#include "common/gl/texture.h"
+#include "common/log.h"
+#include <EGL/eglext.h>
+#include <array>
+#include <cstring>
+#include <glad.h>
+#include <imgui.h>
+#include <tuple>
+Log_SetChannel(EGLHostDisplay);
+
+namespace {
+class EGLHostDisplayTexture final : public HostDisplayTexture
+{
+public:
+  EGLHostDisplayTexture(GLuint id, u32 width, u32 height) : m_id(id), m_width(width), m_height(height) {}
+  ~EGLHostDisplayTexture() override { glDeleteTextures(1, &m_id); }
+
+  void* GetHandle() const override { return reinterpret_cast<void*>(static_cast<uintptr_t>(m_id)); }
+  u32 GetWidth() const override { return m_width; }
+  u32 GetHeight() const override { return m_height; }
+
+  GLuint GetGLID() const { return m_id; }
+
+private:
+  GLuint m_id;
+  u32 m_width;
+  u32 m_height;
+};
+} // namespace
+
+static bool HasExtension(const char* extensions, const char* name)
+{
+  if (!extensions)
+    return false;
+
+  const size_t name_length = std::strlen(name);
+  for (const char* pos = std::strstr(extensions, name); pos; pos = std::strstr(pos + name_length, name))
+  {
+    if ((pos == extensions || pos[-1] == ' ') && (pos[name_length] == ' ' || pos[name_length] == '\0'))
+      return true;
+  }
+
+  return false;
+}
+
+EGLHostDisplay::EGLHostDisplay() = default;
+
+EGLHostDisplay::~EGLHostDisplay()
+{
+  if (ImGui::GetCurrentContext())
+    ImGui::DestroyContext();
+
+  if (m_egl_display == EGL_NO_DISPLAY)
+    return;
+
+  DestroyContext();
+  eglTerminate(m_egl_display);
+}
+
+std::unique_ptr<EGLHostDisplay> EGLHostDisplay::Create()
+{
+  std::unique_ptr<EGLHostDisplay> display = std::make_unique<EGLHostDisplay>();
+  if (!display->CreateEGLDisplay() || !display->CreateContext())
+    return nullptr;
+
+  display->CreateImGuiContext();
+  return display;
+}
+
+void EGLHostDisplay::CreateImGuiContext()
+{
+  // Nothing is shown, but the renderer draws its loading screen through ImGui, so there has to be a frame to draw into.
+  m_window_width = 640;
+  m_window_height = 480;
+  ImGui::CreateContext();
+  ImGui::GetIO().IniFilename = nullptr;
+  ImGui::GetIO().DisplaySize.x = static_cast<float>(m_window_width);
+  ImGui::GetIO().DisplaySize.y = static_cast<float>(m_window_height);
+
+  unsigned char* font_pixels;
+  int font_width, font_height;
+  ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&font_pixels, &font_width, &font_height);
+  ImGui::NewFrame();
+}
+
+bool EGLHostDisplay::CreateEGLDisplay()
+{
+  // Mesa's surfaceless platform doesn't need an X server or a GPU, llvmpipe works too.
+  const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (HasExtension(client_extensions, "EGL_MESA_platform_surfaceless"))
+  {
+    auto get_platform_display =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display)
+      m_egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  }
+
+  if (m_egl_display == EGL_NO_DISPLAY)
+  {
+    Log_InfoPrintf("Surfaceless platform is not available, using the default EGL display");
+    m_egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+
+  EGLint major, minor;
+  if (m_egl_display == EGL_NO_DISPLAY || !eglInitialize(m_egl_display, &major, &minor))
+  {
+    Log_ErrorPrintf("Failed to initialize EGL display: 0x%X", eglGetError());
+    m_egl_display = EGL_NO_DISPLAY;
+    return false;
+  }
+
+  Log_InfoPrintf("EGL version %d.%d, vendor '%s'", major, minor, eglQueryString(m_egl_display, EGL_VENDOR));
+  return true;
+}
+
+bool EGLHostDisplay::CreateContext()
+{
+  // Prefer a desktop OpenGL context where possible. If we can't get this, try OpenGL ES.
+  if (CreateContextForAPI(EGL_OPENGL_API) || CreateContextForAPI(EGL_OPENGL_ES_API))
+  {
+    m_is_gles = (eglQueryAPI() == EGL_OPENGL_ES_API);
+    return true;
+  }
+
+  Log_ErrorPrintf("Failed to create any GL context");
+  return false;
+}
+
+bool EGLHostDisplay::CreateContextForAPI(EGLenum api)
+{
+  static constexpr std::array<std::tuple<int, int>, 11> desktop_versions_to_try = {
+    {{4, 6}, {4, 5}, {4, 4}, {4, 3}, {4, 2}, {4, 1}, {4, 0}, {3, 3}, {3, 2}, {3, 1}, {3, 0}}};
+  static constexpr std::array<std::tuple<int, int>, 3> es_versions_to_try = {{{3, 2}, {3, 1}, {3, 0}}};
+
+  const bool is_gles = (api == EGL_OPENGL_ES_API);
+  if (!eglBindAPI(api))
+    return false;
+
+  // Without surfaceless contexts, something has to be current for the context to be usable.
+  const bool surfaceless = HasExtension(eglQueryString(m_egl_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+  const EGLint config_attribs[] = {EGL_RENDERABLE_TYPE, is_gles ? EGL_OPENGL_ES3_BIT : EGL_OPENGL_BIT,
+                                   EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT, EGL_NONE};
+  EGLint num_configs = 0;
+  if (!eglChooseConfig(m_egl_display, config_attribs, &m_egl_config, 1, &num_configs) || num_configs == 0)
+  {
+    Log_InfoPrintf("No EGL config for %s", is_gles ? "OpenGL ES" : "desktop OpenGL");
+    return false;
+  }
+
+  if (!surfaceless)
+  {
+    const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    m_egl_surface = eglCreatePbufferSurface(m_egl_display, m_egl_config, pbuffer_attribs);
+    if (m_egl_surface == EGL_NO_SURFACE)
+    {
+      Log_ErrorPrintf("Failed to create pbuffer surface: 0x%X", eglGetError());
+      return false;
+    }
+  }
+
+  const std::tuple<int, int>* versions = is_gles ? es_versions_to_try.data() : desktop_versions_to_try.data();
+  const size_t num_versions = is_gles ? es_versions_to_try.size() : desktop_versions_to_try.size();
+  for (size_t i = 0; i < num_versions && m_egl_context == EGL_NO_CONTEXT; i++)
+  {
+    const auto [major, minor] = versions[i];
+    Log_InfoPrintf("Trying a %s %d.%d context", is_gles ? "OpenGL ES" : "Desktop OpenGL", major, minor);
+
+    const EGLint context_attribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                      major,
+                                      EGL_CONTEXT_MINOR_VERSION,
+                                      minor,
+                                      is_gles ? EGL_NONE : EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                      EGL_NONE};
+    m_egl_context = eglCreateContext(m_egl_display, m_egl_config, EGL_NO_CONTEXT, context_attribs);
+  }
+
+  if (m_egl_context == EGL_NO_CONTEXT || !MakeRenderContextCurrent())
+  {
+    DestroyContext();
+    return false;
+  }
+
+  // Load GLAD.
+  const GLADloadproc loader = reinterpret_cast<GLADloadproc>(eglGetProcAddress);
+  const auto load_result = is_gles ? gladLoadGLES2Loader(loader) : gladLoadGLLoader(loader);
+  if (!load_result)
+  {
+    Log_ErrorPrintf("Failed to load GL functions");
+    DestroyContext();
+    return false;
+  }
+
+  Log_InfoPrintf("GL_RENDERER: %s", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+  Log_InfoPrintf("GL_VERSION: %s", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+  return true;
+}
+
+void EGLHostDisplay::DestroyContext()
+{
+  eglMakeCurrent(m_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (m_egl_context != EGL_NO_CONTEXT)
+  {
+    eglDestroyContext(m_egl_display, m_egl_context);
+    m_egl_context = EGL_NO_CONTEXT;
+  }
+  if (m_egl_surface != EGL_NO_SURFACE)
+  {
+    eglDestroySurface(m_egl_display, m_egl_surface);
+    m_egl_surface = EGL_NO_SURFACE;
+  }
+}
+
+HostDisplay::RenderAPI EGLHostDisplay::GetRenderAPI() const
+{
+  return m_is_gles ? HostDisplay::RenderAPI::OpenGLES : HostDisplay::RenderAPI::OpenGL;
+}
+
+void* EGLHostDisplay::GetRenderDevice() const
+{
+  return nullptr;
+}
+
+void* EGLHostDisplay::GetRenderContext() const
+{
+  return m_egl_context;
+}
+
+void* EGLHostDisplay::GetRenderWindow() const
+{
+  return nullptr;
+}
+
+void EGLHostDisplay::ChangeRenderWindow(void* new_window) {}
+
+std::unique_ptr<HostDisplayTexture> EGLHostDisplay::CreateTexture(u32 width, u32 height, const void* data,
+                                                                  u32 data_stride, bool dynamic)
+{
+  GLuint id;
+  glGenTextures(1, &id);
+
+  GLint old_texture_binding = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture_binding);
+
+  glBindTexture(GL_TEXTURE_2D, id);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, data_stride / sizeof(u32));
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+  glBindTexture(GL_TEXTURE_2D, old_texture_binding);
+  return std::make_unique<EGLHostDisplayTexture>(id, width, height);
+}
+
+void EGLHostDisplay::UpdateTexture(HostDisplayTexture* texture, u32 x, u32 y, u32 width, u32 height,
+                                   const void* data, u32 data_stride)
+{
+  EGLHostDisplayTexture* tex = static_cast<EGLHostDisplayTexture*>(texture);
+
+  GLint old_texture_binding = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture_binding);
+
+  glBindTexture(GL_TEXTURE_2D, tex->GetGLID());
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, data_stride / sizeof(u32));
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  glBindTexture(GL_TEXTURE_2D, old_texture_binding);
+}
+
+bool EGLHostDisplay::DownloadTexture(const void* texture_handle, u32 x, u32 y, u32 width, u32 height, void* out_data,
+                                     u32 out_data_stride)
+{
+  GLint old_alignment = 0, old_row_length = 0;
+  glGetIntegerv(GL_PACK_ALIGNMENT, &old_alignment);
+  glGetIntegerv(GL_PACK_ROW_LENGTH, &old_row_length);
+  glPixelStorei(GL_PACK_ALIGNMENT, sizeof(u32));
+  glPixelStorei(GL_PACK_ROW_LENGTH, out_data_stride / sizeof(u32));
+
+  const GLuint texture = static_cast<GLuint>(reinterpret_cast<uintptr_t>(texture_handle));
+  GL::Texture::GetTextureSubImage(texture, 0, x, y, 0, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                                  height * out_data_stride, out_data);
+
+  glPixelStorei(GL_PACK_ALIGNMENT, old_alignment);
+  glPixelStorei(GL_PACK_ROW_LENGTH, old_row_length);
+  return true;
+}
+
+void EGLHostDisplay::Render()
+{
+  // There's nothing to present to. Waiting for the GPU stands in for the swap, so frame times include the
+  // renderer's GPU work instead of letting it queue up.
+  glFinish();
+  m_display_changed = false;
+
+  ImGui::Render();
+  ImGui::NewFrame();
+}
+
+void EGLHostDisplay::SetVSync(bool enabled) {}
+
+bool EGLHostDisplay::MakeRenderContextCurrent()
+{
+  return (eglMakeCurrent(m_egl_display, m_egl_surface, m_egl_surface, m_egl_context) == EGL_TRUE);
+}
+
+bool EGLHostDisplay::DoneRenderContextCurrent()
+{
+  return (eglMakeCurrent(m_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) == EGL_TRUE);
+}
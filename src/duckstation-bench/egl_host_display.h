@@ -0,0 +1,50 @@
+#pragma once
+#include "core/host_display.h"
+#include <EGL/egl.h>
+#include <memory>
+
+// OpenGL display without a window, for running the hardware renderer on headless machines. Uses a surfaceless context
+// where the driver supports it (e.g. Mesa's surfaceless platform), otherwise a 1x1 pbuffer.
+class EGLHostDisplay final : public HostDisplay
+{
+public:
+  EGLHostDisplay();
+  ~EGLHostDisplay();
+
+  static std::unique_ptr<EGLHostDisplay> Create();
+
+  RenderAPI GetRenderAPI() const override;
+  void* GetRenderDevice() const override;
+  void* GetRenderContext() const override;
+  void* GetRenderWindow() const override;
+
+  void ChangeRenderWindow(void* new_window) override;
+
+  std::unique_ptr<HostDisplayTexture> CreateTexture(u32 width, u32 height, const void* data, u32 data_stride,
+                                                    bool dynamic) override;
+  void UpdateTexture(HostDisplayTexture* texture, u32 x, u32 y, u32 width, u32 height, const void* data,
+                     u32 data_stride) override;
+  bool DownloadTexture(const void* texture_handle, u32 x, u32 y, u32 width, u32 height, void* out_data,
+                       u32 out_data_stride) override;
+
+  void Render() override;
+
+  void SetVSync(bool enabled) override;
+
+  bool MakeRenderContextCurrent() override;
+  bool DoneRenderContextCurrent() override;
+
+private:
+  bool CreateEGLDisplay();
+  bool CreateContext();
+  bool CreateContextForAPI(EGLenum api);
+  void DestroyContext();
+  void CreateImGuiContext();
+
+  EGLDisplay m_egl_display = EGL_NO_DISPLAY;
+  EGLConfig m_egl_config = nullptr;
+  EGLContext m_egl_context = EGL_NO_CONTEXT;
+  EGLSurface m_egl_surface = EGL_NO_SURFACE;
+
+  bool m_is_gles = false;
+};
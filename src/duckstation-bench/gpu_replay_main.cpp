@@ -0,0 +1,131 @@
+#include "bench_host_interface.h"
+#include "common/log.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+static void PrintUsage(const char* progname)
+{
+  std::fprintf(stderr,
+               "Usage: %s [options] <gpu dump>\n"
+               "  -frames <count>: Maximum number of frames to measure (default all).\n"
+               "  -warmup <count>: Number of frames to replay before measuring (default 0).\n"
+               "  -renderer <name>: GPU renderer to use, Software or OpenGL (when built with EGL).\n"
+               "  -output <file>: Write JSON results to the file instead of stdout.\n"
+               "  -trace <file>: Record a trace of the measured frames, in Chrome trace-event format.\n"
+               "  -dump-frames <dir>: Write every Nth measured frame to a PNG in the directory, OpenGL only.\n"
+               "  -dump-interval <count>: Frames between dumped frames (default 60).\n"
+               "  -verbose: Enable informational log messages.\n",
+               progname);
+}
+
+int main(int argc, char* argv[])
+{
+  BenchHostInterface::Options options;
+  options.num_frames = std::numeric_limits<u32>::max();
+  options.num_warmup_frames = 0;
+
+  std::string output_filename;
+  LOGLEVEL log_level = LOGLEVEL_WARNING;
+
+  for (int i = 1; i < argc; i++)
+  {
+#define CHECK_ARG(str) !std::strcmp(argv[i], str)
+#define CHECK_ARG_PARAM(str) (!std::strcmp(argv[i], str) && ((i + 1) < argc))
+
+    if (CHECK_ARG_PARAM("-frames"))
+    {
+      options.num_frames = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG_PARAM("-warmup"))
+    {
+      options.num_warmup_frames = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG_PARAM("-renderer"))
+    {
+      options.gpu_renderer = Settings::ParseRendererName(argv[++i]);
+      if (!options.gpu_renderer.has_value())
+      {
+        std::fprintf(stderr, "Unknown renderer '%s'\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (CHECK_ARG_PARAM("-output"))
+    {
+      output_filename = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-trace"))
+    {
+      options.trace_filename = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-dump-frames"))
+    {
+      options.frame_dump_directory = argv[++i];
+    }
+    else if (CHECK_ARG_PARAM("-dump-interval"))
+    {
+      options.frame_dump_interval = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (CHECK_ARG("-verbose"))
+    {
+      log_level = LOGLEVEL_INFO;
+    }
+    else if (CHECK_ARG("-help") || argv[i][0] == '-')
+    {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    else
+    {
+      options.filename = argv[i];
+    }
+
+#undef CHECK_ARG
+#undef CHECK_ARG_PARAM
+  }
+
+  if (options.filename.empty() || options.num_frames == 0)
+  {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // warnings and errors go to stderr, so stdout only carries the results unless -verbose is used
+  Log::SetConsoleOutputParams(true, nullptr, log_level);
+  Log::SetFilterLevel(log_level);
+
+  // the host interface changes to the user directory, so paths given relative to the launch directory must be
+  // resolved first
+  options.MakePathsAbsolute();
+  output_filename = BenchHostInterface::GetAbsolutePath(output_filename);
+
+  BenchHostInterface host_interface;
+  if (!host_interface.Initialize(options))
+    return EXIT_FAILURE;
+
+  BenchHostInterface::ReplayResults results;
+  if (!host_interface.ReplayGPUDump(options, &results))
+  {
+    std::fprintf(stderr, "Failed to replay '%s'\n", options.filename.c_str());
+    return EXIT_FAILURE;
+  }
+
+  std::FILE* fp = stdout;
+  if (!output_filename.empty())
+  {
+    fp = std::fopen(output_filename.c_str(), "w");
+    if (!fp)
+    {
+      std::fprintf(stderr, "Failed to open '%s' for writing\n", output_filename.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  BenchHostInterface::WriteReplayResultsJSON(fp, options, host_interface.GetSettings(), results);
+
+  if (fp != stdout)
+    std::fclose(fp);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include "null_host_display.h"
+
+namespace {
+class NullHostDisplayTexture final : public HostDisplayTexture
+{
+public:
+  NullHostDisplayTexture(u32 width, u32 height) : m_width(width), m_height(height) {}
+  ~NullHostDisplayTexture() override = default;
+
+  void* GetHandle() const override { return const_cast<NullHostDisplayTexture*>(this); }
+  u32 GetWidth() const override { return m_width; }
+  u32 GetHeight() const override { return m_height; }
+
+private:
+  u32 m_width;
+  u32 m_height;
+};
+} // namespace
+
+NullHostDisplay::NullHostDisplay() = default;
+
+NullHostDisplay::~NullHostDisplay() = default;
+
+HostDisplay::RenderAPI NullHostDisplay::GetRenderAPI() const
+{
+  return RenderAPI::None;
+}
+
+void* NullHostDisplay::GetRenderDevice() const
+{
+  return nullptr;
+}
+
+void* NullHostDisplay::GetRenderContext() const
+{
+  return nullptr;
+}
+
+void* NullHostDisplay::GetRenderWindow() const
+{
+  return nullptr;
+}
+
+void NullHostDisplay::ChangeRenderWindow(void* new_window) {}
+
+std::unique_ptr<HostDisplayTexture> NullHostDisplay::CreateTexture(u32 width, u32 height, const void* data,
+                                                                   u32 data_stride, bool dynamic)
+{
+  return std::make_unique<NullHostDisplayTexture>(width, height);
+}
+
+void NullHostDisplay::UpdateTexture(HostDisplayTexture* texture, u32 x, u32 y, u32 width, u32 height,
+                                    const void* data, u32 data_stride)
+{
+}
+
+bool NullHostDisplay::DownloadTexture(const void* texture_handle, u32 x, u32 y, u32 width, u32 height,
+                                      void* out_data, u32 out_data_stride)
+{
+  return false;
+}
+
+void NullHostDisplay::Render()
+{
+  // Nothing to present, but the frame still needs to be "consumed".
+  m_display_changed = false;
+}
+
+void NullHostDisplay::SetVSync(bool enabled) {}
@@ -0,0 +1,28 @@
+#pragma once
+#include "core/host_display.h"
+
+// Display which discards everything, for running without a window. Only usable with the software renderer.
+class NullHostDisplay final : public HostDisplay
+{
+public:
+  NullHostDisplay();
+  ~NullHostDisplay();
+
+  RenderAPI GetRenderAPI() const override;
+  void* GetRenderDevice() const override;
+  void* GetRenderContext() const override;
+  void* GetRenderWindow() const override;
+
+  void ChangeRenderWindow(void* new_window) override;
+
+  std::unique_ptr<HostDisplayTexture> CreateTexture(u32 width, u32 height, const void* data, u32 data_stride,
+                                                    bool dynamic) override;
+  void UpdateTexture(HostDisplayTexture* texture, u32 x, u32 y, u32 width, u32 height, const void* data,
+                     u32 data_stride) override;
+  bool DownloadTexture(const void* texture_handle, u32 x, u32 y, u32 width, u32 height, void* out_data,
+                       u32 out_data_stride) override;
+
+  void Render() override;
+
+  void SetVSync(bool enabled) override;
+};
@@ -15,6 +15,7 @@ GeneralSettingsWidget::GeneralSettingsWidget(QtHostInterface* host_interface, QW
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.showFPS, "Display/ShowFPS");
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.showVPS, "Display/ShowVPS");
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.showSpeed, "Display/ShowSpeed");
+  SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.showFrameTimes, "Display/ShowFrameTimes");
 
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.enableSpeedLimiter, "Main/SpeedLimiterEnabled");
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.increaseTimerResolution,
@@ -59,6 +60,9 @@ GeneralSettingsWidget::GeneralSettingsWidget(QtHostInterface* host_interface, QW
   dialog->registerWidgetHelp(
     m_ui.showSpeed, "Show Speed", "Unchecked",
     "Shows the current emulation speed of the system in the top-right corner of the display as a percentage.");
+  dialog->registerWidgetHelp(m_ui.showFrameTimes, "Show Frame Times", "Unchecked",
+                             "Shows a graph of where time is spent each frame, split by CPU, GPU, SPU, CD-ROM and "
+                             "presentation, in the top-right corner of the display. Slightly reduces performance.");
 }
 
 GeneralSettingsWidget::~GeneralSettingsWidget() = default;
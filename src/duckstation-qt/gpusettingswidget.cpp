@@ -12,6 +12,7 @@ GPUSettingsWidget::GPUSettingsWidget(QtHostInterface* host_interface, QWidget* p
   SettingWidgetBinder::BindWidgetToEnumSetting(m_host_interface, m_ui.renderer, "GPU/Renderer",
                                                &Settings::ParseRendererName, &Settings::GetRendererName);
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.useDebugDevice, "GPU/UseDebugDevice");
+  SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.useThread, "GPU/UseThread");
   SettingWidgetBinder::BindWidgetToEnumSetting(m_host_interface, m_ui.cropMode, "Display/CropMode",
                                                &Settings::ParseDisplayCropMode, &Settings::GetDisplayCropModeName);
   SettingWidgetBinder::BindWidgetToBoolSetting(m_host_interface, m_ui.forceProgressiveScan,
@@ -716,9 +716,10 @@ void QtHostInterface::threadEntryPoint()
       continue;
     }
 
-    m_system->RunFrame();
+    RunFrame();
 
-    renderDisplay();
+    if (!IsFrameSkipped())
+      renderDisplay();
 
     if (m_speed_limiter_enabled)
       m_system->Throttle();
@@ -739,6 +740,8 @@ void QtHostInterface::threadEntryPoint()
 
 void QtHostInterface::renderDisplay()
 {
+  ScopedFrameTiming frame_timing(&m_system->GetFrameTimings(), FrameTimingCategory::Presentation);
+
   m_system->GetGPU()->ResetGraphicsAPIState();
 
   DrawImGuiWindows();
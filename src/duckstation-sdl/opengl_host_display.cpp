@@ -57,6 +57,11 @@ OpenGLHostDisplay::~OpenGLHostDisplay()
 {
   if (m_gl_context)
   {
+    StopPresenterThread();
+    DestroyPresentBuffers();
+    if (m_present_context)
+      SDL_GL_DeleteContext(m_present_context);
+
     if (m_display_vao != 0)
       glDeleteVertexArrays(1, &m_display_vao);
     if (m_display_linear_sampler != 0)
@@ -149,6 +154,11 @@ bool OpenGLHostDisplay::DownloadTexture(const void* texture_handle, u32 x, u32 y
 
 void OpenGLHostDisplay::SetVSync(bool enabled)
 {
+  // The presenter thread picks this up before its next swap.
+  m_vsync.store(enabled);
+  if (m_threaded_presentation)
+    return;
+
   // Window framebuffer has to be bound to call SetSwapInterval.
   GLint current_fbo = 0;
   glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &current_fbo);
@@ -157,6 +167,174 @@ void OpenGLHostDisplay::SetVSync(bool enabled)
   glBindFramebuffer(GL_DRAW_FRAMEBUFFER, current_fbo);
 }
 
+bool OpenGLHostDisplay::MakeRenderContextCurrent()
+{
+  return (SDL_GL_MakeCurrent(m_window, m_gl_context) == 0);
+}
+
+bool OpenGLHostDisplay::DoneRenderContextCurrent()
+{
+  return (SDL_GL_MakeCurrent(m_window, nullptr) == 0);
+}
+
+bool OpenGLHostDisplay::SetThreadedPresentation(bool enabled)
+{
+  if (enabled == m_threaded_presentation)
+    return true;
+
+  if (!enabled)
+  {
+    StopPresenterThread();
+    DestroyPresentBuffers();
+    m_threaded_presentation = false;
+    SetVSync(m_vsync.load());
+    return true;
+  }
+
+  if (!GLAD_GL_VERSION_3_2 && !GLAD_GL_ARB_sync && !GLAD_GL_ES_VERSION_3_0)
+  {
+    Log_WarningPrintf("Sync objects are not supported, presenting on the emulation thread");
+    return false;
+  }
+
+  if (!StartPresenterThread())
+  {
+    Log_WarningPrintf("Failed to start presenter thread, presenting on the emulation thread");
+    return false;
+  }
+
+  m_threaded_presentation = true;
+  return true;
+}
+
+bool OpenGLHostDisplay::StartPresenterThread()
+{
+  if (!m_present_context)
+  {
+    // The new context takes the attributes of the current one, and SDL makes it current.
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    m_present_context = SDL_GL_CreateContext(m_window);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    SDL_GL_MakeCurrent(m_window, m_gl_context);
+    if (!m_present_context)
+    {
+      Log_ErrorPrintf("Failed to create presentation context: %s", SDL_GetError());
+      return false;
+    }
+  }
+
+  m_present_write_index = 0;
+  m_present_ready_index = 1;
+  m_present_read_index = 2;
+  m_present_ready = false;
+  m_present_shutdown = false;
+
+  std::promise<bool> started;
+  std::future<bool> started_future = started.get_future();
+  m_present_thread = std::thread(&OpenGLHostDisplay::PresenterThreadEntryPoint, this, &started);
+  if (!started_future.get())
+  {
+    m_present_thread.join();
+    return false;
+  }
+
+  return true;
+}
+
+void OpenGLHostDisplay::StopPresenterThread()
+{
+  if (!m_present_thread.joinable())
+    return;
+
+  {
+    std::unique_lock<std::mutex> lock(m_present_mutex);
+    m_present_shutdown = true;
+    m_present_cv.notify_one();
+  }
+
+  m_present_thread.join();
+}
+
+void OpenGLHostDisplay::PresenterThreadEntryPoint(std::promise<bool>* started)
+{
+  if (SDL_GL_MakeCurrent(m_window, m_present_context) != 0)
+  {
+    Log_ErrorPrintf("Failed to make presentation context current: %s", SDL_GetError());
+    started->set_value(false);
+    return;
+  }
+
+  started->set_value(true);
+
+  int swap_interval = -1;
+  std::unique_lock<std::mutex> lock(m_present_mutex);
+  for (;;)
+  {
+    m_present_cv.wait(lock, [this]() { return m_present_ready || m_present_shutdown; });
+    if (m_present_shutdown)
+      break;
+
+    std::swap(m_present_read_index, m_present_ready_index);
+    m_present_ready = false;
+    lock.unlock();
+
+    PresentBuffer& buffer = m_present_buffers[m_present_read_index];
+    const int new_swap_interval = m_vsync.load() ? 1 : 0;
+    if (swap_interval != new_swap_interval)
+    {
+      SDL_GL_SetSwapInterval(new_swap_interval);
+      swap_interval = new_swap_interval;
+    }
+
+    glWaitSync(buffer.render_fence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(buffer.render_fence);
+    buffer.render_fence = nullptr;
+
+    // Re-attach every time, so a resized texture is picked up by this context.
+    if (buffer.present_framebuffer == 0)
+      glGenFramebuffers(1, &buffer.present_framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, buffer.present_framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, buffer.texture, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, buffer.width, buffer.height, 0, 0, buffer.width, buffer.height, GL_COLOR_BUFFER_BIT,
+                      GL_NEAREST);
+    buffer.present_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    SDL_GL_SwapWindow(m_window);
+    lock.lock();
+  }
+
+  lock.unlock();
+  for (PresentBuffer& buffer : m_present_buffers)
+  {
+    if (buffer.present_framebuffer != 0)
+    {
+      glDeleteFramebuffers(1, &buffer.present_framebuffer);
+      buffer.present_framebuffer = 0;
+    }
+  }
+
+  glFinish();
+  SDL_GL_MakeCurrent(m_window, nullptr);
+}
+
+void OpenGLHostDisplay::DestroyPresentBuffers()
+{
+  for (PresentBuffer& buffer : m_present_buffers)
+  {
+    if (buffer.render_fence)
+      glDeleteSync(buffer.render_fence);
+    if (buffer.present_fence)
+      glDeleteSync(buffer.present_fence);
+    if (buffer.framebuffer != 0)
+      glDeleteFramebuffers(1, &buffer.framebuffer);
+    if (buffer.texture != 0)
+      glDeleteTextures(1, &buffer.texture);
+
+    buffer = {};
+  }
+}
+
 const char* OpenGLHostDisplay::GetGLSLVersionString() const
 {
   if (m_is_gles)
@@ -370,8 +548,74 @@ std::unique_ptr<HostDisplay> OpenGLHostDisplay::Create(SDL_Window* window, bool
 
 void OpenGLHostDisplay::Render()
 {
+  if (m_threaded_presentation)
+  {
+    RenderToPresentBuffer();
+  }
+  else
+  {
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    RenderDisplay();
+
+    ImGui::Render();
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+    SDL_GL_SwapWindow(m_window);
+  }
+
+  ImGui::NewFrame();
+  ImGui_ImplSDL2_NewFrame(m_window);
+  ImGui_ImplOpenGL3_NewFrame();
+
+  GL::Program::ResetLastProgram();
+}
+
+void OpenGLHostDisplay::RenderToPresentBuffer()
+{
+  PresentBuffer& buffer = m_present_buffers[m_present_write_index];
+
+  // A frame which was replaced before the presenter got to it still has its fence.
+  if (buffer.render_fence)
+  {
+    glDeleteSync(buffer.render_fence);
+    buffer.render_fence = nullptr;
+  }
+  if (buffer.present_fence)
+  {
+    glWaitSync(buffer.present_fence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(buffer.present_fence);
+    buffer.present_fence = nullptr;
+  }
+
+  if (buffer.width != m_window_width || buffer.height != m_window_height)
+  {
+    if (buffer.texture == 0)
+      glGenTextures(1, &buffer.texture);
+
+    GLint old_texture_binding = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &old_texture_binding);
+    glBindTexture(GL_TEXTURE_2D, buffer.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_window_width, m_window_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D, old_texture_binding);
+
+    if (buffer.framebuffer == 0)
+    {
+      glGenFramebuffers(1, &buffer.framebuffer);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, buffer.framebuffer);
+      glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, buffer.texture, 0);
+    }
+
+    buffer.width = m_window_width;
+    buffer.height = m_window_height;
+  }
+
   glDisable(GL_SCISSOR_TEST);
-  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, buffer.framebuffer);
   glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
   glClear(GL_COLOR_BUFFER_BIT);
 
@@ -380,13 +624,15 @@ void OpenGLHostDisplay::Render()
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-  SDL_GL_SwapWindow(m_window);
-
-  ImGui::NewFrame();
-  ImGui_ImplSDL2_NewFrame(m_window);
-  ImGui_ImplOpenGL3_NewFrame();
+  buffer.render_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-  GL::Program::ResetLastProgram();
+  // Anything still waiting in the ready buffer is dropped, only the newest frame is presented.
+  std::unique_lock<std::mutex> lock(m_present_mutex);
+  std::swap(m_present_write_index, m_present_ready_index);
+  m_present_ready = true;
+  m_present_cv.notify_one();
 }
 
 void OpenGLHostDisplay::RenderDisplay()
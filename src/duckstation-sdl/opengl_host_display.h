@@ -3,8 +3,14 @@
 #include "common/gl/texture.h"
 #include "core/host_display.h"
 #include <SDL.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 class OpenGLHostDisplay final : public HostDisplay
 {
@@ -31,7 +37,26 @@ public:
 
   void SetVSync(bool enabled) override;
 
+  bool MakeRenderContextCurrent() override;
+  bool DoneRenderContextCurrent() override;
+
+  bool SetThreadedPresentation(bool enabled) override;
+
 private:
+  static constexpr u32 NUM_PRESENT_BUFFERS = 3;
+
+  /// Window-sized image of a finished frame, passed from Render() to the presenter thread.
+  struct PresentBuffer
+  {
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+    GLuint present_framebuffer = 0; // belongs to the presenter's context, framebuffers aren't shared
+    GLsync render_fence = nullptr;  // signaled when the frame has been drawn
+    GLsync present_fence = nullptr; // signaled when the presenter has finished reading it
+    s32 width = 0;
+    s32 height = 0;
+  };
+
   const char* GetGLSLVersionString() const;
   std::string GetGLSLVersionHeader() const;
 
@@ -42,6 +67,14 @@ private:
   void Render() override;
   void RenderDisplay();
 
+  /// Draws the frame into a present buffer and hands it to the presenter thread.
+  void RenderToPresentBuffer();
+
+  bool StartPresenterThread();
+  void StopPresenterThread();
+  void PresenterThreadEntryPoint(std::promise<bool>* started);
+  void DestroyPresentBuffers();
+
   SDL_Window* m_window = nullptr;
   SDL_GLContext m_gl_context = nullptr;
 
@@ -51,4 +84,20 @@ private:
   GLuint m_display_linear_sampler = 0;
 
   bool m_is_gles = false;
+  std::atomic_bool m_vsync{true};
+
+  SDL_GLContext m_present_context = nullptr;
+  std::array<PresentBuffer, NUM_PRESENT_BUFFERS> m_present_buffers;
+
+  // Triple buffering: Render() owns the write buffer, the presenter owns the read buffer, and the newest finished
+  // frame waits in the ready buffer. The indices are swapped under the mutex.
+  u32 m_present_write_index = 0;
+  u32 m_present_ready_index = 1;
+  u32 m_present_read_index = 2;
+  bool m_present_ready = false;
+  bool m_present_shutdown = false;
+
+  std::thread m_present_thread;
+  std::mutex m_present_mutex;
+  std::condition_variable m_present_cv;
 };
@@ -205,6 +205,7 @@ bool SDLHostInterface::AcquireHostDisplay()
 void SDLHostInterface::ReleaseHostDisplay()
 {
   // restore vsync, since we don't want to burn cycles at the menu
+  m_display->SetThreadedPresentation(false);
   m_display->SetVSync(true);
 }
 
@@ -463,6 +464,13 @@ void SDLHostInterface::HandleSDLKeyEvent(const SDL_Event* event)
     }
     break;
 
+    case SDL_SCANCODE_R:
+    {
+      if (!repeat)
+        SetRewinding(pressed);
+    }
+    break;
+
     case SDL_SCANCODE_PAUSE:
     {
       if (pressed)
@@ -891,6 +899,22 @@ void SDLHostInterface::DrawQuickSettingsMenu()
       StopDumpingAudio();
   }
 
+  if (ImGui::MenuItem("Dump GPU Commands", nullptr, IsDumpingGPU(), HasSystem()))
+  {
+    if (!IsDumpingGPU())
+      StartDumpingGPU();
+    else
+      StopDumpingGPU();
+  }
+
+  if (ImGui::MenuItem("Record Trace", nullptr, IsRecordingTrace()))
+  {
+    if (!IsRecordingTrace())
+      StartRecordingTrace();
+    else
+      StopRecordingTrace();
+  }
+
   if (ImGui::MenuItem("Save Screenshot"))
     RunLater([this]() { SaveScreenshot(); });
 
@@ -1241,9 +1265,22 @@ void SDLHostInterface::DrawSettingsWindow()
           settings_changed = true;
         }
 
+        ImGui::Text("Frame Skip:");
+        ImGui::SameLine(indent);
+
+        int frame_skip = static_cast<int>(m_settings_copy.display_frame_skip);
+        if (ImGui::SliderInt("##frame_skip", &frame_skip, 0, 10))
+        {
+          m_settings_copy.display_frame_skip = static_cast<u32>(frame_skip);
+          settings_changed = true;
+        }
+
+        settings_changed |= ImGui::Checkbox("Automatic Frame Skip", &m_settings_copy.display_auto_frame_skip);
         settings_changed |= ImGui::Checkbox("Use Debug Device", &m_settings_copy.gpu_use_debug_device);
+        settings_changed |= ImGui::Checkbox("Threaded Rendering", &m_settings_copy.gpu_use_thread);
         settings_changed |= ImGui::Checkbox("Linear Filtering", &m_settings_copy.display_linear_filtering);
         settings_changed |= ImGui::Checkbox("VSync", &m_settings_copy.video_sync_enabled);
+        settings_changed |= ImGui::Checkbox("Threaded Presentation", &m_settings_copy.display_threaded_presentation);
       }
 
       ImGui::NewLine();
@@ -1414,9 +1451,11 @@ void SDLHostInterface::Run()
         break;
     }
 
+    bool frame_skipped = false;
     if (m_system && !m_paused)
     {
-      m_system->RunFrame();
+      RunFrame();
+      frame_skipped = IsFrameSkipped();
       if (m_frame_step_request)
       {
         m_frame_step_request = false;
@@ -1426,23 +1465,27 @@ void SDLHostInterface::Run()
 
     //g_sdl_controller_interface.UpdateControllerRumble();
 
-    // rendering
+    // rendering, dropped frames go straight to the throttle
+    if (!frame_skipped)
     {
       DrawImGuiWindows();
 
+      // The menus can destroy the system, so this can't include drawing them.
+      ScopedFrameTiming frame_timing(m_system ? &m_system->GetFrameTimings() : nullptr,
+                                     FrameTimingCategory::Presentation);
+
       if (m_system)
         m_system->GetGPU()->ResetGraphicsAPIState();
 
       m_display->Render();
 
       if (m_system)
-      {
         m_system->GetGPU()->RestoreGraphicsAPIState();
-
-        if (m_speed_limiter_enabled)
-          m_system->Throttle();
-      }
     }
+
+    // Presenting on another thread no longer waits for vsync here, so pause at the emulated frame rate instead.
+    if (m_system && (m_speed_limiter_enabled || (m_paused && m_display->IsUsingThreadedPresentation())))
+      m_system->Throttle();
   }
 
   // Save state on exit so it can be resumed
@@ -130,6 +130,7 @@ void CommonHostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetStringValue("Controller1", "ButtonR2", "Keyboard/3");
   si.SetStringValue("Hotkeys", "FastForward", "Keyboard/Tab");
   si.SetStringValue("Hotkeys", "TogglePause", "Keyboard/Pause");
+  si.SetStringValue("Hotkeys", "Rewind", "Keyboard/R");
   si.SetStringValue("Hotkeys", "ToggleFullscreen", "Keyboard/Alt+Return");
   si.SetStringValue("Hotkeys", "PowerOff", "Keyboard/Escape");
   si.SetStringValue("Hotkeys", "Screenshot", "Keyboard/F10");
@@ -372,6 +373,9 @@ void CommonHostInterface::RegisterGeneralHotkeys()
                    HostInterface::UpdateSpeedLimiterState();
                  });
 
+  RegisterHotkey(StaticString("General"), StaticString("Rewind"), StaticString("Rewind"),
+                 [this](bool pressed) { SetRewinding(pressed); });
+
   RegisterHotkey(StaticString("General"), StaticString("ToggleFullscreen"), StaticString("Toggle Fullscreen"),
                  [this](bool pressed) {
                    if (!pressed)
@@ -410,6 +414,28 @@ void CommonHostInterface::RegisterGeneralHotkeys()
                    if (!pressed && m_system)
                      SaveScreenshot();
                  });
+
+  RegisterHotkey(StaticString("General"), StaticString("ToggleTraceRecording"),
+                 StaticString("Toggle Trace Recording"), [this](bool pressed) {
+                   if (pressed)
+                     return;
+
+                   if (!IsRecordingTrace())
+                     StartRecordingTrace();
+                   else
+                     StopRecordingTrace();
+                 });
+
+  RegisterHotkey(StaticString("General"), StaticString("ToggleGPUDumping"), StaticString("Toggle GPU Command Dumping"),
+                 [this](bool pressed) {
+                   if (pressed || !m_system)
+                     return;
+
+                   if (!IsDumpingGPU())
+                     StartDumpingGPU();
+                   else
+                     StopDumpingGPU();
+                 });
 }
 
 void CommonHostInterface::RegisterGraphicsHotkeys()